@@ -2,8 +2,35 @@
 
 #include "stdafx.h"
 
-template <class Refs, typename Traits>
-class FaceBase : public CGAL::HalfedgeDS_face_base<Refs, CGAL::Tag_true>
+//the data of a face which only the mapping code uses, see VertexMappingFields
+template<typename Traits>
+struct FaceMappingFields
+{
+	typedef typename Traits::Kernel::Vector_3 Vector_3;
+
+	FaceMappingFields() :
+	mGrad_u(0.0, 0.0, 0.0),
+	mGrad_v(0.0, 0.0, 0.0),
+	mPrescribedMu(0.0, 0.0),
+	m_e1(0.0, 0.0),
+	m_e2(0.0, 0.0),
+	m_e3(0.0, 0.0),
+	mUser(0.0),
+	mUserComplex(0.0, 0.0)
+	{
+	}
+
+	Vector_3 mGrad_u, mGrad_v;
+	std::complex<double> mPrescribedMu;
+	std::complex<double> m_e1, m_e2, m_e3;
+	double mUser; //for debugging, checking and temporary computations
+	std::complex<double> mUserComplex; //for debugging, checking and temporary computations
+};
+
+
+//Fields is FaceMappingFields or NoMappingFields. the accessors of the optional data compile only with FaceMappingFields
+template <class Refs, typename Traits, class Fields = FaceMappingFields<Traits> >
+class FaceBase : public CGAL::HalfedgeDS_face_base<Refs, CGAL::Tag_true>, public Fields
 {
 	typedef typename Traits::Kernel::Vector_3 Vector_3;
 	typedef typename Traits::Kernel::Point_3 Point_3;
@@ -30,8 +57,8 @@ public:
 	Vector_3& grad_u();
 	Vector_3& grad_v();
 	Vector_3 normal() const;
-	typename FaceBase<Refs, Traits>::FACE_STATE state() const;
-	typename FaceBase<Refs, Traits>::FACE_STATE& state();
+	typename FaceBase<Refs, Traits, Fields>::FACE_STATE state() const;
+	typename FaceBase<Refs, Traits, Fields>::FACE_STATE& state();
 	const std::complex<double>& prescribedMu() const;
 	std::complex<double>& prescribedMu();
 	const std::complex<double>& userComplex() const;
@@ -63,27 +90,14 @@ private:
 	int mLocalIndex;
 	int mIndex;
 	FACE_STATE mState;
-	Vector_3 mGrad_u, mGrad_v;
-	std::complex<double> mPrescribedMu;
-	std::complex<double> m_e1, m_e2, m_e3;
-	double mUser; //for debugging, checking and temporary computations
-	std::complex<double> mUserComplex; //for debugging, checking and temporary computations
 };
 
 
 
 
-template <class Refs, typename Traits>
-FaceBase<Refs, Traits>::FaceBase() :
+template <class Refs, typename Traits, class Fields>
+FaceBase<Refs, Traits, Fields>::FaceBase() :
 mIndex(-1),
-mGrad_u(0.0, 0.0, 0.0),
-mGrad_v(0.0, 0.0, 0.0),
-mPrescribedMu(0.0, 0.0),
-m_e1(0.0, 0.0),
-m_e2(0.0, 0.0),
-m_e3(0.0, 0.0),
-mUser(0.0),
-mUserComplex(0.0, 0.0),
 mState(FREE_FACE),
 mLocalIndex(-1)
 {
@@ -91,117 +105,117 @@ mLocalIndex(-1)
 
 
 
-template<class Refs, typename Traits>
-int& FaceBase<Refs, Traits>::index()
+template <class Refs, typename Traits, class Fields>
+int& FaceBase<Refs, Traits, Fields>::index()
 {
 	return mIndex;
 }
 
 
 
-template<class Refs, typename Traits>
-int FaceBase<Refs, Traits>::index() const
+template <class Refs, typename Traits, class Fields>
+int FaceBase<Refs, Traits, Fields>::index() const
 {
 	return mIndex;
 }
 
-template<class Refs, typename Traits>
-int& FaceBase<Refs, Traits>::localIndex()
+template <class Refs, typename Traits, class Fields>
+int& FaceBase<Refs, Traits, Fields>::localIndex()
 {
 	return mLocalIndex;
 }
 
 
-template<class Refs, typename Traits>
-int FaceBase<Refs, Traits>::localIndex() const
+template <class Refs, typename Traits, class Fields>
+int FaceBase<Refs, Traits, Fields>::localIndex() const
 {
 	return mLocalIndex;
 }
 
 
-template<class Refs, typename Traits>
-typename FaceBase<Refs, Traits>::FACE_STATE FaceBase<Refs, Traits>::state() const
+template <class Refs, typename Traits, class Fields>
+typename FaceBase<Refs, Traits, Fields>::FACE_STATE FaceBase<Refs, Traits, Fields>::state() const
 {
 	return mState;
 }
 
-template<class Refs, typename Traits>
-typename FaceBase<Refs, Traits>::FACE_STATE& FaceBase<Refs, Traits>::state()
+template <class Refs, typename Traits, class Fields>
+typename FaceBase<Refs, Traits, Fields>::FACE_STATE& FaceBase<Refs, Traits, Fields>::state()
 {
 	return mState;
 }
 
 
-template <class Refs, typename Traits>
-const std::complex<double>& FaceBase<Refs, Traits>::e1() const
+template <class Refs, typename Traits, class Fields>
+const std::complex<double>& FaceBase<Refs, Traits, Fields>::e1() const
 {
-	return m_e1;
+	return this->m_e1;
 }
 
 
-template <class Refs, typename Traits>
-const std::complex<double>& FaceBase<Refs, Traits>::e2() const
+template <class Refs, typename Traits, class Fields>
+const std::complex<double>& FaceBase<Refs, Traits, Fields>::e2() const
 {
-	return m_e2;
+	return this->m_e2;
 }
 
 
-template <class Refs, typename Traits>
-const std::complex<double>& FaceBase<Refs, Traits>::e3() const
+template <class Refs, typename Traits, class Fields>
+const std::complex<double>& FaceBase<Refs, Traits, Fields>::e3() const
 {
-	return m_e3;
+	return this->m_e3;
 }
 
 
 
 
-template <class Refs, typename Traits>
-std::complex<double>& FaceBase<Refs, Traits>::prescribedMu()
+template <class Refs, typename Traits, class Fields>
+std::complex<double>& FaceBase<Refs, Traits, Fields>::prescribedMu()
 {
-	return mPrescribedMu;
+	return this->mPrescribedMu;
 }
 
 
 
-template <class Refs, typename Traits>
-const std::complex<double>& FaceBase<Refs, Traits>::prescribedMu() const
+template <class Refs, typename Traits, class Fields>
+const std::complex<double>& FaceBase<Refs, Traits, Fields>::prescribedMu() const
 {
-	return mPrescribedMu;
+	return this->mPrescribedMu;
 }
 
 
-template <class Refs, typename Traits>
-std::complex<double>& FaceBase<Refs, Traits>::userComplex()
+template <class Refs, typename Traits, class Fields>
+std::complex<double>& FaceBase<Refs, Traits, Fields>::userComplex()
 {
-	return mUserComplex;
+	return this->mUserComplex;
 }
 
 
 
-template <class Refs, typename Traits>
-const std::complex<double>& FaceBase<Refs, Traits>::userComplex() const
+template <class Refs, typename Traits, class Fields>
+const std::complex<double>& FaceBase<Refs, Traits, Fields>::userComplex() const
 {
-	return mUserComplex;
+	return this->mUserComplex;
 }
 
 
-template <class Refs, typename Traits>
-double& FaceBase<Refs, Traits>::user()
+template <class Refs, typename Traits, class Fields>
+double& FaceBase<Refs, Traits, Fields>::user()
 {
-	return mUser;
+	return this->mUser;
 }
 
 
 
-template <class Refs, typename Traits>
-const double& FaceBase<Refs, Traits>::user() const
+template <class Refs, typename Traits, class Fields>
+const double& FaceBase<Refs, Traits, Fields>::user() const
 {
-	return mUser;
+	return this->mUser;
 }
 
 
-template <class Refs, typename Traits>
-typename Traits::Kernel::Vector_3 FaceBase<Refs, Traits>::normal() const
+template <class Refs, typename Traits, class Fields>
+typename Traits::Kernel::Vector_3 FaceBase<Refs, Traits, Fields>::normal() const
 {
 	Point_3 p[3];
 	getPoints(p);
@@ -218,8 +232,8 @@ typename Traits::Kernel::Vector_3 FaceBase<Refs, Traits>::normal() const
 
 
 //returns the unsigned area. Assumes that the polygon is simple and planar
-template <class Refs, typename Traits>
-double FaceBase<Refs, Traits>::doubleArea() const
+template <class Refs, typename Traits, class Fields>
+double FaceBase<Refs, Traits, Fields>::doubleArea() const
 {
 	Point_3 p[3];
 	getPoints(p);
@@ -275,15 +289,15 @@ double FaceBase<Refs, Traits>::doubleArea() const
 }
 
 
-template <class Refs, typename Traits>
-double FaceBase<Refs, Traits>::area() const
+template <class Refs, typename Traits, class Fields>
+double FaceBase<Refs, Traits, Fields>::area() const
 {
 	return 0.5*doubleArea();
 }
 
 
-template <class Refs, typename Traits>
-double FaceBase<Refs, Traits>::doubleUVArea() const
+template <class Refs, typename Traits, class Fields>
+double FaceBase<Refs, Traits, Fields>::doubleUVArea() const
 {
 	assert(halfedge()->is_triangle());
 
@@ -299,40 +313,40 @@ double FaceBase<Refs, Traits>::doubleUVArea() const
 	return sqrt(cross.squared_length());
 }
 
-template <class Refs, typename Traits>
-double FaceBase<Refs, Traits>::uvArea() const
+template <class Refs, typename Traits, class Fields>
+double FaceBase<Refs, Traits, Fields>::uvArea() const
 {
 	return 0.5*doubleUVArea();
 }
 
 
-template <class Refs, typename Traits>
-typename Traits::Kernel::Vector_3 FaceBase<Refs, Traits>::grad_u() const
+template <class Refs, typename Traits, class Fields>
+typename Traits::Kernel::Vector_3 FaceBase<Refs, Traits, Fields>::grad_u() const
 {
-	return mGrad_u;
+	return this->mGrad_u;
 }
 
-template <class Refs, typename Traits>
-typename Traits::Kernel::Vector_3 FaceBase<Refs, Traits>::grad_v() const
+template <class Refs, typename Traits, class Fields>
+typename Traits::Kernel::Vector_3 FaceBase<Refs, Traits, Fields>::grad_v() const
 {
-	return mGrad_v;
+	return this->mGrad_v;
 }
 
-template <class Refs, typename Traits>
-typename Traits::Kernel::Vector_3& FaceBase<Refs, Traits>::grad_u()
+template <class Refs, typename Traits, class Fields>
+typename Traits::Kernel::Vector_3& FaceBase<Refs, Traits, Fields>::grad_u()
 {
-	return mGrad_u;
+	return this->mGrad_u;
 }
 
-template <class Refs, typename Traits>
-typename Traits::Kernel::Vector_3& FaceBase<Refs, Traits>::grad_v()
+template <class Refs, typename Traits, class Fields>
+typename Traits::Kernel::Vector_3& FaceBase<Refs, Traits, Fields>::grad_v()
 {
-	return mGrad_v;
+	return this->mGrad_v;
 }
 
 
-template <class Refs, typename Traits>
-bool FaceBase<Refs, Traits>::is_border() const
+template <class Refs, typename Traits, class Fields>
+bool FaceBase<Refs, Traits, Fields>::is_border() const
 {
 	Halfedge_const_handle h1 = halfedge();
 	Halfedge_const_handle h2 = h1->next();
@@ -349,8 +363,8 @@ bool FaceBase<Refs, Traits>::is_border() const
 }
 
 
-template <class Refs, typename Traits>
-bool FaceBase<Refs, Traits>::is_border_face() const
+template <class Refs, typename Traits, class Fields>
+bool FaceBase<Refs, Traits, Fields>::is_border_face() const
 {
 	Halfedge_const_handle h1 = halfedge();
 	Halfedge_const_handle h2 = h1->next();
@@ -367,8 +381,8 @@ bool FaceBase<Refs, Traits>::is_border_face() const
 }
 
 
-template <class Refs, typename Traits>
-void FaceBase<Refs, Traits>::getPoints(Point_3 p[3]) const
+template <class Refs, typename Traits, class Fields>
+void FaceBase<Refs, Traits, Fields>::getPoints(Point_3 p[3]) const
 {
 	Halfedge_const_handle h = halfedge();
 	p[0] = h->opposite()->vertex()->point();
@@ -376,8 +390,8 @@ void FaceBase<Refs, Traits>::getPoints(Point_3 p[3]) const
 	p[2] = h->next()->vertex()->point();
 }
 
-template <class Refs, typename Traits>
-void FaceBase<Refs, Traits>::getVertices(Vertex_handle v[3])
+template <class Refs, typename Traits, class Fields>
+void FaceBase<Refs, Traits, Fields>::getVertices(Vertex_handle v[3])
 {
 	Halfedge_handle h = halfedge();
 	v[0] = h->opposite()->vertex();
@@ -385,8 +399,8 @@ void FaceBase<Refs, Traits>::getVertices(Vertex_handle v[3])
 	v[2] = h->next()->vertex();
 }
 
-template <class Refs, typename Traits>
-void FaceBase<Refs, Traits>::getVertices(Vertex_const_handle v[3]) const
+template <class Refs, typename Traits, class Fields>
+void FaceBase<Refs, Traits, Fields>::getVertices(Vertex_const_handle v[3]) const
 {
 	Halfedge_const_handle h = halfedge();
 	v[0] = h->opposite()->vertex();
@@ -395,8 +409,8 @@ void FaceBase<Refs, Traits>::getVertices(Vertex_const_handle v[3]) const
 }
 
 
-template <class Refs, typename Traits>
-void FaceBase<Refs, Traits>::getHalfedges(Halfedge_handle h[3])
+template <class Refs, typename Traits, class Fields>
+void FaceBase<Refs, Traits, Fields>::getHalfedges(Halfedge_handle h[3])
 {
 	h[0] = halfedge();
 	h[1] = h[0]->next();
@@ -404,8 +418,8 @@ void FaceBase<Refs, Traits>::getHalfedges(Halfedge_handle h[3])
 }
 
 //checks if the target metric satisfies the triangle inequality
-template <class Refs, typename Traits>
-bool FaceBase<Refs, Traits>::hasValidMetric() const
+template <class Refs, typename Traits, class Fields>
+bool FaceBase<Refs, Traits, Fields>::hasValidMetric() const
 {
 	double a = halfedge()->targetMetric();
 	double b = halfedge()->opposite()->targetMetric();
@@ -427,8 +441,8 @@ bool FaceBase<Refs, Traits>::hasValidMetric() const
 //
 //note that this function doesn't update the local variables m_e1, m_e2, m_e3.
 //for computing and updating the variables use updateHalfedgesInLocalCoords instead
-template <class Refs, typename Traits>
-bool FaceBase<Refs, Traits>::computeHalfedgesInLocalCoords(std::complex<double>& e1, std::complex<double>& e2, std::complex<double>& e3, bool useTargetMetric) const
+template <class Refs, typename Traits, class Fields>
+bool FaceBase<Refs, Traits, Fields>::computeHalfedgesInLocalCoords(std::complex<double>& e1, std::complex<double>& e2, std::complex<double>& e3, bool useTargetMetric) const
 {
 	Halfedge_const_handle h1 = halfedge();
 	Halfedge_const_handle h2 = h1->next();
@@ -478,9 +492,9 @@ bool FaceBase<Refs, Traits>::computeHalfedgesInLocalCoords(std::complex<double>&
 	return true;
 }
 
-template <class Refs, typename Traits>
-void FaceBase<Refs, Traits>::updateHalfedgesInLocalCoords(bool useTargetMetric)
+template <class Refs, typename Traits, class Fields>
+void FaceBase<Refs, Traits, Fields>::updateHalfedgesInLocalCoords(bool useTargetMetric)
 {
-	bool res = computeHalfedgesInLocalCoords(m_e1, m_e2, m_e3, useTargetMetric);
+	bool res = computeHalfedgesInLocalCoords(this->m_e1, this->m_e2, this->m_e3, useTargetMetric);
 	assert(res);
 }
@@ -2,8 +2,23 @@
 
 #include "stdafx.h"
 
-template<class Refs, typename Traits>
-class HalfedgeBase : public CGAL::HalfedgeDS_halfedge_base<Refs, CGAL::Tag_true, CGAL::Tag_true, CGAL::Tag_true>
+//the data of a halfedge which only the mapping code uses, see VertexMappingFields
+template<typename Traits>
+struct HalfedgeMappingFields
+{
+	typedef typename Traits::Kernel::Point_3 Point_3;
+
+	HalfedgeMappingFields() : mUV(0.0, 0.0, 0.0), mNumeric1(0.0), mTargetMetric(0.0) {}
+
+	Point_3 mUV;
+	double mNumeric1; //uninitialized variable used as an auxiliary for external functions
+	double mTargetMetric;
+};
+
+
+//Fields is HalfedgeMappingFields or NoMappingFields. the accessors of the optional data compile only with HalfedgeMappingFields
+template<class Refs, typename Traits, class Fields = HalfedgeMappingFields<Traits> >
+class HalfedgeBase : public CGAL::HalfedgeDS_halfedge_base<Refs, CGAL::Tag_true, CGAL::Tag_true, CGAL::Tag_true>, public Fields
 {
 	typedef typename Traits::Kernel::Vector_3 Vector_3;
 	typedef typename Traits::Kernel::Point_3 Point_3;
@@ -40,35 +55,32 @@ public:
 
 private:
 
-	Point_3 mUV;
 	int mIndex;
 	int mUserIndex;
-	double mNumeric1; //uninitialized variable used as an auxiliary for external functions
-	double mTargetMetric;
 };
 
 
 
-template<class Refs, typename Traits>
-HalfedgeBase<Refs, Traits>::HalfedgeBase() : mUV(0.0, 0.0, 0.0), mIndex(-1), mTargetMetric(0.0), mNumeric1(0.0), mUserIndex(-1)
+template<class Refs, typename Traits, class Fields>
+HalfedgeBase<Refs, Traits, Fields>::HalfedgeBase() : mIndex(-1), mUserIndex(-1)
 {
 
 }
 
-template<class Refs, typename Traits>
-double& HalfedgeBase<Refs, Traits>::numeric1()
+template<class Refs, typename Traits, class Fields>
+double& HalfedgeBase<Refs, Traits, Fields>::numeric1()
 {
-	return mNumeric1;
+	return this->mNumeric1;
 }
 
-template<class Refs, typename Traits>
-double HalfedgeBase<Refs, Traits>::numeric1() const
+template<class Refs, typename Traits, class Fields>
+double HalfedgeBase<Refs, Traits, Fields>::numeric1() const
 {
-	return mNumeric1;
+	return this->mNumeric1;
 }
 
-template<class Refs, typename Traits>
-double HalfedgeBase<Refs, Traits>::scaleFactor() const
+template<class Refs, typename Traits, class Fields>
+double HalfedgeBase<Refs, Traits, Fields>::scaleFactor() const
 {
 	double phi1 = vertex()->conformalFactor();
 	double phi2 = opposite()->vertex()->conformalFactor();
@@ -86,52 +98,52 @@ double HalfedgeBase<Refs, Traits>::scaleFactor() const
 	return scale;
 }
 
-template<class Refs, typename Traits>
-int& HalfedgeBase<Refs, Traits>::index()
+template<class Refs, typename Traits, class Fields>
+int& HalfedgeBase<Refs, Traits, Fields>::index()
 {
 	return mIndex;
 }
 
-template<class Refs, typename Traits>
-int HalfedgeBase<Refs, Traits>::index() const
+template<class Refs, typename Traits, class Fields>
+int HalfedgeBase<Refs, Traits, Fields>::index() const
 {
 	return mIndex;
 }
 
-template<class Refs, typename Traits>
-int& HalfedgeBase<Refs, Traits>::userIndex()
+template<class Refs, typename Traits, class Fields>
+int& HalfedgeBase<Refs, Traits, Fields>::userIndex()
 {
 	return mUserIndex;
 }
 
-template<class Refs, typename Traits>
-int HalfedgeBase<Refs, Traits>::userIndex() const
+template<class Refs, typename Traits, class Fields>
+int HalfedgeBase<Refs, Traits, Fields>::userIndex() const
 {
 	return mUserIndex;
 }
 
-template<class Refs, typename Traits>
-typename Traits::Kernel::Point_3& HalfedgeBase<Refs, Traits>::uv()
+template<class Refs, typename Traits, class Fields>
+typename Traits::Kernel::Point_3& HalfedgeBase<Refs, Traits, Fields>::uv()
 {
-	return mUV;
+	return this->mUV;
 }
 
-template<class Refs, typename Traits>
-const typename Traits::Kernel::Point_3& HalfedgeBase<Refs, Traits>::uv() const
+template<class Refs, typename Traits, class Fields>
+const typename Traits::Kernel::Point_3& HalfedgeBase<Refs, Traits, Fields>::uv() const
 {
-	return mUV;
+	return this->mUV;
 }
 
 
-template<class Refs, typename Traits>
-bool HalfedgeBase<Refs, Traits>::is_border_edge() const
+template<class Refs, typename Traits, class Fields>
+bool HalfedgeBase<Refs, Traits, Fields>::is_border_edge() const
 {
 	return this->is_border() || this->opposite()->is_border();
 }
 
 //this function computes the two parts of the weight
-template<class Refs, typename Traits>
-double HalfedgeBase<Refs, Traits>::meanValueWeight(bool useTargetMetric = false) const
+template<class Refs, typename Traits, class Fields>
+double HalfedgeBase<Refs, Traits, Fields>::meanValueWeight(bool useTargetMetric = false) const
 {
 	assert(face()->is_triangle()); //making sure we don't have an n-gon or border edge
 	assert(!is_border_edge());
@@ -140,7 +152,7 @@ double HalfedgeBase<Refs, Traits>::meanValueWeight(bool useTargetMetric = false)
 	{
 		double a = next()->mTargetMetric;
 		double b = prev()->mTargetMetric;
-		double c = mTargetMetric;
+		double c = this->mTargetMetric;
 		double d = opposite()->prev()->mTargetMetric;
 		double e = opposite()->next()->mTargetMetric;
 		assert(a > 0.0 && b > 0.0 && c > 0.0 && d > 0.0 && e > 0.0);
@@ -231,8 +243,8 @@ double HalfedgeBase<Refs, Traits>::meanValueWeight(bool useTargetMetric = false)
 
 
 //this function computes only the part of the weight that belongs to the specific halfedge
-template<class Refs, typename Traits>
-double HalfedgeBase<Refs, Traits>::cot(bool useTargetMetric) const
+template<class Refs, typename Traits, class Fields>
+double HalfedgeBase<Refs, Traits, Fields>::cot(bool useTargetMetric) const
 {
 	if(is_border())
 	{
@@ -243,7 +255,7 @@ double HalfedgeBase<Refs, Traits>::cot(bool useTargetMetric) const
 	{
 		double a = next()->mTargetMetric;
 		double b = prev()->mTargetMetric;
-		double c = mTargetMetric;
+		double c = this->mTargetMetric;
 		assert(a > 0.0 && b > 0.0 && c > 0.0);
 
 		double nominator = a*a + b*b - c*c;
@@ -287,8 +299,8 @@ double HalfedgeBase<Refs, Traits>::cot(bool useTargetMetric) const
 
 //this function computes only the part of the weight that belongs to the specific halfedge.
 //the computation of the cotangent is based on the uv domain which is treated here as a 3D mesh (embedded in 2D).
-template<class Refs, typename Traits>
-double HalfedgeBase<Refs, Traits>::uvCot() const
+template<class Refs, typename Traits, class Fields>
+double HalfedgeBase<Refs, Traits, Fields>::uvCot() const
 {
 	if(is_border())
 	{
@@ -315,22 +327,22 @@ double HalfedgeBase<Refs, Traits>::uvCot() const
 }
 
 
-template<class Refs, typename Traits>
-double HalfedgeBase<Refs, Traits>::squared_length() const
+template<class Refs, typename Traits, class Fields>
+double HalfedgeBase<Refs, Traits, Fields>::squared_length() const
 {
 	return (vertex()->point() - opposite()->vertex()->point()).squared_length();
 }
 
 
-template<class Refs, typename Traits>
-double HalfedgeBase<Refs, Traits>::length() const
+template<class Refs, typename Traits, class Fields>
+double HalfedgeBase<Refs, Traits, Fields>::length() const
 {
 	return sqrt(squared_length());
 }
 
 
-template<class Refs, typename Traits>
-double HalfedgeBase<Refs, Traits>::uvLength() const
+template<class Refs, typename Traits, class Fields>
+double HalfedgeBase<Refs, Traits, Fields>::uvLength() const
 {
 	return sqrt((vertex()->uv() - opposite()->vertex()->uv()).squared_length());
 }
@@ -340,8 +352,8 @@ double HalfedgeBase<Refs, Traits>::uvLength() const
 
 //computes the angle that the halfedge points to
 //returns a number in the range 0..PI
-template<class Refs, typename Traits>
-double HalfedgeBase<Refs, Traits>::angle() const
+template<class Refs, typename Traits, class Fields>
+double HalfedgeBase<Refs, Traits, Fields>::angle() const
 {
 	if(is_border())
 	{
@@ -364,8 +376,8 @@ double HalfedgeBase<Refs, Traits>::angle() const
 
 //computes the angle that the halfedge points to, based on the uv layout
 //returns a number in the range 0..PI
-template<class Refs, typename Traits>
-double HalfedgeBase<Refs, Traits>::uvAngle() const
+template<class Refs, typename Traits, class Fields>
+double HalfedgeBase<Refs, Traits, Fields>::uvAngle() const
 {
 	if(is_border())
 	{
@@ -392,23 +404,23 @@ double HalfedgeBase<Refs, Traits>::uvAngle() const
 
 
 
-template<class Refs, typename Traits>
-double HalfedgeBase<Refs, Traits>::targetMetric() const
+template<class Refs, typename Traits, class Fields>
+double HalfedgeBase<Refs, Traits, Fields>::targetMetric() const
 {
-	return mTargetMetric;
+	return this->mTargetMetric;
 }
 
-template<class Refs, typename Traits>
-double& HalfedgeBase<Refs, Traits>::targetMetric()
+template<class Refs, typename Traits, class Fields>
+double& HalfedgeBase<Refs, Traits, Fields>::targetMetric()
 {
-	return mTargetMetric;
+	return this->mTargetMetric;
 }
 
 
 //computes the angle that the halfedge points to by using the target metric (assigned edgeLength)
 //returns a number in the range 0..PI
-template<class Refs, typename Traits>
-double HalfedgeBase<Refs, Traits>::angleFromTargetMetric() const
+template<class Refs, typename Traits, class Fields>
+double HalfedgeBase<Refs, Traits, Fields>::angleFromTargetMetric() const
 {
 	if(is_border())
 	{
@@ -416,7 +428,7 @@ double HalfedgeBase<Refs, Traits>::angleFromTargetMetric() const
 	}
 
 	double a = next()->mTargetMetric;
-	double b = mTargetMetric;
+	double b = this->mTargetMetric;
 	double c = prev()->mTargetMetric;
 
 	assert(a > 0.0);
@@ -440,8 +452,8 @@ double HalfedgeBase<Refs, Traits>::angleFromTargetMetric() const
 
 //a separating edge is an edge that has two vertices on the border but the edge itself is not a border edge.
 //for meshes with disk topology, the existence of such an edge indicates that the underlying graph is not three-connected
-template<class Refs, typename Traits>
-bool HalfedgeBase<Refs, Traits>::is_separating_edge() const
+template<class Refs, typename Traits, class Fields>
+bool HalfedgeBase<Refs, Traits, Fields>::is_separating_edge() const
 {
 	bool borderEdge = this->is_border_edge();
 
@@ -458,8 +470,8 @@ bool HalfedgeBase<Refs, Traits>::is_separating_edge() const
 //for triangle meshes an halfedge uniquely defines a vertex-triangle pair.
 //this function computes the part of the mixed cell area (combination of Voronoi and barycentric area) that belongs to the vertex-triangle pair.
 //based on the Caltech paper: "Discrete Differential-Geometry Operators for Triangulated 2-Manifolds". See Fig 4 and Section 3.3.
-template<class Refs, typename Traits>
-double HalfedgeBase<Refs, Traits>::mixedCellArea(bool useTargetMetric = false) const
+template<class Refs, typename Traits, class Fields>
+double HalfedgeBase<Refs, Traits, Fields>::mixedCellArea(bool useTargetMetric = false) const
 {
 	assert(face()->is_triangle()); //making sure we don't have an n-gon
 	assert(!is_border()); //border halfedges belong to the outer face and are not associated with a vertex-triangle pair.
@@ -468,7 +480,7 @@ double HalfedgeBase<Refs, Traits>::mixedCellArea(bool useTargetMetric = false) c
 
 	if(useTargetMetric) //compute the area from the prescribed edge lengths
 	{
-		double a = mTargetMetric;
+		double a = this->mTargetMetric;
 		double b = next()->mTargetMetric;
 		double c = prev()->mTargetMetric;
 
@@ -518,8 +530,8 @@ double HalfedgeBase<Refs, Traits>::mixedCellArea(bool useTargetMetric = false) c
 //this function computes the part of the mixed cell area (combination of Voronoi and barycentric area) that belongs to the vertex-triangle pair.
 //based on the Caltech paper: "Discrete Differential-Geometry Operators for Triangulated 2-Manifolds". See Fig 4 and Section 3.3.
 //all computations are based on the uv domain which is treated as a mesh. the 3d embedding is ignored.
-template<class Refs, typename Traits>
-double HalfedgeBase<Refs, Traits>::uvMixedCellArea() const
+template<class Refs, typename Traits, class Fields>
+double HalfedgeBase<Refs, Traits, Fields>::uvMixedCellArea() const
 {
 	assert(face()->is_triangle()); //making sure we don't have an n-gon
 	assert(!is_border()); //border halfedges belong to the outer face and are not associated with a vertex-triangle pair.
@@ -555,8 +567,8 @@ double HalfedgeBase<Refs, Traits>::uvMixedCellArea() const
 
 
 //a utility function to compute triangle area from edge lengths based on Heron's formula.
-template<class Refs, typename Traits>
-double HalfedgeBase<Refs, Traits>::triangleAreaFromEdgeLengths(double a, double b, double c) const
+template<class Refs, typename Traits, class Fields>
+double HalfedgeBase<Refs, Traits, Fields>::triangleAreaFromEdgeLengths(double a, double b, double c) const
 {
 	double s = 0.5*(a + b + c); //s is half the triangle's perimeter
 
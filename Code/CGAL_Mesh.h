@@ -701,6 +701,11 @@ protected:
 
 	MeshBuilder(){}; //shouldn't be used
 
+	//lays out the halfedges of a triangle list directly: the twins are paired with a hash on the undirected edges and
+	//the border halfedges are put at the end, as normalize_border wants them. returns false, without changing hds,
+	//if hds is not empty or the triangles are not an oriented manifold; operator() uses the incremental builder then.
+	bool buildTriangles(H& hds);
+
 protected:
 
 	const std::vector<Point_3>* mVertices;
@@ -739,6 +744,11 @@ void MeshBuilder<H, K>::operator()(H& hds)
 		return;
 	}
 
+	if(mVertexCount == NULL && buildTriangles(hds))
+	{
+		return;
+	}
+
 	CGAL::Polyhedron_incremental_builder_3<H> builder(hds, true);
 
 	builder.begin_surface(numVertices, numFaces);
@@ -778,6 +788,141 @@ void MeshBuilder<H, K>::operator()(H& hds)
 }
 
 
+template<class H, class K>
+bool MeshBuilder<H, K>::buildTriangles(H& hds)
+{
+	typedef typename H::Halfedge_handle Halfedge_handle;
+	typedef typename H::Face_handle Face_handle;
+	typedef typename H::Halfedge::Base HBase;
+
+	const std::vector<int>& faces = *mFaceIndices;
+	int numVertices = mVertices->size();
+	int numFaceHalfedges = faces.size();
+	if(hds.size_of_halfedges() != 0)
+	{
+		return false;
+	}
+
+	//halfedge i goes from faces[i] to faces[nextOf(i)]. the border halfedges follow the face halfedges.
+	std::vector<int> next(numFaceHalfedges), twin(numFaceHalfedges, -1), target(numFaceHalfedges);
+	std::unordered_map<unsigned long long, int> edges; //undirected edge -> the first halfedge on it
+	edges.reserve(2 * numFaceHalfedges);
+	for(int i = 0; i < numFaceHalfedges; i++)
+	{
+		next[i] = 3 * (i / 3) + (i + 1) % 3;
+		int a = faces[i];
+		int b = target[i] = faces[next[i]];
+		if(a < 0 || a >= numVertices || b < 0 || b >= numVertices || a == b)
+		{
+			return false;
+		}
+		unsigned long long key = (unsigned long long)(std::min)(a, b) * numVertices + (std::max)(a, b);
+		std::pair<std::unordered_map<unsigned long long, int>::iterator, bool> inserted = edges.insert(std::make_pair(key, i));
+		if(!inserted.second)
+		{
+			int g = inserted.first->second;
+			if(twin[g] != -1 || faces[g] == a) //a third face on the edge, or two faces with the same orientation
+			{
+				return false;
+			}
+			twin[g] = i;
+			twin[i] = g;
+		}
+	}
+
+	//the border halfedge of i goes back along i. it leaves target[i], and its next is the border halfedge which leaves faces[i].
+	std::vector<int> borderOut(numVertices, -1);
+	for(int i = 0; i < numFaceHalfedges; i++)
+	{
+		if(twin[i] != -1)
+		{
+			continue;
+		}
+		if(borderOut[target[i]] != -1) //two border loops meet at the vertex
+		{
+			return false;
+		}
+		borderOut[target[i]] = twin[i] = next.size();
+		next.push_back(-1);
+		twin.push_back(i);
+		target.push_back(faces[i]);
+	}
+	int numHalfedges = next.size();
+	for(int h = numFaceHalfedges; h < numHalfedges; h++)
+	{
+		next[h] = borderOut[target[h]];
+	}
+
+	//every vertex must have a single fan of halfedges around it
+	std::vector<int> numIncoming(numVertices, 0), start(numVertices, -1);
+	for(int h = 0; h < numHalfedges; h++)
+	{
+		numIncoming[target[h]]++;
+		start[target[h]] = h;
+	}
+	for(int v = 0; v < numVertices; v++)
+	{
+		if(start[v] == -1)
+		{
+			continue;
+		}
+		int count = 0;
+		int h = start[v];
+		do
+		{
+			count++;
+			h = twin[next[h]];
+		} while(h != start[v] && count <= numIncoming[v]);
+		if(count != numIncoming[v])
+		{
+			return false;
+		}
+	}
+
+	//the interior edges in the order they were met, then the border edges with their face halfedge first
+	hds.reserve(numVertices, numHalfedges, numFaceHalfedges / 3);
+	std::vector<Vertex_handle> vertices(numVertices);
+	for(int v = 0; v < numVertices; v++)
+	{
+		vertices[v] = hds.vertices_push_back(typename H::Vertex((*mVertices)[v]));
+	}
+	std::vector<Face_handle> facets(numFaceHalfedges / 3);
+	for(int f = 0; f < (int)facets.size(); f++)
+	{
+		facets[f] = hds.faces_push_back(typename H::Face());
+	}
+	std::vector<Halfedge_handle> halfedges(numHalfedges);
+	for(int pass = 0; pass < 2; pass++)
+	{
+		for(int i = 0; i < numFaceHalfedges; i++)
+		{
+			bool isBorderEdge = (twin[i] >= numFaceHalfedges);
+			if((pass == 0 && !isBorderEdge && twin[i] > i) || (pass == 1 && isBorderEdge))
+			{
+				halfedges[i] = hds.edges_push_back(typename H::Halfedge(), typename H::Halfedge());
+				halfedges[twin[i]] = halfedges[i]->opposite();
+			}
+		}
+	}
+
+	CGAL::HalfedgeDS_decorator<H> decorator(hds);
+	for(int h = 0; h < numHalfedges; h++)
+	{
+		halfedges[h]->HBase::set_next(halfedges[next[h]]);
+		decorator.set_prev(halfedges[next[h]], halfedges[h]);
+		decorator.set_vertex(halfedges[h], vertices[target[h]]);
+		decorator.set_face(halfedges[h], (h < numFaceHalfedges) ? facets[h / 3] : Face_handle());
+		decorator.set_vertex_halfedge(vertices[target[h]], halfedges[h]);
+	}
+	for(int f = 0; f < (int)facets.size(); f++)
+	{
+		decorator.set_face_halfedge(facets[f], halfedges[3 * f]);
+	}
+	hds.normalize_border(); //only counts the border, which is already at the end
+	return true;
+}
+
+
 
 struct PolyhedronItems : public CGAL::Polyhedron_items_3
 {
@@ -801,13 +946,38 @@ struct PolyhedronItems : public CGAL::Polyhedron_items_3
 };
 
 
+//the items without the data of the conformal mapping code (see VertexMappingFields), about half the size.
+//this is what the composition pipeline uses.
+struct SlimPolyhedronItems : public CGAL::Polyhedron_items_3
+{
+	template<class Refs, typename Traits>
+	struct Vertex_wrapper
+	{
+		typedef Vertex_Base<Refs, Traits, NoMappingFields> Vertex;
+	};
+
+	template<class Refs, typename Traits>
+	struct Halfedge_wrapper
+	{
+		typedef HalfedgeBase<Refs, Traits, NoMappingFields> Halfedge;
+	};
+
+	template<class Refs, typename Traits>
+	struct Face_wrapper
+	{
+		typedef FaceBase<Refs, Traits, NoMappingFields> Face;
+	};
+};
+
+
 
 
 
 // CGAL_Mesh typedef
 
 //typedef CGAL::Exact_predicates_exact_constructions_kernel ExactKernel;
-typedef Polyhedron<CGAL::Simple_cartesian<double>, PolyhedronItems> Mesh;
+typedef Polyhedron<CGAL::Simple_cartesian<double>, SlimPolyhedronItems> Mesh;
+typedef Polyhedron<CGAL::Simple_cartesian<double>, PolyhedronItems> MappingMesh; //with the data of the conformal mapping code
 //typedef Polyhedron<ExactKernel, PolyhedronItems> MeshExact;
 
 
@@ -3,8 +3,52 @@
 #include "stdafx.h"
 
 
-template<class Refs, typename Traits>
-class Vertex_Base : public CGAL::HalfedgeDS_vertex_base<Refs, CGAL::Tag_true, typename Traits::Kernel::Point_3>
+//the data of a vertex which only the conformal and quasi conformal mapping code uses (not the composition pipeline).
+//it is a base class of the vertex, so a vertex with NoMappingFields (see SlimPolyhedronItems) does not store it.
+template<typename Traits>
+struct VertexMappingFields
+{
+	typedef typename Traits::Kernel::Vector_3 Vector_3;
+
+	VertexMappingFields() :
+	mXLocalIndex(-1),
+		mYLocalIndex(-1),
+		mIsXfree(true),
+		mIsYfree(true),
+		mStretchDirOnUnitSphere(0.0, 0.0, 0.0),
+		mStretchDirOnExtendedPlane(0.0, 0.0),
+		mStretchDirOnUnitDisk(0.0, 0.0),
+		mConformalFactor(0.0),
+		mPrescribedGaussianCurvature(0.0),
+		mPhiMetricGaussianCurvature(0.0),
+		mQuadraticDifferential(0.0, 0.0),
+		mProjectedPoint(0.0, 0.0)
+	{
+	}
+
+	int mXLocalIndex;
+	int mYLocalIndex;
+	bool mIsXfree; //is the x component of the vertex free
+	bool mIsYfree; //is the y component of the vertex free
+	Vector_3 mStretchDirOnUnitSphere;
+	std::complex<double> mStretchDirOnExtendedPlane;
+	std::complex<double> mStretchDirOnUnitDisk;
+	double mConformalFactor;
+	double mPrescribedGaussianCurvature;
+	double mPhiMetricGaussianCurvature;
+	std::complex<double> mQuadraticDifferential;
+	std::complex<double> mProjectedPoint;
+};
+
+//no optional data, for the vertices, halfedges and faces of SlimPolyhedronItems
+struct NoMappingFields
+{
+};
+
+
+//Fields is VertexMappingFields or NoMappingFields. the accessors of the optional data compile only with VertexMappingFields
+template<class Refs, typename Traits, class Fields = VertexMappingFields<Traits> >
+class Vertex_Base : public CGAL::HalfedgeDS_vertex_base<Refs, CGAL::Tag_true, typename Traits::Kernel::Point_3>, public Fields
 {
 	typedef typename Traits::Kernel::Vector_3 Vector_3;
 	typedef typename Traits::Kernel::Point_3 Point_3;
@@ -75,22 +119,10 @@ private:
 	//all the free vertices are numbered from 0 to numFreeVertices - 1
 	//and all the fixed vertices are numbered from 0 to numFixedVertices - 1
 	int mLocalIndex;
-	int mXLocalIndex;
-	int mYLocalIndex;
 	int mUserIndex;
 	int mFullRotationIndex;
 	bool mIsFree; //is the whole vertex free
-	bool mIsXfree; //is the x component of the vertex free
-	bool mIsYfree; //is the y component of the vertex free
 	Point_3 mUV;
-	Vector_3 mStretchDirOnUnitSphere;
-	std::complex<double> mStretchDirOnExtendedPlane;
-	std::complex<double> mStretchDirOnUnitDisk;
-	double mConformalFactor;
-	double mPrescribedGaussianCurvature;
-	double mPhiMetricGaussianCurvature;
-	std::complex<double> mQuadraticDifferential;
-	std::complex<double> mProjectedPoint;
 };
 
 
@@ -99,175 +131,139 @@ private:
 
 
 
-template<class Refs, typename Traits>
-Vertex_Base<Refs, Traits>::Vertex_Base() :
+template<class Refs, typename Traits, class Fields>
+Vertex_Base<Refs, Traits, Fields>::Vertex_Base() :
 mIndex(-1),
 	mLocalIndex(-1),
-	mXLocalIndex(-1),
-	mYLocalIndex(-1),
 	mUserIndex(-1),
 	mFullRotationIndex(0),
 	mIsFree(true),
-	mIsXfree(true),
-	mIsYfree(true),
-	mConformalFactor(0.0),
-	mPrescribedGaussianCurvature(0.0),
-	mPhiMetricGaussianCurvature(0.0),
-	mUV(0.0, 0.0, 0.0),
-	mQuadraticDifferential(0.0, 0.0),
-	mProjectedPoint(0.0, 0.0),
-	mStretchDirOnUnitSphere(0.0, 0.0, 0.0),
-	mStretchDirOnExtendedPlane(0.0, 0.0),
-	mStretchDirOnUnitDisk(0.0, 0.0)
+	mUV(0.0, 0.0, 0.0)
 {
 }
 
 
-template<class Refs, typename Traits>
-Vertex_Base<Refs, Traits>::Vertex_Base(const Vertex_Base& v) :
+template<class Refs, typename Traits, class Fields>
+Vertex_Base<Refs, Traits, Fields>::Vertex_Base(const Vertex_Base& v) :
 mIndex(-1),
 	mLocalIndex(-1),
-	mXLocalIndex(-1),
-	mYLocalIndex(-1),
 	mUserIndex(-1),
 	mFullRotationIndex(0),
 	mIsFree(true),
-	mIsXfree(true),
-	mIsYfree(true),
-	mConformalFactor(0.0),
-	mPrescribedGaussianCurvature(0.0),
-	mPhiMetricGaussianCurvature(0.0),
 	mUV(0.0, 0.0, 0.0),
-	mQuadraticDifferential(0.0, 0.0),
-	mProjectedPoint(0.0, 0.0),
-	mStretchDirOnUnitSphere(0.0, 0.0, 0.0),
-	mStretchDirOnExtendedPlane(0.0, 0.0),
-	mStretchDirOnUnitDisk(0.0, 0.0),
 	CGAL::HalfedgeDS_vertex_base<Refs, CGAL::Tag_true, Point_3>(v)
 {
 }
 
 
-template<class Refs, typename Traits>
-Vertex_Base<Refs, Traits>::Vertex_Base(const Point_3& p) :
+template<class Refs, typename Traits, class Fields>
+Vertex_Base<Refs, Traits, Fields>::Vertex_Base(const Point_3& p) :
 mIndex(-1),
 	mLocalIndex(-1),
-	mXLocalIndex(-1),
-	mYLocalIndex(-1),
 	mUserIndex(-1),
 	mFullRotationIndex(0),
 	mIsFree(true),
-	mIsXfree(true),
-	mIsYfree(true),
-	mConformalFactor(0.0),
-	mPrescribedGaussianCurvature(0.0),
-	mPhiMetricGaussianCurvature(0.0),
 	mUV(0.0, 0.0, 0.0),
-	mQuadraticDifferential(0.0, 0.0),
-	mProjectedPoint(0.0, 0.0),
-	mStretchDirOnUnitSphere(0.0, 0.0, 0.0),
-	mStretchDirOnExtendedPlane(0.0, 0.0),
-	mStretchDirOnUnitDisk(0.0, 0.0),
 	CGAL::HalfedgeDS_vertex_base<Refs, CGAL::Tag_true, Point_3>(p)
 {
 }
 
 
 
-template<class Refs, typename Traits>
-std::complex<double>& Vertex_Base<Refs, Traits>::quadraticDifferential()
+template<class Refs, typename Traits, class Fields>
+std::complex<double>& Vertex_Base<Refs, Traits, Fields>::quadraticDifferential()
 {
-	return mQuadraticDifferential;
+	return this->mQuadraticDifferential;
 }
 
-template<class Refs, typename Traits>
-std::complex<double> Vertex_Base<Refs, Traits>::quadraticDifferential() const
+template<class Refs, typename Traits, class Fields>
+std::complex<double> Vertex_Base<Refs, Traits, Fields>::quadraticDifferential() const
 {
-	return mQuadraticDifferential;
+	return this->mQuadraticDifferential;
 }
 
 
-template<class Refs, typename Traits>
-std::complex<double>& Vertex_Base<Refs, Traits>::projectedPoint()
+template<class Refs, typename Traits, class Fields>
+std::complex<double>& Vertex_Base<Refs, Traits, Fields>::projectedPoint()
 {
-	return mProjectedPoint;
+	return this->mProjectedPoint;
 }
 
-template<class Refs, typename Traits>
-std::complex<double> Vertex_Base<Refs, Traits>::projectedPoint() const
+template<class Refs, typename Traits, class Fields>
+std::complex<double> Vertex_Base<Refs, Traits, Fields>::projectedPoint() const
 {
-	return mProjectedPoint;
+	return this->mProjectedPoint;
 }
 
 
-template<class Refs, typename Traits>
-double& Vertex_Base<Refs, Traits>::conformalFactor()
+template<class Refs, typename Traits, class Fields>
+double& Vertex_Base<Refs, Traits, Fields>::conformalFactor()
 {
-	return mConformalFactor;
+	return this->mConformalFactor;
 }
 
-template<class Refs, typename Traits>
-double Vertex_Base<Refs, Traits>::conformalFactor() const
+template<class Refs, typename Traits, class Fields>
+double Vertex_Base<Refs, Traits, Fields>::conformalFactor() const
 {
-	return mConformalFactor;
+	return this->mConformalFactor;
 }
 
 
-template<class Refs, typename Traits>
-typename Traits::Kernel::Vector_3& Vertex_Base<Refs, Traits>::stretchDirOnUnitSphere()
+template<class Refs, typename Traits, class Fields>
+typename Traits::Kernel::Vector_3& Vertex_Base<Refs, Traits, Fields>::stretchDirOnUnitSphere()
 {
-	return mStretchDirOnUnitSphere;
+	return this->mStretchDirOnUnitSphere;
 }
 
-template<class Refs, typename Traits>
-const typename Traits::Kernel::Vector_3& Vertex_Base<Refs, Traits>::stretchDirOnUnitSphere() const
+template<class Refs, typename Traits, class Fields>
+const typename Traits::Kernel::Vector_3& Vertex_Base<Refs, Traits, Fields>::stretchDirOnUnitSphere() const
 {
-	return mStretchDirOnUnitSphere;
+	return this->mStretchDirOnUnitSphere;
 }
 
 
-template<class Refs, typename Traits>
-std::complex<double>& Vertex_Base<Refs, Traits>::stretchDirOnExtendedPlane()
+template<class Refs, typename Traits, class Fields>
+std::complex<double>& Vertex_Base<Refs, Traits, Fields>::stretchDirOnExtendedPlane()
 {
-	return mStretchDirOnExtendedPlane;
+	return this->mStretchDirOnExtendedPlane;
 }
 
-template<class Refs, typename Traits>
-const std::complex<double>& Vertex_Base<Refs, Traits>::stretchDirOnExtendedPlane() const
+template<class Refs, typename Traits, class Fields>
+const std::complex<double>& Vertex_Base<Refs, Traits, Fields>::stretchDirOnExtendedPlane() const
 {
-	return mStretchDirOnExtendedPlane;
+	return this->mStretchDirOnExtendedPlane;
 }
 
 
-template<class Refs, typename Traits>
-std::complex<double>& Vertex_Base<Refs, Traits>::stretchDirOnUnitDisk()
+template<class Refs, typename Traits, class Fields>
+std::complex<double>& Vertex_Base<Refs, Traits, Fields>::stretchDirOnUnitDisk()
 {
-	return mStretchDirOnUnitDisk;
+	return this->mStretchDirOnUnitDisk;
 }
 
-template<class Refs, typename Traits>
-const std::complex<double>& Vertex_Base<Refs, Traits>::stretchDirOnUnitDisk() const
+template<class Refs, typename Traits, class Fields>
+const std::complex<double>& Vertex_Base<Refs, Traits, Fields>::stretchDirOnUnitDisk() const
 {
-	return mStretchDirOnUnitDisk;
+	return this->mStretchDirOnUnitDisk;
 }
 
 
 
-template<class Refs, typename Traits>
-typename Traits::Kernel::Point_3& Vertex_Base<Refs, Traits>::uv()
+template<class Refs, typename Traits, class Fields>
+typename Traits::Kernel::Point_3& Vertex_Base<Refs, Traits, Fields>::uv()
 {
 	return mUV;
 }
 
-template<class Refs, typename Traits>
-const typename Traits::Kernel::Point_3& Vertex_Base<Refs, Traits>::uv() const
+template<class Refs, typename Traits, class Fields>
+const typename Traits::Kernel::Point_3& Vertex_Base<Refs, Traits, Fields>::uv() const
 {
 	return mUV;
 }
 
 
-template<class Refs, typename Traits>
-std::complex<double> Vertex_Base<Refs, Traits>::uvC(const std::complex<double>& uv)
+template<class Refs, typename Traits, class Fields>
+std::complex<double> Vertex_Base<Refs, Traits, Fields>::uvC(const std::complex<double>& uv)
 {
 	double u = mUV.x();
 	double v = mUV.y();
@@ -277,119 +273,119 @@ std::complex<double> Vertex_Base<Refs, Traits>::uvC(const std::complex<double>&
 	return std::complex<double>(u, v);
 }
 
-template<class Refs, typename Traits>
-std::complex<double> Vertex_Base<Refs, Traits>::uvC() const
+template<class Refs, typename Traits, class Fields>
+std::complex<double> Vertex_Base<Refs, Traits, Fields>::uvC() const
 {
 	return std::complex<double>(mUV.x(), mUV.y());
 }
 
 
 
-template<class Refs, typename Traits>
-bool Vertex_Base<Refs, Traits>::isFree() const
+template<class Refs, typename Traits, class Fields>
+bool Vertex_Base<Refs, Traits, Fields>::isFree() const
 {
 	return mIsFree;
 }
 
-template<class Refs, typename Traits>
-bool& Vertex_Base<Refs, Traits>::isFree()
+template<class Refs, typename Traits, class Fields>
+bool& Vertex_Base<Refs, Traits, Fields>::isFree()
 {
 	return mIsFree;
 }
 
-template<class Refs, typename Traits>
-bool Vertex_Base<Refs, Traits>::isXfree() const
+template<class Refs, typename Traits, class Fields>
+bool Vertex_Base<Refs, Traits, Fields>::isXfree() const
 {
-	return mIsXfree;
+	return this->mIsXfree;
 }
 
-template<class Refs, typename Traits>
-bool& Vertex_Base<Refs, Traits>::isXfree()
+template<class Refs, typename Traits, class Fields>
+bool& Vertex_Base<Refs, Traits, Fields>::isXfree()
 {
-	return mIsXfree;
+	return this->mIsXfree;
 }
 
-template<class Refs, typename Traits>
-bool Vertex_Base<Refs, Traits>::isYfree() const
+template<class Refs, typename Traits, class Fields>
+bool Vertex_Base<Refs, Traits, Fields>::isYfree() const
 {
-	return mIsYfree;
+	return this->mIsYfree;
 }
 
-template<class Refs, typename Traits>
-bool& Vertex_Base<Refs, Traits>::isYfree()
+template<class Refs, typename Traits, class Fields>
+bool& Vertex_Base<Refs, Traits, Fields>::isYfree()
 {
-	return mIsYfree;
+	return this->mIsYfree;
 }
 
-template<class Refs, typename Traits>
-int& Vertex_Base<Refs, Traits>::index()
+template<class Refs, typename Traits, class Fields>
+int& Vertex_Base<Refs, Traits, Fields>::index()
 {
 	return mIndex;
 }
 
-template<class Refs, typename Traits>
-int Vertex_Base<Refs, Traits>::index() const
+template<class Refs, typename Traits, class Fields>
+int Vertex_Base<Refs, Traits, Fields>::index() const
 {
 	return mIndex;
 }
 
-template<class Refs, typename Traits>
-int& Vertex_Base<Refs, Traits>::localIndex()
+template<class Refs, typename Traits, class Fields>
+int& Vertex_Base<Refs, Traits, Fields>::localIndex()
 {
 	return mLocalIndex;
 }
 
 
-template<class Refs, typename Traits>
-int Vertex_Base<Refs, Traits>::localIndex() const
+template<class Refs, typename Traits, class Fields>
+int Vertex_Base<Refs, Traits, Fields>::localIndex() const
 {
 	return mLocalIndex;
 }
 
-template<class Refs, typename Traits>
-int& Vertex_Base<Refs, Traits>::xLocalIndex()
+template<class Refs, typename Traits, class Fields>
+int& Vertex_Base<Refs, Traits, Fields>::xLocalIndex()
 {
-	return mXLocalIndex;
+	return this->mXLocalIndex;
 }
 
-template<class Refs, typename Traits>
-int Vertex_Base<Refs, Traits>::xLocalIndex() const
+template<class Refs, typename Traits, class Fields>
+int Vertex_Base<Refs, Traits, Fields>::xLocalIndex() const
 {
-	return mXLocalIndex;
+	return this->mXLocalIndex;
 }
 
-template<class Refs, typename Traits>
-int& Vertex_Base<Refs, Traits>::yLocalIndex()
+template<class Refs, typename Traits, class Fields>
+int& Vertex_Base<Refs, Traits, Fields>::yLocalIndex()
 {
-	return mYLocalIndex;
+	return this->mYLocalIndex;
 }
 
-template<class Refs, typename Traits>
-int Vertex_Base<Refs, Traits>::yLocalIndex() const
+template<class Refs, typename Traits, class Fields>
+int Vertex_Base<Refs, Traits, Fields>::yLocalIndex() const
 {
-	return mYLocalIndex;
+	return this->mYLocalIndex;
 }
 
-template<class Refs, typename Traits>
-int& Vertex_Base<Refs, Traits>::userIndex()
+template<class Refs, typename Traits, class Fields>
+int& Vertex_Base<Refs, Traits, Fields>::userIndex()
 {
 	return mUserIndex;
 }
 
-template<class Refs, typename Traits>
-int Vertex_Base<Refs, Traits>::userIndex() const
+template<class Refs, typename Traits, class Fields>
+int Vertex_Base<Refs, Traits, Fields>::userIndex() const
 {
 	return mUserIndex;
 }
 
-template<class Refs, typename Traits>
-int& Vertex_Base<Refs, Traits>::fullRotationIndex()
+template<class Refs, typename Traits, class Fields>
+int& Vertex_Base<Refs, Traits, Fields>::fullRotationIndex()
 {
 	return mFullRotationIndex;
 }
 
-template<class Refs, typename Traits>
-int Vertex_Base<Refs, Traits>::fullRotationIndex() const
+template<class Refs, typename Traits, class Fields>
+int Vertex_Base<Refs, Traits, Fields>::fullRotationIndex() const
 {
 	return mFullRotationIndex;
 }
@@ -399,8 +395,8 @@ int Vertex_Base<Refs, Traits>::fullRotationIndex() const
 //if mixedCellAreaNormalization is false the angle deficit is being computed (which is an integrated quantity).
 //otherwise, the angle deficit is further divided by the area of the mixed cell element to provide a pointwise approximation of the curvature.
 //computations are done based on the 3D embedding of the mesh.
-template<class Refs, typename Traits>
-double Vertex_Base<Refs, Traits>::gaussianCurvature(bool mixedCellAreaNormalization = false) const
+template<class Refs, typename Traits, class Fields>
+double Vertex_Base<Refs, Traits, Fields>::gaussianCurvature(bool mixedCellAreaNormalization = false) const
 {
 	double k = 0.0;
 
@@ -426,8 +422,8 @@ double Vertex_Base<Refs, Traits>::gaussianCurvature(bool mixedCellAreaNormalizat
 //if mixedCellAreaNormalization is false the angle deficit is being computed (which is an integrated quantity).
 //otherwise, the angle deficit is further divided by the area of the mixed cell element to provide a pointwise approximation of the curvature.
 //computations are done based on the uv domain which is treated as a 3D mesh (embedded in 2D).
-template<class Refs, typename Traits>
-double Vertex_Base<Refs, Traits>::uvGaussianCurvature(bool mixedCellAreaNormalization = false) const
+template<class Refs, typename Traits, class Fields>
+double Vertex_Base<Refs, Traits, Fields>::uvGaussianCurvature(bool mixedCellAreaNormalization = false) const
 {
 	double k = 0.0;
 
@@ -452,8 +448,8 @@ double Vertex_Base<Refs, Traits>::uvGaussianCurvature(bool mixedCellAreaNormaliz
 //computes the geodesic curvature of a boundary curve at a boundary vertex.
 //use the uv layout rather than the 3D mesh.
 //note that this is different from uvGaussianCurvature that uses the sum of angles taken from adjacent triangles
-template<class Refs, typename Traits>
-double Vertex_Base<Refs, Traits>::uvGeodesicCurvature() const
+template<class Refs, typename Traits, class Fields>
+double Vertex_Base<Refs, Traits, Fields>::uvGeodesicCurvature() const
 {
 	if(!is_border())
 	{
@@ -535,8 +531,8 @@ double Vertex_Base<Refs, Traits>::uvGeodesicCurvature() const
 
 
 
-template<class Refs, typename Traits>
-bool Vertex_Base<Refs, Traits>::is_border() const
+template<class Refs, typename Traits, class Fields>
+bool Vertex_Base<Refs, Traits, Fields>::is_border() const
 {
 	Halfedge_const_handle h = halfedge();
 	if(h == NULL) return true;
@@ -553,8 +549,8 @@ bool Vertex_Base<Refs, Traits>::is_border() const
 }
 
 
-template<class Refs, typename Traits>
-double Vertex_Base<Refs, Traits>::coneAngle() const
+template<class Refs, typename Traits, class Fields>
+double Vertex_Base<Refs, Traits, Fields>::coneAngle() const
 {
 	double anglesSum = 0.0;
 
@@ -575,23 +571,23 @@ double Vertex_Base<Refs, Traits>::coneAngle() const
 
 
 
-template<class Refs, typename Traits>
-double Vertex_Base<Refs, Traits>::prescribedConeAngle() const
+template<class Refs, typename Traits, class Fields>
+double Vertex_Base<Refs, Traits, Fields>::prescribedConeAngle() const
 {
 	if(is_border())
 	{
-		return CGAL_PI-mPrescribedGaussianCurvature;
+		return CGAL_PI-this->mPrescribedGaussianCurvature;
 	}
 	else //internal vertex
 	{
-		return 2.0*CGAL_PI-mPrescribedGaussianCurvature;
+		return 2.0*CGAL_PI-this->mPrescribedGaussianCurvature;
 	}
 }
 
 
 
-template<class Refs, typename Traits>
-double Vertex_Base<Refs, Traits>::uvConeAngle() const
+template<class Refs, typename Traits, class Fields>
+double Vertex_Base<Refs, Traits, Fields>::uvConeAngle() const
 {
 	double anglesSum = 0.0;
 
@@ -612,39 +608,39 @@ double Vertex_Base<Refs, Traits>::uvConeAngle() const
 
 
 
-template<class Refs, typename Traits>
-double Vertex_Base<Refs, Traits>::prescribedGaussianCurvature() const
+template<class Refs, typename Traits, class Fields>
+double Vertex_Base<Refs, Traits, Fields>::prescribedGaussianCurvature() const
 {
-	return mPrescribedGaussianCurvature;
+	return this->mPrescribedGaussianCurvature;
 }
 
 
-template<class Refs, typename Traits>
-double& Vertex_Base<Refs, Traits>::prescribedGaussianCurvature()
+template<class Refs, typename Traits, class Fields>
+double& Vertex_Base<Refs, Traits, Fields>::prescribedGaussianCurvature()
 {
-	return mPrescribedGaussianCurvature;
+	return this->mPrescribedGaussianCurvature;
 }
 
 
 
-template<class Refs, typename Traits>
-double Vertex_Base<Refs, Traits>::phiMetricGaussianCurvature() const
+template<class Refs, typename Traits, class Fields>
+double Vertex_Base<Refs, Traits, Fields>::phiMetricGaussianCurvature() const
 {
-	return mPhiMetricGaussianCurvature;
+	return this->mPhiMetricGaussianCurvature;
 }
 
 
-template<class Refs, typename Traits>
-double& Vertex_Base<Refs, Traits>::phiMetricGaussianCurvature()
+template<class Refs, typename Traits, class Fields>
+double& Vertex_Base<Refs, Traits, Fields>::phiMetricGaussianCurvature()
 {
-	return mPhiMetricGaussianCurvature;
+	return this->mPhiMetricGaussianCurvature;
 }
 
 
 
 //compute the cone angle of the abstract (i.e., we don't have embedding for it) manifold based on the target metric
-template<class Refs, typename Traits>
-double Vertex_Base<Refs, Traits>::targetMetricConeAngle() const
+template<class Refs, typename Traits, class Fields>
+double Vertex_Base<Refs, Traits, Fields>::targetMetricConeAngle() const
 {
 	double cone = 0.0;
 
@@ -668,8 +664,8 @@ double Vertex_Base<Refs, Traits>::targetMetricConeAngle() const
 //if mixedCellAreaNormalization is false the angle deficit is being computed (which is an integrated quantity).
 //otherwise, the angle deficit is further divided by the area of the mixed cell element to provide a pointwise approximation of the curvature.
 //computations are done based on the prescribed target metric (edge lengths).
-template<class Refs, typename Traits>
-double Vertex_Base<Refs, Traits>::targetMetricGaussianCurvature(bool mixedCellAreaNormalization = false) const
+template<class Refs, typename Traits, class Fields>
+double Vertex_Base<Refs, Traits, Fields>::targetMetricGaussianCurvature(bool mixedCellAreaNormalization = false) const
 {
 	double k = 0.0;
 
@@ -693,8 +689,8 @@ double Vertex_Base<Refs, Traits>::targetMetricGaussianCurvature(bool mixedCellAr
 
 //this function computes the mixed cell area (combination of Voronoi and barycentric area) for the given vertex.
 //area computation are either based on 3D embedding or the target metric.
-template<class Refs, typename Traits>
-double Vertex_Base<Refs, Traits>::mixedCellArea(bool useTargetMetric = false) const
+template<class Refs, typename Traits, class Fields>
+double Vertex_Base<Refs, Traits, Fields>::mixedCellArea(bool useTargetMetric = false) const
 {
 	double area = 0.0;
 
@@ -716,8 +712,8 @@ double Vertex_Base<Refs, Traits>::mixedCellArea(bool useTargetMetric = false) co
 
 //this function computes the mixed cell area (combination of Voronoi and barycentric area) for the given vertex.
 //area computation is based on the uv domain (which is treated as a mesh).
-template<class Refs, typename Traits>
-double Vertex_Base<Refs, Traits>::uvMixedCellArea() const
+template<class Refs, typename Traits, class Fields>
+double Vertex_Base<Refs, Traits, Fields>::uvMixedCellArea() const
 {
 	double area = 0.0;
 
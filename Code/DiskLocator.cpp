@@ -0,0 +1,416 @@
+#include "stdafx.h"
+
+
+//orientation of the edge (a, b) and the query point, for exact query points
+struct ExactQueryOrientation
+{
+	ExactQueryOrientation(const std::vector<Point_2>& points, const EPoint_2& q) : points(points), q(q) {}
+
+	int operator()(int a, int b) const
+	{
+		return (int)CGAL::orientation(EPoint_2(points[a].x(), points[a].y()), EPoint_2(points[b].x(), points[b].y()), q);
+	}
+
+	const std::vector<Point_2>& points;
+	const EPoint_2& q;
+};
+
+//orientation of the edge (a, b) and the query point, for query points which are doubles
+struct DoubleQueryOrientation
+{
+	DoubleQueryOrientation(const std::vector<Point_2>& points, double qx, double qy) : points(points), q(qx, qy) {}
+
+	int operator()(int a, int b) const
+	{
+		return (int)IKernel::Orientation_2()(IKernel::Point_2(points[a].x(), points[a].y()), IKernel::Point_2(points[b].x(), points[b].y()), q);
+	}
+
+	const std::vector<Point_2>& points;
+	IKernel::Point_2 q;
+};
+
+
+DiskLocator::DiskLocator() : mPoints(NULL), mGridSize(0), mMinX(0.0), mMinY(0.0), mCellSize(1.0)
+{
+}
+
+void DiskLocator::build(const std::vector<Point_2>& points, const std::vector<int>& fVec)
+{
+	int numVertices = (int)points.size();
+	int numFaces = (int)fVec.size() / 3;
+
+	mPoints = &points;
+	mFaces.assign(fVec.begin(), fVec.begin() + 3 * numFaces);
+
+	mOrientation.resize(numFaces);
+	for (int f = 0; f < numFaces; ++f)
+	{
+		const Point_2& a = points[mFaces[3 * f]];
+		const Point_2& b = points[mFaces[3 * f + 1]];
+		const Point_2& c = points[mFaces[3 * f + 2]];
+		CGAL::Orientation orientation = IKernel::Orientation_2()(IKernel::Point_2(a.x(), a.y()), IKernel::Point_2(b.x(), b.y()), IKernel::Point_2(c.x(), c.y()));
+		mOrientation[f] = (orientation == CGAL::RIGHT_TURN) ? -1 : 1;
+	}
+
+	mAdjacency.build(mFaces, numVertices);
+
+	//grid of start faces, every cell holds a face whose centroid is in it (or a face of an earlier cell)
+	double maxX = mMinX = numVertices ? x(0) : 0.0;
+	double maxY = mMinY = numVertices ? y(0) : 0.0;
+	for (int i = 1; i < numVertices; ++i)
+	{
+		mMinX = (std::min)(mMinX, x(i));
+		mMinY = (std::min)(mMinY, y(i));
+		maxX = (std::max)(maxX, x(i));
+		maxY = (std::max)(maxY, y(i));
+	}
+	mGridSize = (std::max)(1, (int)std::sqrt(numFaces / 2.0));
+	mCellSize = (std::max)(maxX - mMinX, maxY - mMinY) / mGridSize;
+	if (mCellSize <= 0.0)
+		mCellSize = 1.0;
+
+	mGridStartFace.assign(mGridSize * mGridSize, -1);
+	for (int f = 0; f < numFaces; ++f)
+	{
+		double cx = (x(mFaces[3 * f]) + x(mFaces[3 * f + 1]) + x(mFaces[3 * f + 2])) / 3.0;
+		double cy = (y(mFaces[3 * f]) + y(mFaces[3 * f + 1]) + y(mFaces[3 * f + 2])) / 3.0;
+		int cell = gridCell(cx, cy);
+		if (mGridStartFace[cell] == -1)
+			mGridStartFace[cell] = f;
+	}
+	int last = numFaces ? 0 : -1;
+	for (int cell = 0; cell < (int)mGridStartFace.size(); ++cell)
+	{
+		if (mGridStartFace[cell] == -1)
+			mGridStartFace[cell] = last;
+		else
+			last = mGridStartFace[cell];
+	}
+}
+
+int DiskLocator::gridCell(double x, double y) const
+{
+	int i = (int)((x - mMinX) / mCellSize);
+	int j = (int)((y - mMinY) / mCellSize);
+	i = (std::min)((std::max)(i, 0), mGridSize - 1);
+	j = (std::min)((std::max)(j, 0), mGridSize - 1);
+	return j * mGridSize + i;
+}
+
+int DiskLocator::startFace(double x, double y) const
+{
+	if (mGridStartFace.empty())
+		return -1;
+	return mGridStartFace[gridCell(x, y)];
+}
+
+DiskLocator::Location DiskLocator::locate(const EPoint_2& p, int startFace) const
+{
+	std::pair<double, double> ix = CGAL::to_interval(p.x());
+	std::pair<double, double> iy = CGAL::to_interval(p.y());
+	if (ix.first == ix.second && iy.first == iy.second)	//the point is exactly a double
+		return walk(DoubleQueryOrientation(*mPoints, ix.first, iy.first), ix.first, iy.first, startFace);
+
+	return walk(ExactQueryOrientation(*mPoints, p), CGAL::to_double(p.x()), CGAL::to_double(p.y()), startFace);
+}
+
+DiskLocator::Location DiskLocator::locate(double x, double y, int startFace) const
+{
+	return walk(DoubleQueryOrientation(*mPoints, x, y), x, y, startFace);
+}
+
+DiskLocator::Location DiskLocator::locateInFace(int face, const EPoint_2& p) const
+{
+	Location location;
+	std::pair<double, double> ix = CGAL::to_interval(p.x());
+	std::pair<double, double> iy = CGAL::to_interval(p.y());
+	if (ix.first == ix.second && iy.first == iy.second)
+	{
+		if (classify(DoubleQueryOrientation(*mPoints, ix.first, iy.first), face, 0, location) != -1)
+			location = Location();
+	}
+	else if (classify(ExactQueryOrientation(*mPoints, p), face, 0, location) != -1)
+		location = Location();
+	return location;
+}
+
+DiskLocator::Location DiskLocator::locateInFace(int face, double x, double y) const
+{
+	Location location;
+	if (classify(DoubleQueryOrientation(*mPoints, x, y), face, 0, location) != -1)
+		location = Location();
+	return location;
+}
+
+//returns the first edge (starting at firstEdge) which separates the face from the point, or -1 if the face contains
+//the point, in which case location is filled
+template <class Orientation>
+int DiskLocator::classify(const Orientation& orientation, int face, int firstEdge, Location& location) const
+{
+	int numOnEdge = 0;
+	int onEdge[3];
+	for (int k = 0; k < 3; ++k)
+	{
+		int j = (firstEdge + k) % 3;
+		int side = mOrientation[face] * orientation(mFaces[3 * face + j], mFaces[3 * face + (j + 1) % 3]);
+		if (side < 0)
+			return j;
+		if (side == 0)
+			onEdge[numOnEdge++] = j;
+	}
+	if (numOnEdge == 3)	//degenerate face
+		return firstEdge;
+
+	location.face = face;
+	if (numOnEdge == 0)
+		location.type = FACE;
+	else if (numOnEdge == 1)
+	{
+		location.type = EDGE;
+		location.v1 = mFaces[3 * face + onEdge[0]];
+		location.v2 = mFaces[3 * face + (onEdge[0] + 1) % 3];
+	}
+	else
+	{
+		//the vertex shared by the two edges
+		int j = (onEdge[1] == (onEdge[0] + 1) % 3) ? onEdge[1] : onEdge[0];
+		location.type = VERTEX;
+		location.v1 = mFaces[3 * face + j];
+	}
+	return -1;
+}
+
+//randomized visibility walk (the random first edge prevents cycles in non Delaunay triangulations)
+template <class Orientation>
+DiskLocator::Location DiskLocator::walk(const Orientation& orientation, double x, double y, int startFace) const
+{
+	Location location;
+	int numFaces = this->numFaces();
+	int face = (startFace >= 0 && startFace < numFaces) ? startFace : this->startFace(x, y);
+	if (face == -1)
+		return location;
+
+	unsigned int random = 2463534242u;
+	for (int step = 0; step <= numFaces; ++step)
+	{
+		random ^= random << 13;
+		random ^= random >> 17;
+		random ^= random << 5;
+
+		int exitEdge = classify(orientation, face, random % 3, location);
+		if (exitEdge == -1)
+			return location;
+
+		face = mAdjacency.neighbor(face, exitEdge);
+		if (face == -1)
+			return location;	//outside the disk
+	}
+
+	//the walk did not terminate (degenerate faces), go over all the faces
+	for (face = 0; face < numFaces; ++face)
+	{
+		if (classify(orientation, face, 0, location) == -1)
+			return location;
+	}
+	return Location();
+}
+
+bool DiskLocator::getFace(int face, std::vector<EPoint_2>& points, std::vector<int>& indices) const
+{
+	if (face < 0 || face >= numFaces())
+		return false;
+
+	points.resize(3);
+	indices.resize(3);
+	for (int j = 0; j < 3; ++j)
+	{
+		indices[j] = mFaces[3 * face + j];
+		points[j] = EPoint_2((*mPoints)[indices[j]].x(), (*mPoints)[indices[j]].y());
+	}
+	return true;
+}
+
+//goes over all the boundary edges, it is only for the few points which fall outside
+int DiskLocator::nearestBoundaryPoint(double x, double y, Point_2& nearest) const
+{
+	int nearestFace = -1;
+	double nearestDistance = 0.0;
+	for (int face = 0; face < numFaces(); ++face)
+	{
+		for (int j = 0; j < 3; ++j)
+		{
+			if (neighbor(face, j) != -1)
+				continue;
+
+			int a = vertexOfFace(face, j), b = vertexOfFace(face, (j + 1) % 3);
+			double ex = this->x(b) - this->x(a), ey = this->y(b) - this->y(a);
+			double length = ex * ex + ey * ey;
+			double t = (length > 0.0) ? ((x - this->x(a)) * ex + (y - this->y(a)) * ey) / length : 0.0;
+			t = (std::max)(0.0, (std::min)(1.0, t));
+			double px = this->x(a) + t * ex, py = this->y(a) + t * ey;
+			double distance = (px - x) * (px - x) + (py - y) * (py - y);
+			if (nearestFace == -1 || distance < nearestDistance)
+			{
+				nearestFace = face;
+				nearestDistance = distance;
+				nearest = Point_2(px, py);
+			}
+		}
+	}
+	return nearestFace;
+}
+
+//intersection of the segment (p, q) with the line of the edge (a, b), which it crosses
+EPoint_2 DiskLocator::crossing(const Point_2& p, const Point_2& q, int a, int b) const
+{
+	ARRNumberType px(p.x()), py(p.y());
+	ARRNumberType dx = ARRNumberType(q.x()) - px, dy = ARRNumberType(q.y()) - py;
+	ARRNumberType ex = ARRNumberType(x(b)) - x(a), ey = ARRNumberType(y(b)) - y(a);
+	ARRNumberType t = ((ARRNumberType(x(a)) - px) * ey - (ARRNumberType(y(a)) - py) * ex) / (dx * ey - dy * ex);
+	return EPoint_2(px + t * dx, py + t * dy);
+}
+
+//straight line walk. every step is either in the interior of a face, which the segment leaves through an edge or a
+//vertex, or at a vertex, from which the segment goes into the interior of a face or along an edge. all the tests are
+//orientations of doubles, so they are exact.
+void DiskLocator::segmentCrossings(const Point_2& p, const Point_2& q, std::vector<EPoint_2>& crossings) const
+{
+	crossings.clear();
+	if (p == q)
+		return;
+
+	IKernel::Orientation_2 orientation;
+	const IKernel::Point_2 ip(p.x(), p.y()), iq(q.x(), q.y());
+	int face = -1, vertex = -1;
+
+	Location start = locate(p.x(), p.y());
+	if (start.type == OUTSIDE)
+		return;
+	if (start.type == VERTEX)
+		vertex = start.v1;
+	else if (start.type == FACE)
+		face = start.face;
+	else
+	{
+		//p is on an edge, continue in the face on the side of q, or along the edge
+		int a = start.v1, b = start.v2;
+		CGAL::Orientation side = orientation(IKernel::Point_2(x(a), y(a)), IKernel::Point_2(x(b), y(b)), iq);
+		if (side == CGAL::COLLINEAR)
+		{
+			int ahead = (CGAL::collinear_are_ordered_along_line(IKernel::Point_2(x(a), y(a)), ip, iq)) ? b : a;
+			if (CGAL::collinear_are_ordered_along_line(ip, iq, IKernel::Point_2(x(ahead), y(ahead))))
+				return;
+			crossings.push_back(EPoint_2(x(ahead), y(ahead)));
+			vertex = ahead;
+		}
+		else
+		{
+			//the face is on the left of (a, b) if (a, b) is counter clockwise in it
+			face = start.face;
+			int j = 0;
+			while (mFaces[3 * face + j] != a || mFaces[3 * face + (j + 1) % 3] != b)
+				j++;
+			if (mOrientation[face] != (int)side)
+				face = mAdjacency.neighbor(face, j);
+			if (face == -1)
+				return;
+		}
+	}
+
+	int numSteps = numFaces() + numVertices();
+	for (int step = 0; step < numSteps; ++step)
+	{
+		if (vertex != -1)
+		{
+			const IKernel::Point_2 c(x(vertex), y(vertex));
+			int next = -1, nextVertex = -1;
+			for (int k = mAdjacency.vertexFacesBegin(vertex); k < mAdjacency.vertexFacesEnd(vertex) && next == -1 && nextVertex == -1; ++k)
+			{
+				int f = mAdjacency.vertexFace(k);
+				int j = 0;
+				while (mFaces[3 * f + j] != vertex)
+					j++;
+				//(vertex, a, b) is counter clockwise in the disk
+				int a = mFaces[3 * f + (j + 1) % 3], b = mFaces[3 * f + (j + 2) % 3];
+				if (mOrientation[f] < 0)
+					std::swap(a, b);
+				const IKernel::Point_2 pa(x(a), y(a)), pb(x(b), y(b));
+				CGAL::Orientation sideA = orientation(c, pa, iq), sideB = orientation(c, pb, iq);
+				if (sideA == CGAL::RIGHT_TURN || sideB == CGAL::LEFT_TURN)
+					continue;	//q is not in the wedge of the face at the vertex
+
+				if (sideA == CGAL::COLLINEAR || sideB == CGAL::COLLINEAR)
+				{
+					//along an edge, the other endpoint is ahead or the edge points away from q
+					int w = (sideA == CGAL::COLLINEAR) ? a : b;
+					const IKernel::Point_2& pw = (sideA == CGAL::COLLINEAR) ? pa : pb;
+					if (!CGAL::collinear_are_ordered_along_line(c, pw, iq) && !CGAL::collinear_are_ordered_along_line(c, iq, pw))
+						continue;
+					if (CGAL::collinear_are_ordered_along_line(c, iq, pw))
+						return;	//q is on the edge
+					nextVertex = w;
+				}
+				else
+				{
+					if (orientation(pa, pb, iq) != CGAL::RIGHT_TURN)
+						return;	//q is in the face
+					crossings.push_back(crossing(p, q, a, b));
+					next = mAdjacency.neighbor(f, (j + 1) % 3);	//across the edge opposite to the vertex
+					if (next == -1)
+						return;
+				}
+			}
+
+			if (nextVertex != -1)
+			{
+				crossings.push_back(EPoint_2(x(nextVertex), y(nextVertex)));
+				vertex = nextVertex;
+				continue;
+			}
+			if (next == -1)
+				return;	//the segment leaves the disk at the vertex
+			vertex = -1;
+			face = next;
+			continue;
+		}
+
+		Location location;
+		if (classify(DoubleQueryOrientation(*mPoints, q.x(), q.y()), face, 0, location) == -1)
+			return;	//q is in the face
+
+		//side of every vertex of the face relative to the directed line (p, q), times the orientation of the face
+		int side[3];
+		for (int j = 0; j < 3; ++j)
+		{
+			int v = mFaces[3 * face + j];
+			side[j] = mOrientation[face] * (int)orientation(ip, iq, IKernel::Point_2(x(v), y(v)));
+		}
+
+		//the segment leaves a counter clockwise face through the edge which goes from its right to its left. if there
+		//is no such edge, it leaves through the vertex on the line (a vertex on the line behind it comes with an exit edge).
+		int exitEdge = -1, exitVertex = -1;
+		for (int j = 0; j < 3; ++j)
+		{
+			if (side[j] < 0 && side[(j + 1) % 3] > 0)
+				exitEdge = j;
+			else if (side[j] == 0)
+				exitVertex = mFaces[3 * face + j];
+		}
+
+		if (exitEdge != -1)
+		{
+			int a = mFaces[3 * face + exitEdge], b = mFaces[3 * face + (exitEdge + 1) % 3];
+			crossings.push_back(crossing(p, q, a, b));
+			face = mAdjacency.neighbor(face, exitEdge);
+			if (face == -1)
+				return;
+		}
+		else if (exitVertex != -1)
+		{
+			crossings.push_back(EPoint_2(x(exitVertex), y(exitVertex)));
+			vertex = exitVertex;
+		}
+		else
+			return;	//degenerate face
+	}
+}
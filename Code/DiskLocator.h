@@ -0,0 +1,88 @@
+#pragma once
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Point location in a disk map triangulation, given by its points and fVec.
+// A query walks from a start face towards the point (randomized visibility walk) using the face
+// adjacency. The start face is taken from a coarse grid over the disk unless the caller passes one.
+// The disk map is kept as doubles. Orientation tests are exact: exact query points go through the filtered
+// predicates of the arrangement kernel (the disk map vertices are promoted to exact points only there), and
+// points which are exactly doubles use the filtered predicates of the inexact constructions kernel. Queries on
+// doubles do not touch lazy exact objects, so they may run concurrently on a shared locator.
+// segmentCrossings walks along a segment between two points of another disk map (straight line walk) and
+// reports where it crosses the triangulation, in order.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <vector>
+
+
+class DiskLocator
+{
+public:
+
+	enum HitType { OUTSIDE = -1, VERTEX = 0, FACE = 1, EDGE = 2 }; //same numbering as the type of findTarget
+
+	struct Location
+	{
+		Location() : face(-1), type(OUTSIDE), v1(-1), v2(-1) {}
+
+		int face; //a face which contains the point (-1 if the point is outside the disk)
+		int type;
+		int v1, v2; //the vertex (VERTEX) or the endpoints of the edge (EDGE) which the point lies on
+	};
+
+	DiskLocator();
+
+	//points must stay alive while the locator is used
+	void build(const std::vector<Point_2>& points, const std::vector<int>& fVec);
+
+	Location locate(const EPoint_2& p, int startFace = -1) const;
+	Location locate(double x, double y, int startFace = -1) const;
+
+	//location of p if it is in the (closed) face, otherwise location.face is -1
+	Location locateInFace(int face, const EPoint_2& p) const;
+	Location locateInFace(int face, double x, double y) const;
+
+	//exact points and vertex indices of a face, in fVec order. false (and nothing is set) if there is no such face.
+	bool getFace(int face, std::vector<EPoint_2>& points, std::vector<int>& indices) const;
+
+	//for points which locate puts outside the disk: the point of the boundary which is nearest to p, and the face of
+	//its edge (-1 if the triangulation has no boundary edge)
+	int nearestBoundaryPoint(double x, double y, Point_2& nearest) const;
+
+	//the points where the segment (p, q) crosses an edge or passes through a vertex, ordered from p to q and without
+	//p and q. the walk stops where the segment leaves the disk.
+	void segmentCrossings(const Point_2& p, const Point_2& q, std::vector<EPoint_2>& crossings) const;
+
+	const std::vector<Point_2>& points() const { return *mPoints; }
+	const std::vector<int>& faces() const { return mFaces; }
+	double x(int v) const { return (*mPoints)[v].x(); }
+	double y(int v) const { return (*mPoints)[v].y(); }
+	int numVertices() const { return (int)mPoints->size(); }
+	int numFaces() const { return (int)mOrientation.size(); }
+	int vertexOfFace(int face, int j) const { return mFaces[3 * face + j]; }
+	int neighbor(int face, int j) const { return mAdjacency.neighbor(face, j); } //face across the edge (j, j+1), -1 on the boundary
+	int startFace(double x, double y) const;
+
+protected:
+
+	template <class Orientation>
+	Location walk(const Orientation& orientation, double x, double y, int startFace) const;
+	template <class Orientation>
+	int classify(const Orientation& orientation, int face, int firstEdge, Location& location) const;
+
+	int gridCell(double x, double y) const;
+	EPoint_2 crossing(const Point_2& p, const Point_2& q, int a, int b) const;
+
+protected:
+
+	const std::vector<Point_2>* mPoints;
+	std::vector<int> mFaces; //copy of fVec
+	FaceAdjacency mAdjacency;
+	std::vector<signed char> mOrientation; //1 - counter clockwise in the disk, -1 - clockwise
+
+	int mGridSize;
+	double mMinX, mMinY, mCellSize;
+	std::vector<int> mGridStartFace;
+};
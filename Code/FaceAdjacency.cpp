@@ -0,0 +1,63 @@
+#include "stdafx.h"
+
+
+void FaceAdjacency::build(const std::vector<int>& fVec, int numVertices)
+{
+	int numFaces = (int)fVec.size() / 3;
+	mMesh = NULL;
+	mFaces = NULL;
+
+	mVertexFacesPtr.assign(numVertices + 1, 0);
+	mVertexFaces.resize(3 * numFaces);
+	for (int i = 0; i < 3 * numFaces; ++i)
+		mVertexFacesPtr[fVec[i] + 1]++;
+	for (int i = 0; i < numVertices; ++i)
+		mVertexFacesPtr[i + 1] += mVertexFacesPtr[i];
+	std::vector<int> fill(mVertexFacesPtr.begin(), mVertexFacesPtr.end() - 1);
+	for (int i = 0; i < 3 * numFaces; ++i)
+		mVertexFaces[fill[fVec[i]]++] = i / 3;
+
+	mNeighbors.assign(3 * numFaces, -1);
+	for (int f = 0; f < numFaces; ++f)
+	{
+		for (int j = 0; j < 3; ++j)
+		{
+			int a = fVec[3 * f + j];
+			int b = fVec[3 * f + (j + 1) % 3];
+			for (int k = mVertexFacesPtr[b]; k < mVertexFacesPtr[b + 1]; ++k)
+			{
+				int g = mVertexFaces[k];
+				if (g != f && (fVec[3 * g] == a || fVec[3 * g + 1] == a || fVec[3 * g + 2] == a))
+				{
+					mNeighbors[3 * f + j] = g;
+					break;
+				}
+			}
+		}
+	}
+}
+
+void FaceAdjacency::attach(const Mesh& mesh, const std::vector<int>& fVec)
+{
+	mMesh = &mesh;
+	mFaces = &fVec;
+	mNeighbors.clear();
+	mVertexFacesPtr.clear();
+	mVertexFaces.clear();
+}
+
+int FaceAdjacency::meshNeighbor(int face, int j) const
+{
+	int a = (*mFaces)[3 * face + j];
+	int b = (*mFaces)[3 * face + (j + 1) % 3];
+	Mesh::Halfedge_around_facet_const_circulator h = mMesh->face(face)->facet_begin();
+	const Mesh::Halfedge_around_facet_const_circulator hEnd = h;
+	do
+	{
+		int target = h->vertex()->index(), source = h->opposite()->vertex()->index();
+		if ((source == a && target == b) || (source == b && target == a))
+			return (h->opposite()->is_border() ? -1 : h->opposite()->facet()->index());
+		++h;
+	} while (h != hEnd);
+	return (-1);
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Adjacency of a triangle list given by fVec: the face across every edge and the faces around every vertex.
+// build makes the tables once in O(F): the faces are bucketed by vertex, and the face across the edge (a, b) is the
+// other face of the bucket of b which has a. attach builds nothing, the face across an edge is read from the
+// halfedges of the mesh of fVec when it is asked for, so a few queries cost nothing up front. The refinement asks it
+// for neighbors and boundary edges, instead of locating the midpoints of the edges in the disk map.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <vector>
+
+
+class FaceAdjacency
+{
+public:
+
+	FaceAdjacency() : mMesh(NULL), mFaces(NULL) {}
+
+	void build(const std::vector<int>& fVec, int numVertices);
+	//the faces of the mesh are the faces of fVec, in the same order. both must stay alive while the adjacency is used.
+	void attach(const Mesh& mesh, const std::vector<int>& fVec);
+
+	int numFaces() const { return (mMesh == NULL) ? (int)mNeighbors.size() / 3 : (int)mMesh->size_of_facets(); }
+	int neighbor(int face, int j) const { return (mMesh == NULL) ? mNeighbors[3 * face + j] : meshNeighbor(face, j); } //face across the edge (j, j+1), -1 on the boundary
+	bool isBoundaryEdge(int face, int j) const { return (neighbor(face, j) == -1); }
+
+	//the faces around v are vertexFace(k) for k in [vertexFacesBegin(v), vertexFacesEnd(v)). only after build.
+	int vertexFacesBegin(int v) const { return mVertexFacesPtr[v]; }
+	int vertexFacesEnd(int v) const { return mVertexFacesPtr[v + 1]; }
+	int vertexFace(int k) const { return mVertexFaces[k]; }
+
+protected:
+
+	int meshNeighbor(int face, int j) const;
+
+protected:
+
+	const Mesh* mMesh;
+	const std::vector<int>* mFaces;
+	std::vector<int> mNeighbors;
+	std::vector<int> mVertexFacesPtr, mVertexFaces;
+};
@@ -0,0 +1,876 @@
+#include "HarmonicSolver.h"
+
+#include <cmath>
+#include <cassert>
+#include <iostream>
+#include <algorithm>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#define JACOBI_DAMPING (2.0 / 3.0)
+#define MAX_DENSE_COARSE_SIZE 3000
+
+
+//the thread count of a parallel region, 0 - the OpenMP default
+static int threadCount(int numThreads)
+{
+#ifdef _OPENMP
+	return (numThreads > 0) ? numThreads : omp_get_max_threads();
+#else
+	return 1;
+#endif
+}
+
+static void dot2(const double* a, const double* b, int n, double res[2], int numThreads)
+{
+	double s0 = 0.0, s1 = 0.0;
+#pragma omp parallel for reduction(+:s0,s1) num_threads(threadCount(numThreads))
+	for (int i = 0; i < n; ++i)
+	{
+		s0 += a[2 * i] * b[2 * i];
+		s1 += a[2 * i + 1] * b[2 * i + 1];
+	}
+	res[0] = s0;
+	res[1] = s1;
+}
+
+//y = a*x + y, a different scalar for each column
+static void axpy2(const double a[2], const double* x, double* y, int n, int numThreads)
+{
+#pragma omp parallel for num_threads(threadCount(numThreads))
+	for (int i = 0; i < n; ++i)
+	{
+		y[2 * i] += a[0] * x[2 * i];
+		y[2 * i + 1] += a[1] * x[2 * i + 1];
+	}
+}
+
+
+
+HarmonicSolverOptions::HarmonicSolverOptions() :
+	tolerance(1e-12),
+	maxIterations(2000),
+	numThreads(0),
+	coarsestSize(400),
+	maxLevels(20),
+	smoothingSteps(2),
+	verbose(false)
+{
+}
+
+
+
+void SparseMatrixCSR::clear()
+{
+	nRows = 0;
+	nCols = 0;
+	rowPtr.assign(1, 0);
+	colInd.clear();
+	values.clear();
+}
+
+void SparseMatrixCSR::multiply2(const double* x, double* y, int numThreads) const
+{
+#pragma omp parallel for num_threads(threadCount(numThreads))
+	for (int i = 0; i < nRows; ++i)
+	{
+		double s0 = 0.0, s1 = 0.0;
+		for (int k = rowPtr[i]; k < rowPtr[i + 1]; ++k)
+		{
+			int j = colInd[k];
+			s0 += values[k] * x[2 * j];
+			s1 += values[k] * x[2 * j + 1];
+		}
+		y[2 * i] = s0;
+		y[2 * i + 1] = s1;
+	}
+}
+
+void SparseMatrixCSR::transpose(SparseMatrixCSR& t) const
+{
+	t.nRows = nCols;
+	t.nCols = nRows;
+	t.rowPtr.assign(nCols + 1, 0);
+	t.colInd.resize(colInd.size());
+	t.values.resize(values.size());
+
+	for (int k = 0; k < (int)colInd.size(); ++k)
+		t.rowPtr[colInd[k] + 1]++;
+	for (int i = 0; i < nCols; ++i)
+		t.rowPtr[i + 1] += t.rowPtr[i];
+
+	std::vector<int> next(t.rowPtr.begin(), t.rowPtr.end() - 1);
+	for (int i = 0; i < nRows; ++i)
+	{
+		for (int k = rowPtr[i]; k < rowPtr[i + 1]; ++k)
+		{
+			int pos = next[colInd[k]]++;
+			t.colInd[pos] = i;
+			t.values[pos] = values[k];
+		}
+	}
+}
+
+bool SparseMatrixCSR::isSymmetric(double relativeTolerance) const
+{
+	if (nRows != nCols)
+		return false;
+
+	SparseMatrixCSR t;
+	transpose(t);
+
+	//transposing twice sorts the column indices of A, so it can be compared entry by entry with A^T
+	SparseMatrixCSR tt;
+	t.transpose(tt);
+
+	if (tt.colInd != t.colInd || tt.rowPtr != t.rowPtr)
+		return false;
+
+	for (int k = 0; k < (int)t.values.size(); ++k)
+	{
+		double a = t.values[k], b = tt.values[k];
+		if (std::abs(a - b) > relativeTolerance * std::max(std::abs(a), std::abs(b)))
+			return false;
+	}
+	return true;
+}
+
+
+
+//C = A*B (Gustavson's algorithm, column indices of C are sorted)
+void sparseMultiply(const SparseMatrixCSR& A, const SparseMatrixCSR& B, SparseMatrixCSR& C)
+{
+	assert(A.nCols == B.nRows);
+
+	C.nRows = A.nRows;
+	C.nCols = B.nCols;
+	C.rowPtr.assign(A.nRows + 1, 0);
+	C.colInd.clear();
+	C.values.clear();
+
+	std::vector<int> marker(B.nCols, -1);
+	std::vector<double> accumulator(B.nCols, 0.0);
+	std::vector<int> rowCols;
+
+	for (int i = 0; i < A.nRows; ++i)
+	{
+		rowCols.clear();
+		for (int ka = A.rowPtr[i]; ka < A.rowPtr[i + 1]; ++ka)
+		{
+			int k = A.colInd[ka];
+			double a = A.values[ka];
+			for (int kb = B.rowPtr[k]; kb < B.rowPtr[k + 1]; ++kb)
+			{
+				int j = B.colInd[kb];
+				if (marker[j] != i)
+				{
+					marker[j] = i;
+					accumulator[j] = 0.0;
+					rowCols.push_back(j);
+				}
+				accumulator[j] += a * B.values[kb];
+			}
+		}
+		std::sort(rowCols.begin(), rowCols.end());
+		for (int m = 0; m < (int)rowCols.size(); ++m)
+		{
+			C.colInd.push_back(rowCols[m]);
+			C.values.push_back(accumulator[rowCols[m]]);
+		}
+		C.rowPtr[i + 1] = (int)C.colInd.size();
+	}
+}
+
+
+//C = A*B, where C already holds the (sorted) pattern of the product and only its values are recomputed
+void sparseMultiplyNumeric(const SparseMatrixCSR& A, const SparseMatrixCSR& B, SparseMatrixCSR& C, int numThreads)
+{
+	assert(A.nCols == B.nRows && C.nRows == A.nRows && C.nCols == B.nCols);
+
+#pragma omp parallel num_threads(threadCount(numThreads))
+	{
+		std::vector<double> accumulator(B.nCols, 0.0);
+
+#pragma omp for
+		for (int i = 0; i < A.nRows; ++i)
+		{
+			for (int ka = A.rowPtr[i]; ka < A.rowPtr[i + 1]; ++ka)
+			{
+				int k = A.colInd[ka];
+				double a = A.values[ka];
+				for (int kb = B.rowPtr[k]; kb < B.rowPtr[k + 1]; ++kb)
+					accumulator[B.colInd[kb]] += a * B.values[kb];
+			}
+			for (int kc = C.rowPtr[i]; kc < C.rowPtr[i + 1]; ++kc)
+			{
+				C.values[kc] = accumulator[C.colInd[kc]];
+				accumulator[C.colInd[kc]] = 0.0;
+			}
+		}
+	}
+}
+
+
+HarmonicSolver::HarmonicSolver() : mSize(0), mPatternHash(0)
+{
+}
+
+HarmonicSolver::HarmonicSolver(const HarmonicSolverOptions& options) : mOptions(options), mSize(0), mPatternHash(0)
+{
+}
+
+bool HarmonicSolver::compute(const SparseMatrixCSR& A)
+{
+	if (A.nRows != A.nCols || A.nRows == 0)
+		return false;
+
+	bool reuse = (mPatternHash != 0 && patternHash(A) == mPatternHash && hasPattern(A));
+	if (!reuse && !analyzePattern(A))
+		return false;
+	if (!factorize(A))
+		return false;
+	mReport.reusedPattern = reuse;
+
+	if (mOptions.verbose)
+	{
+		std::cout << "AMG hierarchy:";
+		for (int i = 0; i < (int)mLevels.size(); ++i)
+			std::cout << " " << mLevels[i].A.nRows;
+		std::cout << (mReport.symmetric ? " (CG)" : " (BiCGSTAB)") << (reuse ? ", pattern reused\n" : "\n");
+	}
+	return true;
+}
+
+bool HarmonicSolver::analyzePattern(const SparseMatrixCSR& A)
+{
+	if (A.nRows != A.nCols || A.nRows == 0)
+		return false;
+
+	eliminateBoundaryPattern(A);
+	buildHierarchyPattern();
+	mPatternRowPtr = A.rowPtr;
+	mPatternColInd = A.colInd;
+	mPatternHash = patternHash(A);
+	return true;
+}
+
+bool HarmonicSolver::factorize(const SparseMatrixCSR& A)
+{
+	if (mPatternHash == 0 || !hasPattern(A))
+		return false;
+
+	mReport = HarmonicSolverReport();
+	eliminateBoundary(A);
+	mReport.symmetric = mLevels[0].A.isSymmetric(1e-10);
+	buildHierarchy();
+	factorCoarsest();
+	mReport.numLevels = (int)mLevels.size();
+	return true;
+}
+
+//FNV-1a over the dimensions and the index arrays
+unsigned long long HarmonicSolver::patternHash(const SparseMatrixCSR& A)
+{
+	unsigned long long hash = 14695981039346656037ULL;
+	const unsigned long long prime = 1099511628211ULL;
+
+	hash = (hash ^ (unsigned long long)A.nRows) * prime;
+	hash = (hash ^ (unsigned long long)A.nCols) * prime;
+	for (int i = 0; i < (int)A.rowPtr.size(); ++i)
+		hash = (hash ^ (unsigned long long)A.rowPtr[i]) * prime;
+	for (int i = 0; i < (int)A.colInd.size(); ++i)
+		hash = (hash ^ (unsigned long long)A.colInd[i]) * prime;
+	return hash ? hash : 1;
+}
+
+//a hash hit alone is not enough, a colliding pattern would get the scatter map and the hierarchy of another matrix
+bool HarmonicSolver::hasPattern(const SparseMatrixCSR& A) const
+{
+	return A.nRows == mSize && A.nCols == mSize && A.rowPtr == mPatternRowPtr && A.colInd == mPatternColInd;
+}
+
+int HarmonicSolver::numThreads() const
+{
+	return threadCount(mOptions.numThreads);
+}
+
+//rows which contain only a diagonal entry are Dirichlet rows (the boundary vertices of the disk map).
+//builds the patterns of the interior system and of the boundary coupling, and where every entry of A goes.
+void HarmonicSolver::eliminateBoundaryPattern(const SparseMatrixCSR& A)
+{
+	mSize = A.nRows;
+	mInteriorIndex.assign(mSize, -1);
+	mInteriorToFull.clear();
+	mBoundaryToFull.clear();
+
+	std::vector<int> boundaryIndex(mSize, -1);
+	for (int i = 0; i < mSize; ++i)
+	{
+		bool isBoundary = true;
+		for (int k = A.rowPtr[i]; k < A.rowPtr[i + 1]; ++k)
+			if (A.colInd[k] != i)
+				isBoundary = false;
+
+		if (isBoundary)
+		{
+			boundaryIndex[i] = (int)mBoundaryToFull.size();
+			mBoundaryToFull.push_back(i);
+		}
+		else
+		{
+			mInteriorIndex[i] = (int)mInteriorToFull.size();
+			mInteriorToFull.push_back(i);
+		}
+	}
+
+	int nI = (int)mInteriorToFull.size();
+	mLevels.assign(1, Level());
+	SparseMatrixCSR& K = mLevels[0].A;
+	K.clear();
+	K.nRows = K.nCols = nI;
+	mBoundaryCoupling.clear();
+	mBoundaryCoupling.nRows = nI;
+	mBoundaryCoupling.nCols = (int)mBoundaryToFull.size();
+	mRowSign.assign(nI, 1.0);
+	mScatter.assign(A.nonZeros(), -1);
+
+	for (int ii = 0; ii < nI; ++ii)
+	{
+		int i = mInteriorToFull[ii];
+		for (int k = A.rowPtr[i]; k < A.rowPtr[i + 1]; ++k)
+		{
+			int j = A.colInd[k];
+			if (mInteriorIndex[j] != -1)
+			{
+				mScatter[k] = (int)K.colInd.size();
+				K.colInd.push_back(mInteriorIndex[j]);
+			}
+			else
+			{
+				mScatter[k] = -((int)mBoundaryCoupling.colInd.size() + 2);
+				mBoundaryCoupling.colInd.push_back(boundaryIndex[j]);
+			}
+		}
+		K.rowPtr.push_back((int)K.colInd.size());
+		mBoundaryCoupling.rowPtr.push_back((int)mBoundaryCoupling.colInd.size());
+	}
+	K.values.assign(K.colInd.size(), 0.0);
+	mBoundaryCoupling.values.assign(mBoundaryCoupling.colInd.size(), 0.0);
+}
+
+//copies the values of A into the interior system and the boundary coupling
+void HarmonicSolver::eliminateBoundary(const SparseMatrixCSR& A)
+{
+	SparseMatrixCSR& K = mLevels[0].A;
+	int nI = (int)mInteriorToFull.size();
+
+#pragma omp parallel for num_threads(numThreads())
+	for (int ii = 0; ii < nI; ++ii)
+	{
+		int i = mInteriorToFull[ii];
+		double diag = 0.0;
+		for (int k = A.rowPtr[i]; k < A.rowPtr[i + 1]; ++k)
+			if (A.colInd[k] == i)
+				diag += A.values[k];
+		mRowSign[ii] = (diag < 0.0) ? -1.0 : 1.0;
+
+		for (int k = A.rowPtr[i]; k < A.rowPtr[i + 1]; ++k)
+		{
+			int target = mScatter[k];
+			if (target >= 0)
+				K.values[target] = mRowSign[ii] * A.values[k];
+			else
+				mBoundaryCoupling.values[-target - 2] = mRowSign[ii] * A.values[k];
+		}
+	}
+}
+
+//greedy aggregation on the matrix graph. it only looks at the sparsity pattern.
+void HarmonicSolver::aggregate(const SparseMatrixCSR& A, std::vector<int>& aggregates, int& numAggregates) const
+{
+	int n = A.nRows;
+	aggregates.assign(n, -1);
+	numAggregates = 0;
+
+	//pass 1 - a node whose whole neighborhood is free becomes the root of a new aggregate
+	for (int i = 0; i < n; ++i)
+	{
+		if (aggregates[i] != -1)
+			continue;
+		bool isFree = true;
+		for (int k = A.rowPtr[i]; k < A.rowPtr[i + 1]; ++k)
+			if (aggregates[A.colInd[k]] != -1)
+			{
+				isFree = false;
+				break;
+			}
+		if (!isFree)
+			continue;
+		aggregates[i] = numAggregates;
+		for (int k = A.rowPtr[i]; k < A.rowPtr[i + 1]; ++k)
+			aggregates[A.colInd[k]] = numAggregates;
+		numAggregates++;
+	}
+
+	//pass 2 - join a neighboring aggregate from pass 1
+	std::vector<int> firstPass = aggregates;
+	for (int i = 0; i < n; ++i)
+	{
+		if (aggregates[i] != -1)
+			continue;
+		for (int k = A.rowPtr[i]; k < A.rowPtr[i + 1]; ++k)
+			if (firstPass[A.colInd[k]] != -1)
+			{
+				aggregates[i] = firstPass[A.colInd[k]];
+				break;
+			}
+	}
+
+	//pass 3 - whatever is left forms aggregates with its free neighbors
+	for (int i = 0; i < n; ++i)
+	{
+		if (aggregates[i] != -1)
+			continue;
+		aggregates[i] = numAggregates;
+		for (int k = A.rowPtr[i]; k < A.rowPtr[i + 1]; ++k)
+			if (aggregates[A.colInd[k]] == -1)
+				aggregates[A.colInd[k]] = numAggregates;
+		numAggregates++;
+	}
+}
+
+//aggregates every level and builds the patterns of P, R and the coarse operators. the values are filled by buildHierarchy.
+void HarmonicSolver::buildHierarchyPattern()
+{
+	for (int level = 0; ; ++level)
+	{
+		Level& L = mLevels[level];
+		int n = L.A.nRows;
+
+		L.invDiag.assign(n, 0.0);
+		L.x.assign(2 * n, 0.0);
+		L.b.assign(2 * n, 0.0);
+		L.r.assign(2 * n, 0.0);
+
+		if (n <= mOptions.coarsestSize || level + 1 >= mOptions.maxLevels)
+			break;
+
+		std::vector<int> aggregates;
+		int numAggregates;
+		aggregate(L.A, aggregates, numAggregates);
+		if (numAggregates == 0 || numAggregates >= n)
+			break;
+
+		L.P0.nRows = n;
+		L.P0.nCols = numAggregates;
+		L.P0.rowPtr.resize(n + 1);
+		L.P0.colInd = aggregates;
+		L.P0.values.assign(n, 1.0);
+		for (int i = 0; i <= n; ++i)
+			L.P0.rowPtr[i] = i;
+
+		//the smoother S has the pattern of A, and sparseMultiply keeps structural zeros
+		sparseMultiply(L.A, L.P0, L.P);
+		L.P.transpose(L.R);
+		sparseMultiply(L.A, L.P, L.AP);
+		mLevels.push_back(Level());
+		Level& C = mLevels.back();
+		sparseMultiply(mLevels[level].R, mLevels[level].AP, C.A);
+	}
+}
+
+//smoothed aggregation: P = (I - w*D^-1*A)*P0, R = P^T, Ac = R*A*P
+void HarmonicSolver::buildHierarchy()
+{
+	for (int level = 0; level < (int)mLevels.size(); ++level)
+	{
+		Level& L = mLevels[level];
+		int n = L.A.nRows;
+
+		double rho = 0.0;
+		for (int i = 0; i < n; ++i)
+		{
+			double diag = 0.0, rowSum = 0.0;
+			for (int k = L.A.rowPtr[i]; k < L.A.rowPtr[i + 1]; ++k)
+			{
+				if (L.A.colInd[k] == i)
+					diag = L.A.values[k];
+				rowSum += std::abs(L.A.values[k]);
+			}
+			L.invDiag[i] = (diag != 0.0) ? 1.0 / diag : 0.0;
+			rho = std::max(rho, rowSum * std::abs(L.invDiag[i]));
+		}
+
+		if (level + 1 == (int)mLevels.size())
+			break;
+
+		double omega = (rho > 0.0) ? 4.0 / (3.0 * rho) : 0.0;
+		SparseMatrixCSR S = L.A;
+		for (int i = 0; i < n; ++i)
+		{
+			for (int k = S.rowPtr[i]; k < S.rowPtr[i + 1]; ++k)
+			{
+				S.values[k] *= -omega * L.invDiag[i];
+				if (S.colInd[k] == i)
+					S.values[k] += 1.0;
+			}
+		}
+		sparseMultiplyNumeric(S, L.P0, L.P, mOptions.numThreads);
+		L.P.transpose(L.R);
+		sparseMultiplyNumeric(L.A, L.P, L.AP, mOptions.numThreads);
+		sparseMultiplyNumeric(L.R, L.AP, mLevels[level + 1].A, mOptions.numThreads);
+	}
+}
+
+void HarmonicSolver::factorCoarsest()
+{
+	const SparseMatrixCSR& A = mLevels.back().A;
+	int n = A.nRows;
+	mCoarseLU.clear();
+	mCoarsePivot.clear();
+	if (n > MAX_DENSE_COARSE_SIZE)
+		return; //the coarsest level is smoothed instead of solved exactly
+
+	mCoarseLU.assign((size_t)n * n, 0.0);
+	mCoarsePivot.resize(n);
+	for (int i = 0; i < n; ++i)
+		for (int k = A.rowPtr[i]; k < A.rowPtr[i + 1]; ++k)
+			mCoarseLU[(size_t)i * n + A.colInd[k]] += A.values[k];
+
+	//LU with partial pivoting
+	for (int c = 0; c < n; ++c)
+	{
+		int pivot = c;
+		for (int r = c + 1; r < n; ++r)
+			if (std::abs(mCoarseLU[(size_t)r * n + c]) > std::abs(mCoarseLU[(size_t)pivot * n + c]))
+				pivot = r;
+		mCoarsePivot[c] = pivot;
+		if (pivot != c)
+			for (int k = 0; k < n; ++k)
+				std::swap(mCoarseLU[(size_t)c * n + k], mCoarseLU[(size_t)pivot * n + k]);
+
+		double d = mCoarseLU[(size_t)c * n + c];
+		if (d == 0.0)
+			continue;
+#pragma omp parallel for num_threads(numThreads())
+		for (int r = c + 1; r < n; ++r)
+		{
+			double f = mCoarseLU[(size_t)r * n + c] / d;
+			mCoarseLU[(size_t)r * n + c] = f;
+			if (f != 0.0)
+				for (int k = c + 1; k < n; ++k)
+					mCoarseLU[(size_t)r * n + k] -= f * mCoarseLU[(size_t)c * n + k];
+		}
+	}
+}
+
+void HarmonicSolver::solveCoarsest(const double* b, double* x) const
+{
+	const Level& L = mLevels.back();
+	int n = L.A.nRows;
+
+	if (mCoarseLU.empty())
+	{
+		std::fill(x, x + 2 * n, 0.0);
+		double* r = &L.r[0];
+		for (int s = 0; s < 10 * mOptions.smoothingSteps; ++s)
+		{
+			L.A.multiply2(x, r, mOptions.numThreads);
+			for (int i = 0; i < n; ++i)
+			{
+				x[2 * i] += JACOBI_DAMPING * L.invDiag[i] * (b[2 * i] - r[2 * i]);
+				x[2 * i + 1] += JACOBI_DAMPING * L.invDiag[i] * (b[2 * i + 1] - r[2 * i + 1]);
+			}
+		}
+		return;
+	}
+
+	std::copy(b, b + 2 * n, x);
+	for (int c = 0; c < n; ++c)
+		if (mCoarsePivot[c] != c)
+		{
+			std::swap(x[2 * c], x[2 * mCoarsePivot[c]]);
+			std::swap(x[2 * c + 1], x[2 * mCoarsePivot[c] + 1]);
+		}
+	for (int r = 0; r < n; ++r)
+		for (int k = 0; k < r; ++k)
+		{
+			double f = mCoarseLU[(size_t)r * n + k];
+			x[2 * r] -= f * x[2 * k];
+			x[2 * r + 1] -= f * x[2 * k + 1];
+		}
+	for (int r = n - 1; r >= 0; --r)
+	{
+		for (int k = r + 1; k < n; ++k)
+		{
+			double f = mCoarseLU[(size_t)r * n + k];
+			x[2 * r] -= f * x[2 * k];
+			x[2 * r + 1] -= f * x[2 * k + 1];
+		}
+		double d = mCoarseLU[(size_t)r * n + r];
+		if (d != 0.0)
+		{
+			x[2 * r] /= d;
+			x[2 * r + 1] /= d;
+		}
+	}
+}
+
+void HarmonicSolver::vCycle(int level, const double* b, double* x) const
+{
+	if (level == (int)mLevels.size() - 1)
+	{
+		solveCoarsest(b, x);
+		return;
+	}
+
+	const Level& L = mLevels[level];
+	const Level& C = mLevels[level + 1];
+	int n = L.A.nRows;
+	double* r = &L.r[0];
+
+	std::fill(x, x + 2 * n, 0.0);
+	for (int s = 0; s < 2 * mOptions.smoothingSteps + 1; ++s)
+	{
+		if (s == mOptions.smoothingSteps)
+		{
+			//coarse grid correction between the pre and post smoothing sweeps
+			L.A.multiply2(x, r, mOptions.numThreads);
+#pragma omp parallel for num_threads(numThreads())
+			for (int i = 0; i < 2 * n; ++i)
+				r[i] = b[i] - r[i];
+			L.R.multiply2(r, &C.b[0], mOptions.numThreads);
+			vCycle(level + 1, &C.b[0], &C.x[0]);
+			L.P.multiply2(&C.x[0], r, mOptions.numThreads);
+#pragma omp parallel for num_threads(numThreads())
+			for (int i = 0; i < 2 * n; ++i)
+				x[i] += r[i];
+			continue;
+		}
+
+		L.A.multiply2(x, r, mOptions.numThreads);
+#pragma omp parallel for num_threads(numThreads())
+		for (int i = 0; i < n; ++i)
+		{
+			x[2 * i] += JACOBI_DAMPING * L.invDiag[i] * (b[2 * i] - r[2 * i]);
+			x[2 * i + 1] += JACOBI_DAMPING * L.invDiag[i] * (b[2 * i + 1] - r[2 * i + 1]);
+		}
+	}
+}
+
+void HarmonicSolver::applyPreconditioner(const double* r, double* z) const
+{
+	vCycle(0, r, z);
+}
+
+bool HarmonicSolver::solve(const std::vector<double>& b, std::vector<double>& x)
+{
+	if (mLevels.empty() || (int)b.size() != 2 * mSize)
+		return false;
+
+	x.resize(2 * mSize, 0.0);
+
+	//Dirichlet values
+	for (int bi = 0; bi < (int)mBoundaryToFull.size(); ++bi)
+	{
+		int i = mBoundaryToFull[bi];
+		x[2 * i] = b[2 * i];
+		x[2 * i + 1] = b[2 * i + 1];
+	}
+
+	int nI = (int)mInteriorToFull.size();
+	if (nI == 0)
+		return true;
+
+	std::vector<double> xB(2 * mBoundaryToFull.size()), coupling(2 * nI), bI(2 * nI), xI(2 * nI);
+	for (int bi = 0; bi < (int)mBoundaryToFull.size(); ++bi)
+	{
+		xB[2 * bi] = x[2 * mBoundaryToFull[bi]];
+		xB[2 * bi + 1] = x[2 * mBoundaryToFull[bi] + 1];
+	}
+	mBoundaryCoupling.multiply2(&xB[0], &coupling[0], mOptions.numThreads);
+	for (int ii = 0; ii < nI; ++ii)
+	{
+		int i = mInteriorToFull[ii];
+		bI[2 * ii] = mRowSign[ii] * b[2 * i] - coupling[2 * ii];
+		bI[2 * ii + 1] = mRowSign[ii] * b[2 * i + 1] - coupling[2 * ii + 1];
+		xI[2 * ii] = x[2 * i];
+		xI[2 * ii + 1] = x[2 * i + 1];
+	}
+
+	bool res = mReport.symmetric ? conjugateGradient(bI, xI) : biCGStab(bI, xI);
+
+	for (int ii = 0; ii < nI; ++ii)
+	{
+		int i = mInteriorToFull[ii];
+		x[2 * i] = xI[2 * ii];
+		x[2 * i + 1] = xI[2 * ii + 1];
+	}
+
+	if (mOptions.verbose)
+		std::cout << "Harmonic solver: " << mReport.iterations << " iterations, relative residual ("
+			<< mReport.residual[0] << "," << mReport.residual[1] << ")\n";
+	return res;
+}
+
+bool HarmonicSolver::conjugateGradient(const std::vector<double>& b, std::vector<double>& x)
+{
+	const SparseMatrixCSR& A = mLevels[0].A;
+	int n = A.nRows;
+	std::vector<double> r(2 * n), z(2 * n), p(2 * n), q(2 * n);
+	double bNorm[2], rNorm[2], rz[2], rzNew[2], pq[2], alpha[2], minusAlpha[2];
+	bool done[2];
+
+	dot2(&b[0], &b[0], n, bNorm, mOptions.numThreads);
+	A.multiply2(&x[0], &r[0], mOptions.numThreads);
+#pragma omp parallel for num_threads(numThreads())
+	for (int i = 0; i < 2 * n; ++i)
+		r[i] = b[i] - r[i];
+
+	applyPreconditioner(&r[0], &z[0]);
+	p = z;
+	dot2(&r[0], &z[0], n, rz, mOptions.numThreads);
+
+	int it = 0;
+	for (; it < mOptions.maxIterations; ++it)
+	{
+		dot2(&r[0], &r[0], n, rNorm, mOptions.numThreads);
+		for (int c = 0; c < 2; ++c)
+		{
+			mReport.residual[c] = (bNorm[c] > 0.0) ? std::sqrt(rNorm[c] / bNorm[c]) : std::sqrt(rNorm[c]);
+			done[c] = mReport.residual[c] <= mOptions.tolerance;
+		}
+		if (done[0] && done[1])
+			break;
+
+		A.multiply2(&p[0], &q[0], mOptions.numThreads);
+		dot2(&p[0], &q[0], n, pq, mOptions.numThreads);
+		for (int c = 0; c < 2; ++c)
+		{
+			alpha[c] = (done[c] || pq[c] == 0.0) ? 0.0 : rz[c] / pq[c];
+			minusAlpha[c] = -alpha[c];
+		}
+		axpy2(alpha, &p[0], &x[0], n, mOptions.numThreads);
+		axpy2(minusAlpha, &q[0], &r[0], n, mOptions.numThreads);
+
+		applyPreconditioner(&r[0], &z[0]);
+		dot2(&r[0], &z[0], n, rzNew, mOptions.numThreads);
+#pragma omp parallel for num_threads(numThreads())
+		for (int i = 0; i < n; ++i)
+		{
+			for (int c = 0; c < 2; ++c)
+			{
+				double beta = (done[c] || rz[c] == 0.0) ? 0.0 : rzNew[c] / rz[c];
+				p[2 * i + c] = z[2 * i + c] + beta * p[2 * i + c];
+			}
+		}
+		rz[0] = rzNew[0];
+		rz[1] = rzNew[1];
+	}
+
+	mReport.iterations = it;
+	mReport.converged = (mReport.residual[0] <= mOptions.tolerance) && (mReport.residual[1] <= mOptions.tolerance);
+	return mReport.converged;
+}
+
+//right preconditioned BiCGSTAB, used for non symmetric weights (mean value coordinates)
+bool HarmonicSolver::biCGStab(const std::vector<double>& b, std::vector<double>& x)
+{
+	const SparseMatrixCSR& A = mLevels[0].A;
+	int n = A.nRows;
+	std::vector<double> r(2 * n), r0(2 * n), p(2 * n, 0.0), v(2 * n, 0.0), s(2 * n), t(2 * n), pHat(2 * n), sHat(2 * n);
+	double bNorm[2], rNorm[2], rho[2] = { 1.0, 1.0 }, alpha[2] = { 1.0, 1.0 }, omega[2] = { 1.0, 1.0 };
+	double rhoNew[2], r0v[2], ts[2], tt[2];
+	bool done[2];
+
+	dot2(&b[0], &b[0], n, bNorm, mOptions.numThreads);
+	A.multiply2(&x[0], &r[0], mOptions.numThreads);
+#pragma omp parallel for num_threads(numThreads())
+	for (int i = 0; i < 2 * n; ++i)
+		r[i] = b[i] - r[i];
+	r0 = r;
+
+	int it = 0;
+	for (; it < mOptions.maxIterations; ++it)
+	{
+		dot2(&r[0], &r[0], n, rNorm, mOptions.numThreads);
+		for (int c = 0; c < 2; ++c)
+		{
+			mReport.residual[c] = (bNorm[c] > 0.0) ? std::sqrt(rNorm[c] / bNorm[c]) : std::sqrt(rNorm[c]);
+			done[c] = mReport.residual[c] <= mOptions.tolerance;
+		}
+		if (done[0] && done[1])
+			break;
+
+		dot2(&r0[0], &r[0], n, rhoNew, mOptions.numThreads);
+#pragma omp parallel for num_threads(numThreads())
+		for (int i = 0; i < n; ++i)
+		{
+			for (int c = 0; c < 2; ++c)
+			{
+				if (done[c])
+					continue;
+				double beta = (rho[c] == 0.0 || omega[c] == 0.0) ? 0.0 : (rhoNew[c] / rho[c]) * (alpha[c] / omega[c]);
+				p[2 * i + c] = r[2 * i + c] + beta * (p[2 * i + c] - omega[c] * v[2 * i + c]);
+			}
+		}
+		applyPreconditioner(&p[0], &pHat[0]);
+		A.multiply2(&pHat[0], &v[0], mOptions.numThreads);
+		dot2(&r0[0], &v[0], n, r0v, mOptions.numThreads);
+		for (int c = 0; c < 2; ++c)
+		{
+			alpha[c] = (done[c] || r0v[c] == 0.0) ? 0.0 : rhoNew[c] / r0v[c];
+			rho[c] = rhoNew[c];
+		}
+#pragma omp parallel for num_threads(numThreads())
+		for (int i = 0; i < n; ++i)
+			for (int c = 0; c < 2; ++c)
+				s[2 * i + c] = r[2 * i + c] - alpha[c] * v[2 * i + c];
+
+		applyPreconditioner(&s[0], &sHat[0]);
+		A.multiply2(&sHat[0], &t[0], mOptions.numThreads);
+		dot2(&t[0], &s[0], n, ts, mOptions.numThreads);
+		dot2(&t[0], &t[0], n, tt, mOptions.numThreads);
+		for (int c = 0; c < 2; ++c)
+			omega[c] = (done[c] || tt[c] == 0.0) ? 0.0 : ts[c] / tt[c];
+
+#pragma omp parallel for num_threads(numThreads())
+		for (int i = 0; i < n; ++i)
+		{
+			for (int c = 0; c < 2; ++c)
+			{
+				x[2 * i + c] += alpha[c] * pHat[2 * i + c] + omega[c] * sHat[2 * i + c];
+				r[2 * i + c] = s[2 * i + c] - omega[c] * t[2 * i + c];
+			}
+		}
+	}
+
+	mReport.iterations = it;
+	mReport.converged = (mReport.residual[0] <= mOptions.tolerance) && (mReport.residual[1] <= mOptions.tolerance);
+	return mReport.converged;
+}
+
+
+
+HarmonicSolver& HarmonicSolverCache::solver(const SparseMatrixCSR& A, const HarmonicSolverOptions& options)
+{
+	unsigned long long hash = HarmonicSolver::patternHash(A);
+	for (std::list<HarmonicSolver>::iterator it = mSolvers.begin(); it != mSolvers.end(); ++it)
+	{
+		if (it->analyzedPatternHash() == hash && it->hasPattern(A))
+		{
+			mSolvers.splice(mSolvers.begin(), mSolvers, it);
+			mSolvers.front().options() = options;
+			mNumHits++;
+			return mSolvers.front();
+		}
+	}
+
+	mNumMisses++;
+	while (!mSolvers.empty() && (int)mSolvers.size() >= (std::max)(mCapacity, 1))
+		mSolvers.pop_back();
+	mSolvers.push_front(HarmonicSolver(options));
+	return mSolvers.front();
+}
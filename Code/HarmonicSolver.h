@@ -0,0 +1,164 @@
+#pragma once
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Native iterative solver for the disk map systems built by HarmonicFlattening.
+// The boundary rows of the system (a single unit diagonal entry) are eliminated, the remaining interior
+// system is solved with conjugate gradients (BiCGSTAB when the weights are not symmetric, e.g. mean value)
+// preconditioned by an aggregation based algebraic multigrid V-cycle.
+// The x and y columns of the map are stored interleaved and are solved simultaneously, so every sweep
+// over the matrix serves both columns.
+// The setup is split into a symbolic phase (boundary elimination, aggregation and the patterns of all the
+// level operators), which depends only on the sparsity pattern, and a numeric phase. The symbolic phase is
+// redone only when the pattern changes (the hash, and on a hash hit the index arrays themselves), so a solver
+// reused on meshes with the same connectivity only pays for the numeric phase. HarmonicSolverCache keeps the
+// analyzed solvers of a caller by pattern.
+// The parallel regions run options().numThreads threads, the thread count of the rest of the process is not
+// changed.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <list>
+#include <vector>
+
+
+struct SparseMatrixCSR
+{
+	SparseMatrixCSR() : nRows(0), nCols(0) { rowPtr.push_back(0); }
+
+	int nRows, nCols;
+	std::vector<int> rowPtr; //size nRows + 1
+	std::vector<int> colInd;
+	std::vector<double> values;
+
+	int nonZeros() const { return (int)colInd.size(); }
+	void clear();
+	void multiply2(const double* x, double* y, int numThreads = 0) const; //y = A*x, where x and y hold two interleaved columns
+	void transpose(SparseMatrixCSR& t) const;
+	bool isSymmetric(double relativeTolerance) const;
+};
+
+
+struct HarmonicSolverOptions
+{
+	HarmonicSolverOptions();
+
+	double tolerance; //relative residual ||b - Ax|| / ||b|| required from each column
+	int maxIterations;
+	int numThreads; //0 - keep the OpenMP default
+	int coarsestSize; //stop coarsening once a level has at most this many unknowns
+	int maxLevels;
+	int smoothingSteps; //damped Jacobi sweeps before and after the coarse grid correction
+	bool verbose;
+};
+
+
+struct HarmonicSolverReport
+{
+	HarmonicSolverReport() : iterations(0), numLevels(0), symmetric(true), converged(false), reusedPattern(false) { residual[0] = residual[1] = 0.0; }
+
+	int iterations;
+	int numLevels;
+	bool symmetric;
+	bool converged;
+	bool reusedPattern; //the last compute() skipped the symbolic phase
+	double residual[2];
+};
+
+
+class HarmonicSolver
+{
+	struct Level
+	{
+		SparseMatrixCSR A, P, R;
+		SparseMatrixCSR P0, AP; //tentative prolongation and A*P, kept for the numeric phase
+		std::vector<double> invDiag;
+		mutable std::vector<double> x, b, r; //work vectors (two interleaved columns)
+	};
+
+public:
+
+	HarmonicSolver();
+	HarmonicSolver(const HarmonicSolverOptions& options);
+
+	HarmonicSolverOptions& options() { return mOptions; }
+	const HarmonicSolverReport& report() const { return mReport; }
+
+	//builds the interior system and the multigrid hierarchy. returns false if the matrix is not square.
+	//the symbolic phase is skipped if A has the same pattern as the matrix of the previous call.
+	bool compute(const SparseMatrixCSR& A);
+
+	//symbolic and numeric phases of compute(). factorize() requires a matrix with the analyzed pattern.
+	bool analyzePattern(const SparseMatrixCSR& A);
+	bool factorize(const SparseMatrixCSR& A);
+
+	static unsigned long long patternHash(const SparseMatrixCSR& A);
+	unsigned long long analyzedPatternHash() const { return mPatternHash; }
+	//true if A has exactly the pattern of the analyzed matrix
+	bool hasPattern(const SparseMatrixCSR& A) const;
+
+	//b and x are n x 2 arrays stored row by row (x0, y0, x1, y1, ...). x is used as the initial guess.
+	bool solve(const std::vector<double>& b, std::vector<double>& x);
+
+protected:
+
+	void eliminateBoundaryPattern(const SparseMatrixCSR& A);
+	void eliminateBoundary(const SparseMatrixCSR& A);
+	void buildHierarchyPattern();
+	void buildHierarchy();
+	void aggregate(const SparseMatrixCSR& A, std::vector<int>& aggregates, int& numAggregates) const;
+	void factorCoarsest();
+	int numThreads() const;
+	void solveCoarsest(const double* b, double* x) const;
+	void vCycle(int level, const double* b, double* x) const;
+	void applyPreconditioner(const double* r, double* z) const;
+	bool conjugateGradient(const std::vector<double>& b, std::vector<double>& x);
+	bool biCGStab(const std::vector<double>& b, std::vector<double>& x);
+
+protected:
+
+	HarmonicSolverOptions mOptions;
+	HarmonicSolverReport mReport;
+
+	int mSize; //size of the full system
+	unsigned long long mPatternHash; //pattern of the analyzed matrix, 0 - nothing analyzed yet
+	std::vector<int> mPatternRowPtr, mPatternColInd; //the analyzed pattern, compared on a hash hit
+	std::vector<int> mScatter; //entry of A -> entry of K (>= 0), entry -(e + 2) of the boundary coupling or -1
+	SparseMatrixCSR mBoundaryCoupling; //interior rows, boundary columns (already multiplied by the row sign)
+	std::vector<int> mInteriorIndex; //full index -> interior index or -1 for boundary rows
+	std::vector<int> mInteriorToFull;
+	std::vector<int> mBoundaryToFull;
+	std::vector<double> mRowSign; //interior rows are flipped so that the diagonal is positive
+	std::vector<Level> mLevels;
+	std::vector<double> mCoarseLU; //dense LU of the coarsest level (row major)
+	std::vector<int> mCoarsePivot;
+};
+
+
+//analyzed solvers of one caller, the most recently used first. main keeps one for the whole run and hands it to
+//solveHarmonicMap and to the native workspace, so mapping one source to several targets analyzes the source system
+//once. It is not synchronized, callers on other threads keep their own cache.
+class HarmonicSolverCache
+{
+public:
+
+	HarmonicSolverCache(int capacity = 4) : mCapacity(capacity), mNumHits(0), mNumMisses(0) {}
+
+	//the solver analyzed for the pattern of A, or a new solver in place of the least recently used one. the options
+	//are set in both cases, compute() then only redoes the numeric phase for a known pattern.
+	HarmonicSolver& solver(const SparseMatrixCSR& A, const HarmonicSolverOptions& options);
+	void clear() { mSolvers.clear(); }
+	int size() const { return (int)mSolvers.size(); }
+	int numHits() const { return mNumHits; } //lookups which found a solver analyzed for the pattern
+	int numMisses() const { return mNumMisses; }
+
+protected:
+
+	int mCapacity;
+	int mNumHits, mNumMisses;
+	std::list<HarmonicSolver> mSolvers;
+};
+
+
+void sparseMultiply(const SparseMatrixCSR& A, const SparseMatrixCSR& B, SparseMatrixCSR& C);
+void sparseMultiplyNumeric(const SparseMatrixCSR& A, const SparseMatrixCSR& B, SparseMatrixCSR& C, int numThreads = 0); //C already holds the pattern of A*B
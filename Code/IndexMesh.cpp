@@ -0,0 +1,82 @@
+#include "stdafx.h"
+
+
+void IndexMesh::assign(const Mesh& mesh)
+{
+	int numHalfedges = (int)mesh.size_of_halfedges();
+	mNext.resize(numHalfedges);
+	mTwin.resize(numHalfedges);
+	mVertex.resize(numHalfedges);
+	mFace.resize(numHalfedges);
+	for_each_const_halfedge(h, mesh)
+	{
+		int i = h->index();
+		mNext[i] = h->next()->index();
+		mTwin[i] = h->opposite()->index();
+		mVertex[i] = h->vertex()->index();
+		mFace[i] = h->is_border() ? -1 : h->facet()->index();
+	}
+
+	int numVertices = (int)mesh.size_of_vertices();
+	mVertexHalfedge.resize(numVertices);
+	mPoints.resize(numVertices);
+	mUVs.resize(numVertices);
+	for_each_const_vertex(v, mesh)
+	{
+		int i = v->index();
+		mVertexHalfedge[i] = v->halfedge()->index();
+		mPoints[i] = v->point();
+		mUVs[i] = v->uv();
+	}
+
+	mFaceHalfedge.resize(mesh.size_of_facets());
+	for_each_const_facet(f, mesh)
+		mFaceHalfedge[f->index()] = f->halfedge()->index();
+	updateBorderVertices();
+}
+
+void IndexMesh::updateBorderVertices()
+{
+	mIsBorderVertex.assign(numVertices(), 0);
+	for (int h = 0; h < numHalfedges(); ++h)
+		if (mFace[h] == -1)
+			mIsBorderVertex[mVertex[h]] = 1;
+}
+
+void IndexMesh::getVertices(int f, int v[3]) const
+{
+	int h = mFaceHalfedge[f];
+	v[0] = source(h);
+	v[1] = mVertex[h];
+	v[2] = mVertex[mNext[h]];
+}
+
+bool IndexMesh::getBorderHalfedges(std::vector<int>& borderHalfedges) const
+{
+	borderHalfedges.clear();
+
+	//the first edge (pair of halfedges) on the border
+	int first = -1;
+	for (int h = 0; h < numHalfedges() && first == -1; ++h)
+	{
+		if (isBorder(h))
+			first = h;
+		else if (isBorder(mTwin[h]))
+			first = mTwin[h];
+	}
+	if (first == -1)
+		return false;
+
+	int h = first;
+	do
+	{
+		borderHalfedges.push_back(h);
+		h = mNext[h];
+	} while (h != first);
+
+	int numBorder = 0;
+	for (int h = 0; h < numHalfedges(); ++h)
+		if (isBorder(h))
+			numBorder++;
+	return (numBorder == (int)borderHalfedges.size());
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Halfedge mesh kept as arrays indexed by int (structure of arrays): for every halfedge the next halfedge, the
+// twin, the vertex it points to and its face (-1 on the border), the positions and the uvs of the vertices.
+// It is a read only copy of a Mesh (assign) for HarmonicFlattening and setBoundaryUV, and keeps the indices of the Mesh
+// (updateAllGlobalIndices), so the border loop and the circulations are the ones of the Mesh.
+// Traversals read the arrays instead of following the pointers of the polyhedron, and loops over the vertices or
+// faces are plain index loops.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <vector>
+
+
+class IndexMesh
+{
+public:
+
+	IndexMesh() {}
+
+	//the indices of the mesh must be up to date (updateAllGlobalIndices)
+	void assign(const Mesh& mesh);
+
+	int numVertices() const { return (int)mPoints.size(); }
+	int numFaces() const { return (int)mFaceHalfedge.size(); }
+	int numHalfedges() const { return (int)mNext.size(); }
+
+	int next(int h) const { return mNext[h]; }
+	int twin(int h) const { return mTwin[h]; }
+	int vertex(int h) const { return mVertex[h]; } //the vertex h points to
+	int source(int h) const { return mVertex[mTwin[h]]; }
+	int face(int h) const { return mFace[h]; }
+	bool isBorder(int h) const { return (mFace[h] == -1); }
+	int nextAroundVertex(int h) const { return mTwin[mNext[h]]; } //the next halfedge which points to vertex(h)
+	double length(int h) const { return std::sqrt(CGAL::squared_distance(mPoints[vertex(h)], mPoints[source(h)])); }
+
+	int vertexHalfedge(int v) const { return mVertexHalfedge[v]; } //a halfedge which points to v
+	bool isBorderVertex(int v) const { return (mIsBorderVertex[v] != 0); }
+	const Kernel::Point_3& point(int v) const { return mPoints[v]; }
+	const Point_3& uv(int v) const { return mUVs[v]; }
+	Point_3& uv(int v) { return mUVs[v]; }
+
+	int faceHalfedge(int f) const { return mFaceHalfedge[f]; }
+	//the vertices of the face in the order of FaceBase::getVertices
+	void getVertices(int f, int v[3]) const;
+
+	//the halfedges of the border loop, in order. it starts at the first edge on the border, as Mesh::getBorderHalfEdges.
+	//returns false if there is no border or more than one border loop.
+	bool getBorderHalfedges(std::vector<int>& borderHalfedges) const;
+
+protected:
+
+	void updateBorderVertices();
+
+protected:
+
+	std::vector<int> mNext, mTwin, mVertex, mFace;	//per halfedge
+	std::vector<int> mVertexHalfedge;				//per vertex
+	std::vector<char> mIsBorderVertex;
+	std::vector<Kernel::Point_3> mPoints;
+	std::vector<Point_3> mUVs;
+	std::vector<int> mFaceHalfedge;					//per face
+};
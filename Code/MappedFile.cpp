@@ -0,0 +1,121 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+
+#ifdef _WIN32
+
+MappedFile::MappedFile() : mData(NULL), mSize(0), mFile(INVALID_HANDLE_VALUE), mMapping(NULL)
+{
+}
+
+bool MappedFile::open(const std::string& filename, std::string& error)
+{
+	close();
+	mFile = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (mFile == INVALID_HANDLE_VALUE)
+	{
+		error = "could not open " + filename;
+		return false;
+	}
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(mFile, &size))
+	{
+		error = "could not get the size of " + filename;
+		close();
+		return false;
+	}
+	mSize = (size_t)size.QuadPart;
+	if (mSize == 0)
+		return true;
+
+	mMapping = CreateFileMappingA(mFile, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mMapping != NULL)
+		mData = (const char*)MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0);
+	if (mData == NULL)
+	{
+		error = "could not map " + filename;
+		close();
+		return false;
+	}
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (mData != NULL)
+		UnmapViewOfFile(mData);
+	if (mMapping != NULL)
+		CloseHandle(mMapping);
+	if (mFile != INVALID_HANDLE_VALUE)
+		CloseHandle(mFile);
+	mData = NULL;
+	mSize = 0;
+	mMapping = NULL;
+	mFile = INVALID_HANDLE_VALUE;
+}
+
+#else
+
+MappedFile::MappedFile() : mData(NULL), mSize(0), mFile(-1)
+{
+}
+
+bool MappedFile::open(const std::string& filename, std::string& error)
+{
+	close();
+	mFile = ::open(filename.c_str(), O_RDONLY);
+	if (mFile == -1)
+	{
+		error = "could not open " + filename + ": " + strerror(errno);
+		return false;
+	}
+	struct stat info;
+	if (fstat(mFile, &info) != 0)
+	{
+		error = "could not get the size of " + filename + ": " + strerror(errno);
+		close();
+		return false;
+	}
+	mSize = (size_t)info.st_size;
+	if (mSize == 0)
+		return true;
+
+	void* data = mmap(NULL, mSize, PROT_READ, MAP_PRIVATE, mFile, 0);
+	if (data == MAP_FAILED)
+	{
+		error = "could not map " + filename + ": " + strerror(errno);
+		close();
+		return false;
+	}
+	mData = (const char*)data;
+	madvise(data, mSize, MADV_SEQUENTIAL);
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (mData != NULL)
+		munmap((void*)mData, mSize);
+	if (mFile != -1)
+		::close(mFile);
+	mData = NULL;
+	mSize = 0;
+	mFile = -1;
+}
+
+#endif
+
+MappedFile::~MappedFile()
+{
+	close();
+}
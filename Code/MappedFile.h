@@ -0,0 +1,43 @@
+#pragma once
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Read only memory mapping of a whole file (mmap, or a file mapping on Windows). The file stays mapped until
+// close or the destructor. An empty file maps to data() == NULL and size() == 0.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <string>
+#include <cstddef>
+
+
+class MappedFile
+{
+public:
+
+	MappedFile();
+	~MappedFile();
+
+	//on failure returns false and sets error
+	bool open(const std::string& filename, std::string& error);
+	void close();
+
+	const char* data() const { return mData; }
+	size_t size() const { return mSize; }
+
+private:
+
+	MappedFile(const MappedFile&);
+	MappedFile& operator=(const MappedFile&);
+
+private:
+
+	const char* mData;
+	size_t mSize;
+#ifdef _WIN32
+	void* mFile;
+	void* mMapping;
+#else
+	int mFile;
+#endif
+};
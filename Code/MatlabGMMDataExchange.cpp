@@ -2,36 +2,113 @@
 
 #include "MatlabGMMDataExchange.h"
 #include "MatlabInterface.h"
+#include "NativeWorkspace.h"
 
 #include <string>
 #include <vector>
 #include <algorithm>
 
 
+//the native workspace (NativeWorkspace) stands in for the engine when it is active. built without MATLAB
+//(NO_MATLAB) the engine paths are compiled out and fail.
+
+//a dense gmm matrix is a std::vector of its entries column by column, the workspace hands its buffer over and
+//forgets the variable (every result of the pipeline is read once)
+template <class Matrix, class T>
+static int getNativeDense(const char* name, Matrix& A, std::vector<T> NativeVariable::*values)
+{
+	const NativeVariable* var = NativeWorkspace::Get().find(name);
+	if(var == NULL || var->isSparse || (var->*values).size() != (size_t)var->nRows * var->nCols)
+	{
+		return -1;
+	}
+	NativeVariable taken;
+	NativeWorkspace::Get().take(name, taken);
+	A.resize(taken.nRows, taken.nCols);
+	static_cast<std::vector<T>&>(A).swap(taken.*values);
+	return 0;
+}
+
+template <class Matrix, class T>
+static int getNativeSparse(const char* name, Matrix& A, std::vector<T> NativeVariable::*values)
+{
+	const NativeVariable* var = NativeWorkspace::Get().find(name);
+	if(var == NULL || !var->isSparse || (var->*values).size() != var->cols.size())
+	{
+		return -1;
+	}
+	A.resize(var->nRows, var->nCols);
+	for(int i = 0; i < var->nRows; i++)
+	{
+		for(int k = var->rowPtr[i]; k < var->rowPtr[i + 1]; k++)
+		{
+			A(i, var->cols[k]) = (var->*values)[k];
+		}
+	}
+	return 0;
+}
+
+//the index types of the gmm matrix differ from the workspace, the arrays are converted
+template <class Matrix, class T>
+static int getNativeCompressed(const char* name, Matrix& A, std::vector<T> NativeVariable::*values)
+{
+	const NativeVariable* var = NativeWorkspace::Get().find(name);
+	if(var == NULL || !var->isSparse || (var->*values).size() != var->cols.size())
+	{
+		return -1;
+	}
+	A.nr = var->nRows;
+	A.nc = var->nCols;
+	A.jc.assign(var->rowPtr.begin(), var->rowPtr.end());
+	A.ir.assign(var->cols.begin(), var->cols.end());
+	A.pr = (var->*values);
+	return 0;
+}
+
 
 
 int MatlabGMMDataExchange::SetEngineDenseMatrix(const char* name, GMMDenseColMatrix& A)
 {
+	std::lock_guard<std::recursive_mutex> lock(MatlabInterface::EngineMutex());
 	if(A.ncols() == 0 || A.nrows() == 0)
 	{
 		return -1;
 	}
+	if(NativeWorkspace::IsActive())
+	{
+		NativeWorkspace::Get().setDense(name, A.nrows(), A.ncols(), &A.front());
+		return 0;
+	}
+#ifdef NO_MATLAB
+	return -1;
+#else
 	MatlabInterface& matlab = MatlabInterface::GetEngine();
 	int res = matlab.SetEngineRealMatrix(name, A.nrows(), A.ncols(), &A.front(), true);
 	return res;
+#endif
 }
 
 
 
 int MatlabGMMDataExchange::SetEngineDenseMatrix(const char* name, GMMDenseComplexColMatrix& A)
 {
+	std::lock_guard<std::recursive_mutex> lock(MatlabInterface::EngineMutex());
 	if(A.ncols() == 0 || A.nrows() == 0)
 	{
 		return -1;
 	}
+	if(NativeWorkspace::IsActive())
+	{
+		NativeWorkspace::Get().setDense(name, A.nrows(), A.ncols(), &A.front());
+		return 0;
+	}
+#ifdef NO_MATLAB
+	return -1;
+#else
 	MatlabInterface& matlab = MatlabInterface::GetEngine();
 	int res = matlab.SetEngineComplexMatrix(name, A.nrows(), A.ncols(), &A.front(), true);
 	return res;
+#endif
 }
 
 
@@ -39,6 +116,7 @@ int MatlabGMMDataExchange::SetEngineDenseMatrix(const char* name, GMMDenseComple
 
 int MatlabGMMDataExchange::SetEngineSparseMatrix(const char* name, GMMSparseRowMatrix& A)
 {
+	std::lock_guard<std::recursive_mutex> lock(MatlabInterface::EngineMutex());
 	int nRows = A.nrows();
 	int nCols = A.ncols();
 
@@ -65,6 +143,15 @@ int MatlabGMMDataExchange::SetEngineSparseMatrix(const char* name, GMMSparseRowM
 		}
 	}
 
+	if(NativeWorkspace::IsActive())
+	{
+		NativeWorkspace::Get().setSparse(name, nRows, nCols, iv, jv, dv);
+		return 0;
+	}
+
+#ifdef NO_MATLAB
+	return -1;
+#else
 	MatlabInterface& matlab = MatlabInterface::GetEngine();
 
 	if(dv.size() == 0)
@@ -75,6 +162,7 @@ int MatlabGMMDataExchange::SetEngineSparseMatrix(const char* name, GMMSparseRowM
 
 	int res = matlab.SetEngineSparseRealMatrix(name, iv.size(), &iv[0], &jv[0], &dv[0], nRows, nCols);
 	return res;
+#endif
 }
 
 
@@ -82,6 +170,7 @@ int MatlabGMMDataExchange::SetEngineSparseMatrix(const char* name, GMMSparseRowM
 
 int MatlabGMMDataExchange::SetEngineSparseMatrix(const char* name, GMMSparseComplexRowMatrix& A)
 {
+	std::lock_guard<std::recursive_mutex> lock(MatlabInterface::EngineMutex());
 	int nRows = A.nrows();
 	int nCols = A.ncols();
 
@@ -108,6 +197,15 @@ int MatlabGMMDataExchange::SetEngineSparseMatrix(const char* name, GMMSparseComp
 		}
 	}
 
+	if(NativeWorkspace::IsActive())
+	{
+		NativeWorkspace::Get().setSparse(name, nRows, nCols, iv, jv, dv);
+		return 0;
+	}
+
+#ifdef NO_MATLAB
+	return -1;
+#else
 	MatlabInterface& matlab = MatlabInterface::GetEngine();
 
 	if(dv.size() == 0)
@@ -118,14 +216,24 @@ int MatlabGMMDataExchange::SetEngineSparseMatrix(const char* name, GMMSparseComp
 
 	int res = matlab.SetEngineSparseComplexMatrix(name, iv.size(), &iv[0], &jv[0], &dv[0], nRows, nCols);
 	return res;
+#endif
 }
 
 
 int MatlabGMMDataExchange::GetEngineDenseMatrix(const char* name, GMMDenseComplexColMatrix& A)
 {
+	std::lock_guard<std::recursive_mutex> lock(MatlabInterface::EngineMutex());
+	if(NativeWorkspace::IsActive())
+	{
+		return getNativeDense(name, A, &NativeVariable::complex);
+	}
+
 	unsigned int m = 0;
 	unsigned int n = 0;
 
+#ifdef NO_MATLAB
+	return -1;
+#else
 	MatlabInterface& matlab = MatlabInterface::GetEngine();
 
 	bool matrixExists = matlab.GetMatrixDimensions(name, m, n);
@@ -139,14 +247,24 @@ int MatlabGMMDataExchange::GetEngineDenseMatrix(const char* name, GMMDenseComple
 	int res = matlab.GetEngineComplexMatrix(name, m, n, &A.front(), true);
 
 	return res;
+#endif
 }
 
 
 int MatlabGMMDataExchange::GetEngineDenseMatrix(const char* name, GMMDenseColMatrix& A)
 {
+	std::lock_guard<std::recursive_mutex> lock(MatlabInterface::EngineMutex());
+	if(NativeWorkspace::IsActive())
+	{
+		return getNativeDense(name, A, &NativeVariable::real);
+	}
+
 	unsigned int m = 0;
 	unsigned int n = 0;
 
+#ifdef NO_MATLAB
+	return -1;
+#else
 	MatlabInterface& matlab = MatlabInterface::GetEngine();
 
 	bool matrixExists = matlab.GetMatrixDimensions(name, m, n);
@@ -160,6 +278,7 @@ int MatlabGMMDataExchange::GetEngineDenseMatrix(const char* name, GMMDenseColMat
 	int res = matlab.GetEngineRealMatrix(name, m, n, &A.front(), true);
 
 	return res;
+#endif
 }
 
 
@@ -167,11 +286,20 @@ int MatlabGMMDataExchange::GetEngineDenseMatrix(const char* name, GMMDenseColMat
 
 int MatlabGMMDataExchange::GetEngineSparseMatrix(const char* name, GMMSparseRowMatrix& A)
 {
+	std::lock_guard<std::recursive_mutex> lock(MatlabInterface::EngineMutex());
+	if(NativeWorkspace::IsActive())
+	{
+		return getNativeSparse(name, A, &NativeVariable::real);
+	}
+
 	std::vector<unsigned int> rowind;
 	std::vector<unsigned int> colind;
 	std::vector<double> vals;
 	unsigned int m, n, nentries;
 
+#ifdef NO_MATLAB
+	return -1;
+#else
 	MatlabInterface& matlab = MatlabInterface::GetEngine();
 
 	int res = matlab.GetSparseRealMatrix(name, rowind, colind, vals, nentries, m, n);
@@ -184,16 +312,26 @@ int MatlabGMMDataExchange::GetEngineSparseMatrix(const char* name, GMMSparseRowM
 	}
 
 	return 0;
+#endif
 }
 
 
 int MatlabGMMDataExchange::GetEngineSparseMatrix(const char* name, GMMSparseComplexRowMatrix& A)
 {
+	std::lock_guard<std::recursive_mutex> lock(MatlabInterface::EngineMutex());
+	if(NativeWorkspace::IsActive())
+	{
+		return getNativeSparse(name, A, &NativeVariable::complex);
+	}
+
 	std::vector<unsigned int> rowind;
 	std::vector<unsigned int> colind;
 	std::vector<std::complex<double> > vals;
 	unsigned int m, n, nentries;
 
+#ifdef NO_MATLAB
+	return -1;
+#else
 	MatlabInterface& matlab = MatlabInterface::GetEngine();
 	
 	int res = matlab.GetSparseComplexMatrix(name, rowind, colind, vals, nentries, m, n);
@@ -206,6 +344,7 @@ int MatlabGMMDataExchange::GetEngineSparseMatrix(const char* name, GMMSparseComp
 	}
 
 	return 0;
+#endif
 }
 
 
@@ -213,6 +352,15 @@ int MatlabGMMDataExchange::GetEngineSparseMatrix(const char* name, GMMSparseComp
 
 int MatlabGMMDataExchange::GetEngineCompressedSparseMatrix(const char* name, GMMCompressed0RowMatrix& A)
 {
+	std::lock_guard<std::recursive_mutex> lock(MatlabInterface::EngineMutex());
+	if(NativeWorkspace::IsActive())
+	{
+		return getNativeCompressed(name, A, &NativeVariable::real);
+	}
+
+#ifdef NO_MATLAB
+	return -1;
+#else
 	MatlabInterface& matlab = MatlabInterface::GetEngine();
 
 	unsigned int m, n;
@@ -227,12 +375,22 @@ int MatlabGMMDataExchange::GetEngineCompressedSparseMatrix(const char* name, GMM
 	{
 		return -1;
 	}
+#endif
 }
 
 
 
 int MatlabGMMDataExchange::GetEngineCompressedSparseMatrix(const char* name, GMMCompressed0ComplexRowMatrix& A)
 {
+	std::lock_guard<std::recursive_mutex> lock(MatlabInterface::EngineMutex());
+	if(NativeWorkspace::IsActive())
+	{
+		return getNativeCompressed(name, A, &NativeVariable::complex);
+	}
+
+#ifdef NO_MATLAB
+	return -1;
+#else
 	MatlabInterface& matlab = MatlabInterface::GetEngine();
 
 	unsigned int m, n;
@@ -247,5 +405,6 @@ int MatlabGMMDataExchange::GetEngineCompressedSparseMatrix(const char* name, GMM
 	{
 		return -1;
 	}
+#endif
 }
 
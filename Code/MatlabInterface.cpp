@@ -4,8 +4,12 @@
 #include <algorithm>
 
 #include "MatlabInterface.h"
+#include "NativeWorkspace.h"
+#include "VisualizationSink.h"
 
+#ifndef NO_MATLAB
 #include "engine.h"  // Matlab engine header
+#endif
 
 #define ERROR(msg)   std::cerr << "ERROR: "   << msg << std::endl
 #define WARNING(msg) std::cerr << "WARNING: " << msg << std::endl
@@ -22,6 +26,29 @@ inline static long FileSize(const char* fname)
         return 0;
 }
 
+// Get a singleton MatlabInterface object
+std::recursive_mutex &MatlabInterface::EngineMutex()
+{
+    static std::recursive_mutex mutex;
+    return mutex;
+}
+
+
+MatlabInterface &MatlabInterface::GetEngine(bool restart)
+{
+    static MatlabInterface matlab;
+    static bool first_time = true;
+    if (restart && !first_time) {
+        matlab.EngineClose();
+        matlab.EngineOpen();
+    }
+    first_time = false;
+    return matlab;
+}
+
+
+#ifndef NO_MATLAB
+
 ////////////////////////////////////////////////////////////
 // Explicit instantiation of exported template methods
 
@@ -90,7 +117,9 @@ template int MatlabInterface::CopyFromComplexMatrix    <double>(mxArray *M, unsi
 
 MatlabInterface::MatlabInterface() : m_A(NULL), m_b(NULL), m_x(NULL), m_ep(NULL)
 {
-    EngineOpen();
+    // the native workspace replaces the engine, which is then never started
+    if (!NativeWorkspace::IsActive())
+        EngineOpen();
 }
 
 
@@ -887,6 +916,13 @@ MatlabInterface::RunScriptToString(const char *script_name)
 int
 MatlabInterface::Eval(const char *matlab_code, char *output_buffer, int buffer_size)
 {
+    std::lock_guard<std::recursive_mutex> lock(EngineMutex());
+    if (NativeWorkspace::IsActive())
+        return NativeWorkspace::Get().Eval(matlab_code);
+
+    // the plots posted since the last call, before the code of the caller
+    VisualizationSink::Get().drain();
+
     std::cout << "Matlab eval: " << matlab_code << std::endl;
 
     assert(matlab_code != NULL);
@@ -947,20 +983,6 @@ MatlabInterface::AddScriptPath(const char *path)
 }
 
 
-// Get a singleton MatlabInterface object
-MatlabInterface &MatlabInterface::GetEngine(bool restart)
-{
-    static MatlabInterface matlab;
-    static bool first_time = true;
-    if (restart && !first_time) {
-        matlab.EngineClose();
-        matlab.EngineOpen();
-    }
-    first_time = false;
-    return matlab;
-}
-
-
 int MatlabInterface::GetSparseRealMatrix(const char* name, std::vector<unsigned int>& rowind, std::vector<unsigned int>& colind, std::vector<double>& vals, unsigned int& nentries, unsigned int& m, unsigned int& n)
 { 
 	assert(name != NULL && name[0] != 0);
@@ -1252,3 +1274,46 @@ bool MatlabInterface::GetMatrixDimensions(const char* variableName, unsigned int
 
 	return true;
 }
+
+#else
+
+////////////////////////////////////////////////////////////
+// Built without MATLAB (USE_MATLAB off in CMake): there is no engine, Eval goes to the native workspace and
+// MatlabGMMDataExchange keeps the matrices there.
+
+MatlabInterface::MatlabInterface() : m_ep(NULL), m_A(NULL), m_b(NULL), m_x(NULL)
+{
+}
+
+MatlabInterface::~MatlabInterface()
+{
+}
+
+void
+MatlabInterface::EngineOpen()
+{
+    ERROR("Built without the MATLAB engine, use --native-workspace");
+}
+
+void
+MatlabInterface::EngineClose()
+{
+}
+
+void
+MatlabInterface::Deinitialize()
+{
+}
+
+int
+MatlabInterface::Eval(const char *matlab_code, char *output_buffer, int buffer_size)
+{
+    std::lock_guard<std::recursive_mutex> lock(EngineMutex());
+    if (NativeWorkspace::IsActive())
+        return NativeWorkspace::Get().Eval(matlab_code);
+
+    ERROR("Built without the MATLAB engine, can't run \"" << matlab_code << "\"");
+    return -1;
+}
+
+#endif
@@ -8,6 +8,7 @@
 #include <complex>
 #include <cassert>
 #include <map>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -28,6 +29,9 @@ public:
 	// Using a SINGLETON object throughout the application
 	// Get a singleton MatlabInterface object
 	static MatlabInterface &GetEngine(bool restart = false);
+	// The engine is owned by the compute thread, which also shows the frames of VisualizationSink (Eval drains them).
+	// Eval and the exchanges of MatlabGMMDataExchange hold this lock.
+	static std::recursive_mutex &EngineMutex();
 	void EngineOpen();
 	void EngineClose();
 
@@ -0,0 +1,193 @@
+#include "stdafx.h"
+
+#include <fstream>
+#include <cstring>
+
+#define MESH_CACHE_MAGIC "MESHCACH"
+#define MESH_CACHE_VERSION 2
+#define MESH_CACHE_BYTE_ORDER 0x01020304u
+
+
+//bytes of an array, rounded up to 8
+static size_t paddedSize(size_t size)
+{
+	return (size + 7) & ~(size_t)7;
+}
+
+MeshCache::MeshCache() : mHeader(NULL), mPositions(NULL), mFaces(NULL), mUVs(NULL)
+{
+}
+
+unsigned long long MeshCache::checksum(const char* data, size_t size)
+{
+	unsigned long long hash = 14695981039346656037ULL;
+	const unsigned long long prime = 1099511628211ULL;
+	for (size_t i = 0; i + 8 <= size; i += 8)
+	{
+		unsigned long long word;
+		memcpy(&word, data + i, 8);
+		hash = (hash ^ word) * prime;
+	}
+	return hash;
+}
+
+bool MeshCache::isCacheFile(const std::string& filename)
+{
+	size_t length = strlen(extension());
+	return (filename.size() >= length && filename.compare(filename.size() - length, length, extension()) == 0);
+}
+
+bool MeshCache::open(const std::string& filename, std::string& error)
+{
+	close();
+	if (!mFile.open(filename, error))
+		return false;
+	if (!validate(filename, error))
+	{
+		close();
+		return false;
+	}
+	return true;
+}
+
+void MeshCache::close()
+{
+	mFile.close();
+	mHeader = NULL;
+	mPositions = NULL;
+	mFaces = NULL;
+	mUVs = NULL;
+}
+
+//checks the mapped file and sets the array pointers
+bool MeshCache::validate(const std::string& filename, std::string& error)
+{
+	const char* data = mFile.data();
+	const Header* header = (const Header*)data;
+	if (mFile.size() < sizeof(Header) || memcmp(header->magic, MESH_CACHE_MAGIC, 8) != 0)
+	{
+		error = filename + " is not a mesh cache";
+		return false;
+	}
+	if (header->byteOrder != MESH_CACHE_BYTE_ORDER)
+	{
+		error = filename + " was written with another byte order";
+		return false;
+	}
+	if (header->version != MESH_CACHE_VERSION)
+	{
+		error = filename + " has an unsupported mesh cache version";
+		return false;
+	}
+
+	size_t positionsSize = paddedSize(3 * sizeof(double) * header->numVertices);
+	size_t facesSize = paddedSize(3 * sizeof(int) * header->numFaces);
+	size_t uvsSize = paddedSize(2 * sizeof(double) * header->numUVs);
+	size_t payloadSize = positionsSize + facesSize + uvsSize;
+	if (header->payloadSize != payloadSize || mFile.size() != sizeof(Header) + payloadSize)
+	{
+		error = filename + " is truncated";
+		return false;
+	}
+	const char* payload = data + sizeof(Header);
+	if (checksum(payload, payloadSize) != header->checksum)
+	{
+		error = filename + " is corrupted (checksum mismatch)";
+		return false;
+	}
+
+	const int* faces = (const int*)(payload + positionsSize);
+	int numVertices = (int)header->numVertices;
+	for (int i = 0; i < 3 * (int)header->numFaces; ++i)
+	{
+		if (faces[i] < 0 || faces[i] >= numVertices)
+		{
+			error = filename + " has an index out of range";
+			return false;
+		}
+	}
+
+	mPositions = (const double*)payload;
+	mFaces = faces;
+	mUVs = (const double*)(payload + positionsSize + facesSize);
+	mHeader = header;
+	return true;
+}
+
+bool MeshCache::write(const std::string& filename, const std::vector<Kernel::Point_3>& points, const std::vector<int>& fVec, const std::vector<double>& uvs, std::string& error)
+{
+	int numVertices = (int)points.size();
+	int numFaces = (int)fVec.size() / 3;
+	Header header;
+	memcpy(header.magic, MESH_CACHE_MAGIC, 8);
+	header.version = MESH_CACHE_VERSION;
+	header.byteOrder = MESH_CACHE_BYTE_ORDER;
+	header.numVertices = numVertices;
+	header.numFaces = numFaces;
+	header.numUVs = (unsigned int)uvs.size() / 2;
+	header.reserved = 0;
+
+	std::vector<double> positions(3 * numVertices);
+	for (int i = 0; i < numVertices; ++i)
+	{
+		positions[3 * i] = points[i].x();
+		positions[3 * i + 1] = points[i].y();
+		positions[3 * i + 2] = points[i].z();
+	}
+
+	//the arrays, padded to 8 bytes
+	const void* arrays[3] = { positions.empty() ? NULL : &positions[0], fVec.empty() ? NULL : &fVec[0], uvs.empty() ? NULL : &uvs[0] };
+	size_t sizes[3] = { positions.size() * sizeof(double), 3 * numFaces * sizeof(int), uvs.size() * sizeof(double) };
+	std::vector<char> payload;
+	for (int k = 0; k < 3; ++k)
+	{
+		size_t offset = payload.size();
+		payload.resize(offset + paddedSize(sizes[k]), 0);
+		if (sizes[k] > 0)
+			memcpy(&payload[offset], arrays[k], sizes[k]);
+	}
+	header.payloadSize = payload.size();
+	header.checksum = checksum(payload.empty() ? NULL : &payload[0], payload.size());
+
+	std::ofstream out(filename.c_str(), std::ios::binary);
+	if (!out.is_open())
+	{
+		error = "could not create " + filename;
+		return false;
+	}
+	out.write((const char*)&header, sizeof(header));
+	if (!payload.empty())
+		out.write(&payload[0], payload.size());
+	out.close();
+	if (!out)
+	{
+		error = "could not write " + filename;
+		return false;
+	}
+	return true;
+}
+
+bool MeshCache::convert(const std::string& objFile, const std::string& cacheFile, std::string& error)
+{
+	Wavefront_obj obj;
+	if (!obj.load(objFile, error))
+		return false;
+
+	int numVertices = (int)obj.m_points.size();
+	std::vector<Kernel::Point_3> points(numVertices);
+	for (int i = 0; i < numVertices; ++i)
+		points[i] = Kernel::Point_3(obj.m_points[i][0], obj.m_points[i][1], obj.m_points[i][2]);
+
+	std::vector<int> fVec(3 * obj.m_faces.size());
+	for (int i = 0; i < (int)obj.m_faces.size(); ++i)
+		for (int j = 0; j < 3; ++j)
+			fVec[3 * i + j] = obj.m_faces[i].v[j];
+
+	std::vector<double> uvs(2 * obj.m_textureCoordinates.size());
+	for (int i = 0; i < (int)obj.m_textureCoordinates.size(); ++i)
+	{
+		uvs[2 * i] = obj.m_textureCoordinates[i][0];
+		uvs[2 * i + 1] = obj.m_textureCoordinates[i][1];
+	}
+	return write(cacheFile, points, fVec, uvs, error);
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Binary cache of a triangle mesh: positions, faces and texture coordinates (may be none). The face adjacency and
+// the boundary are not stored, the Polyhedron built from the mesh has them. The file is a header followed by the arrays, every one 8 byte aligned, so open
+// maps the file and the accessors point into the mapping without a parse. The header has a version, the byte
+// order and a checksum (FNV-1a over the 8 byte words of the arrays), which open verifies.
+// convert makes a cache from an obj file.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "MappedFile.h"
+
+#include <string>
+#include <vector>
+
+
+class MeshCache
+{
+public:
+
+	MeshCache();
+
+	//on failure returns false, sets error and leaves the cache closed
+	bool open(const std::string& filename, std::string& error);
+	void close();
+
+	int numVertices() const { return (int)mHeader->numVertices; }
+	int numFaces() const { return (int)mHeader->numFaces; }
+	int numUVs() const { return (int)mHeader->numUVs; }
+	const double* positions() const { return mPositions; }	//x, y, z of every vertex
+	const int* faces() const { return mFaces; }				//3 per face, as fVec
+	const double* uvs() const { return mUVs; }				//u, v of every texture coordinate
+
+	//uvs has 2 values per texture coordinate
+	static bool write(const std::string& filename, const std::vector<Kernel::Point_3>& points, const std::vector<int>& fVec, const std::vector<double>& uvs, std::string& error);
+	static bool convert(const std::string& objFile, const std::string& cacheFile, std::string& error);
+	static bool isCacheFile(const std::string& filename); //by the extension
+	static const char* extension() { return ".mcache"; }
+
+private:
+
+	struct Header
+	{
+		char magic[8];
+		unsigned int version;
+		unsigned int byteOrder;		//0x01020304 as written
+		unsigned int numVertices;
+		unsigned int numFaces;
+		unsigned int numUVs;
+		unsigned int reserved;		//0, keeps the 8 byte fields aligned
+		unsigned long long payloadSize;
+		unsigned long long checksum;
+	};
+
+	static unsigned long long checksum(const char* data, size_t size);
+	bool validate(const std::string& filename, std::string& error);
+
+private:
+
+	MappedFile mFile;
+	const Header* mHeader;
+	const double* mPositions;
+	const int* mFaces;
+	const double* mUVs;
+};
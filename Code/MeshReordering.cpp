@@ -0,0 +1,192 @@
+#include "stdafx.h"
+
+
+const std::vector<std::string>& MeshReordering::policies()
+{
+	static std::vector<std::string> names;
+	if (names.empty())
+	{
+		names.push_back("none");
+		names.push_back("rcm");
+		names.push_back("morton");
+	}
+	return names;
+}
+
+bool MeshReordering::apply(const std::string& policy, std::vector<Kernel::Point_3>& points, std::vector<int>& fVec)
+{
+	mNewToOldVertex.clear();
+	mNewToOldFace.clear();
+	int numVertices = (int)points.size();
+	int numFaces = (int)fVec.size() / 3;
+
+	std::vector<int> order;
+	if (policy == "none")
+		return true;
+	else if (policy == "rcm")
+		rcmOrder(fVec, numVertices, order);
+	else if (policy == "morton")
+		mortonOrder(points, order);
+	else
+		return false;
+
+	std::vector<int> oldToNew(numVertices);
+	for (int v = 0; v < numVertices; ++v)
+		oldToNew[order[v]] = v;
+
+	//the faces by their smallest new vertex, the face with the first border edge first
+	FaceAdjacency adjacency;
+	adjacency.build(fVec, numVertices);
+	int firstBorderFace = 0;
+	for (int f = 0; f < numFaces; ++f)
+	{
+		if (adjacency.isBoundaryEdge(f, 0) || adjacency.isBoundaryEdge(f, 1) || adjacency.isBoundaryEdge(f, 2))
+		{
+			firstBorderFace = f;
+			break;
+		}
+	}
+	std::vector<std::pair<int, int> > keys(numFaces);
+	for (int f = 0; f < numFaces; ++f)
+	{
+		int key = (std::min)(oldToNew[fVec[3 * f]], (std::min)(oldToNew[fVec[3 * f + 1]], oldToNew[fVec[3 * f + 2]]));
+		keys[f] = std::make_pair((f == firstBorderFace) ? -1 : key, f);
+	}
+	std::sort(keys.begin(), keys.end());
+
+	std::vector<Kernel::Point_3> oldPoints(points);
+	for (int v = 0; v < numVertices; ++v)
+		points[v] = oldPoints[order[v]];
+	std::vector<int> oldFaces(fVec);
+	mNewToOldFace.resize(numFaces);
+	for (int f = 0; f < numFaces; ++f)
+	{
+		mNewToOldFace[f] = keys[f].second;
+		for (int j = 0; j < 3; ++j)
+			fVec[3 * f + j] = oldToNew[oldFaces[3 * keys[f].second + j]];
+	}
+	mNewToOldVertex.swap(order);
+	return true;
+}
+
+void MeshReordering::restoreFaces(std::vector<int>& fVec) const
+{
+	if (isIdentity())
+		return;
+	std::vector<int> current(fVec);
+	for (int f = 0; f < (int)current.size() / 3; ++f)
+	{
+		int oldFace = (f < (int)mNewToOldFace.size()) ? mNewToOldFace[f] : f;
+		for (int j = 0; j < 3; ++j)
+			fVec[3 * oldFace + j] = oldVertex(current[3 * f + j]);
+	}
+}
+
+//breadth first search from a vertex of smallest degree in every component, the neighbors by increasing degree,
+//and the whole order reversed
+void MeshReordering::rcmOrder(const std::vector<int>& fVec, int numVertices, std::vector<int>& order)
+{
+	FaceAdjacency adjacency;
+	adjacency.build(fVec, numVertices);
+
+	std::vector<int> neighborsPtr(numVertices + 1, 0), neighbors, mark(numVertices, -1);
+	for (int v = 0; v < numVertices; ++v)
+	{
+		for (int k = adjacency.vertexFacesBegin(v); k < adjacency.vertexFacesEnd(v); ++k)
+		{
+			int face = adjacency.vertexFace(k);
+			for (int j = 0; j < 3; ++j)
+			{
+				int u = fVec[3 * face + j];
+				if (u != v && mark[u] != v)
+				{
+					mark[u] = v;
+					neighbors.push_back(u);
+				}
+			}
+		}
+		neighborsPtr[v + 1] = (int)neighbors.size();
+	}
+
+	std::vector<std::pair<int, int> > byDegree(numVertices);
+	for (int v = 0; v < numVertices; ++v)
+		byDegree[v] = std::make_pair(neighborsPtr[v + 1] - neighborsPtr[v], v);
+	std::sort(byDegree.begin(), byDegree.end());
+
+	order.clear();
+	order.reserve(numVertices);
+	std::vector<bool> isVisited(numVertices, false);
+	std::vector<std::pair<int, int> > next;
+	for (int i = 0; i < numVertices; ++i)
+	{
+		if (isVisited[byDegree[i].second])
+			continue;
+		isVisited[byDegree[i].second] = true;
+		order.push_back(byDegree[i].second);
+		for (int head = (int)order.size() - 1; head < (int)order.size(); ++head)
+		{
+			int v = order[head];
+			next.clear();
+			for (int k = neighborsPtr[v]; k < neighborsPtr[v + 1]; ++k)
+			{
+				int u = neighbors[k];
+				if (!isVisited[u])
+				{
+					isVisited[u] = true;
+					next.push_back(std::make_pair(neighborsPtr[u + 1] - neighborsPtr[u], u));
+				}
+			}
+			std::sort(next.begin(), next.end());
+			for (int k = 0; k < (int)next.size(); ++k)
+				order.push_back(next[k].second);
+		}
+	}
+	std::reverse(order.begin(), order.end());
+}
+
+//the lower 21 bits of x, spread to every third bit
+static unsigned long long spreadBits(unsigned int x)
+{
+	unsigned long long b = x & 0x1fffff;
+	b = (b | b << 32) & 0x1f00000000ffffULL;
+	b = (b | b << 16) & 0x1f0000ff0000ffULL;
+	b = (b | b << 8) & 0x100f00f00f00f00fULL;
+	b = (b | b << 4) & 0x10c30c30c30c30c3ULL;
+	b = (b | b << 2) & 0x1249249249249249ULL;
+	return b;
+}
+
+void MeshReordering::mortonOrder(const std::vector<Kernel::Point_3>& points, std::vector<int>& order)
+{
+	const double n = (1 << 21) - 1;
+	int numPoints = (int)points.size();
+	order.resize(numPoints);
+	if (numPoints == 0)
+		return;
+
+	double minCoord[3], maxCoord[3];
+	for (int k = 0; k < 3; ++k)
+		minCoord[k] = maxCoord[k] = points[0][k];
+	for (int i = 1; i < numPoints; ++i)
+	{
+		for (int k = 0; k < 3; ++k)
+		{
+			minCoord[k] = (std::min)(minCoord[k], points[i][k]);
+			maxCoord[k] = (std::max)(maxCoord[k], points[i][k]);
+		}
+	}
+	double scale = (std::max)(maxCoord[0] - minCoord[0], (std::max)(maxCoord[1] - minCoord[1], maxCoord[2] - minCoord[2]));
+	scale = (scale > 0.0) ? n / scale : 0.0;
+
+	std::vector<std::pair<unsigned long long, int> > keys(numPoints);
+	for (int i = 0; i < numPoints; ++i)
+	{
+		unsigned long long key = 0;
+		for (int k = 0; k < 3; ++k)
+			key |= spreadBits((unsigned int)((points[i][k] - minCoord[k]) * scale)) << k;
+		keys[i] = std::make_pair(key, i);
+	}
+	std::sort(keys.begin(), keys.end());
+	for (int i = 0; i < numPoints; ++i)
+		order[i] = keys[i].second;
+}
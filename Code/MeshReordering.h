@@ -0,0 +1,78 @@
+#pragma once
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Renumbering of a triangle list (points and fVec), so that vertices and faces which are near each other on the
+// mesh are near each other in memory. The source mesh comes in the order of its file and the target mesh in the order
+// its pieces are concatenated, which makes the flattening, the solvers, updateUVs and the refinement jump around.
+//   none   - keep the order (the default)
+//   rcm    - reverse Cuthill-McKee over the edges of the mesh
+//   morton - Morton (Z order) curve over the positions
+// The faces are sorted by their smallest new vertex, except that the face with the first border edge stays first:
+// the border loop of the mesh which MeshBuilder makes starts at the same vertex, so the boundary conditions do not
+// change. The permutation is kept, and restore puts the results back in the input order.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <string>
+#include <vector>
+
+
+class MeshReordering
+{
+public:
+
+	MeshReordering() {}
+
+	//false for an unknown policy, the lists are not changed then
+	bool apply(const std::string& policy, std::vector<Kernel::Point_3>& points, std::vector<int>& fVec);
+	bool isIdentity() const { return mNewToOldVertex.empty(); }
+
+	//stride values of every vertex, in the input order, to the new order. values behind the vertices are not moved.
+	template <class T>
+	void permute(std::vector<T>& values, int stride = 1) const;
+	//stride values of every vertex, in the new order, back to the input order. the values of vertices which were
+	//appended after apply (the refinement) stay behind the others.
+	template <class T>
+	void restore(std::vector<T>& values, int stride = 1) const;
+	//the faces back to the input order and vertex numbering, appended faces stay behind. -1 stays -1.
+	void restoreFaces(std::vector<int>& fVec) const;
+
+	int numVertices() const { return (int)mNewToOldVertex.size(); }
+	int oldVertex(int v) const { return (v < 0 || v >= numVertices()) ? v : mNewToOldVertex[v]; }
+
+	static const std::vector<std::string>& policies();
+
+protected:
+
+	static void rcmOrder(const std::vector<int>& fVec, int numVertices, std::vector<int>& order);
+	static void mortonOrder(const std::vector<Kernel::Point_3>& points, std::vector<int>& order);
+
+protected:
+
+	std::vector<int> mNewToOldVertex;
+	std::vector<int> mNewToOldFace;
+};
+
+
+template <class T>
+void MeshReordering::permute(std::vector<T>& values, int stride) const
+{
+	if (isIdentity())
+		return;
+	std::vector<T> old(values.begin(), values.begin() + stride * numVertices());
+	for (int v = 0; v < numVertices(); ++v)
+		for (int k = 0; k < stride; ++k)
+			values[stride * v + k] = old[stride * mNewToOldVertex[v] + k];
+}
+
+template <class T>
+void MeshReordering::restore(std::vector<T>& values, int stride) const
+{
+	if (isIdentity())
+		return;
+	std::vector<T> current(values.begin(), values.begin() + stride * numVertices());
+	for (int v = 0; v < numVertices(); ++v)
+		for (int k = 0; k < stride; ++k)
+			values[stride * mNewToOldVertex[v] + k] = current[stride * v + k];
+}
@@ -0,0 +1,149 @@
+#include "stdafx.h"
+
+#include <fstream>
+#include <cstdio>
+#if defined(__has_include)
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
+#endif
+
+
+//text output through a fixed buffer, written to the stream when it is full
+class ObjStream
+{
+public:
+
+	ObjStream(std::ofstream& out) : mOut(out), mBuffer(BUFFER_SIZE), mSize(0) {}
+	~ObjStream() { flush(); }
+
+	void flush()
+	{
+		mOut.write(&mBuffer[0], mSize);
+		mSize = 0;
+	}
+
+	void put(const char* text)
+	{
+		reserve();
+		for (; *text != '\0'; ++text)
+			mBuffer[mSize++] = *text;
+	}
+
+	//the shortest text which reads back as the same double
+	void put(double value)
+	{
+		reserve();
+#if defined(__cpp_lib_to_chars)
+		mSize = (int)(std::to_chars(&mBuffer[mSize], &mBuffer[0] + BUFFER_SIZE, value).ptr - &mBuffer[0]);
+#else
+		mSize += snprintf(&mBuffer[mSize], 32, "%.17g", value);
+#endif
+	}
+
+	void put(int value)
+	{
+		reserve();
+		char digits[16];
+		int n = 0;
+		unsigned int v = (value < 0) ? 0u - (unsigned int)value : (unsigned int)value;
+		do
+		{
+			digits[n++] = (char)('0' + v % 10);
+			v /= 10;
+		} while (v > 0);
+		if (value < 0)
+			mBuffer[mSize++] = '-';
+		while (n > 0)
+			mBuffer[mSize++] = digits[--n];
+	}
+
+	//room for a line of numbers
+	void reserve()
+	{
+		if (mSize > BUFFER_SIZE - 64)
+			flush();
+	}
+
+private:
+
+	enum { BUFFER_SIZE = 1 << 20 };
+
+	std::ofstream& mOut;
+	std::vector<char> mBuffer;
+	int mSize;
+};
+
+bool writeParametrizedObj(const std::string& filename, const std::vector<Kernel::Point_3>& pVec, const std::vector<Point_3>& uvVector, const std::vector<int>& fVec, std::string& error)
+{
+	std::ofstream out(filename.c_str(), std::ios::binary);
+	if (!out.is_open())
+	{
+		error = "could not create " + filename;
+		return false;
+	}
+
+	{
+		ObjStream stream(out);
+		for (int i = 0; i < (int)pVec.size(); ++i)
+		{
+			stream.put("v ");
+			stream.put(pVec[i].x());
+			stream.put(" ");
+			stream.put(pVec[i].y());
+			stream.put(" ");
+			stream.put(pVec[i].z());
+			stream.put("\n");
+		}
+		for (int i = 0; i < (int)uvVector.size(); ++i)
+		{
+			stream.put("vt ");
+			stream.put(uvVector[i].x());
+			stream.put(" ");
+			stream.put(uvVector[i].y());
+			stream.put("\n");
+		}
+		for (int i = 0; i + 2 < (int)fVec.size(); i += 3)
+		{
+			if ((fVec[i] == -1) && (fVec[i + 1] == -1) && (fVec[i + 2] == -1))
+				continue;
+			stream.put("f");
+			for (int j = 0; j < 3; ++j)
+			{
+				stream.put(" ");
+				stream.put(fVec[i + j] + 1);
+				stream.put("/");
+				stream.put(fVec[i + j] + 1);
+			}
+			stream.put("\n");
+		}
+	}
+
+	out.close();
+	if (!out)
+	{
+		error = "could not write " + filename;
+		return false;
+	}
+	return true;
+}
+
+bool writeParametrizedMesh(const std::string& filename, const std::vector<Kernel::Point_3>& pVec, const std::vector<Point_3>& uvVector, const std::vector<int>& fVec, std::string& error)
+{
+	if (!MeshCache::isCacheFile(filename))
+		return writeParametrizedObj(filename, pVec, uvVector, fVec, error);
+
+	//the cache is checksummed and has the adjacency of the faces, so it is written from the live faces
+	std::vector<int> faces;
+	faces.reserve(fVec.size());
+	for (int i = 0; i + 2 < (int)fVec.size(); i += 3)
+		if ((fVec[i] != -1) || (fVec[i + 1] != -1) || (fVec[i + 2] != -1))
+			faces.insert(faces.end(), fVec.begin() + i, fVec.begin() + i + 3);
+	std::vector<double> uvs(2 * uvVector.size());
+	for (int i = 0; i < (int)uvVector.size(); ++i)
+	{
+		uvs[2 * i] = uvVector[i].x();
+		uvs[2 * i + 1] = uvVector[i].y();
+	}
+	return MeshCache::write(filename, pVec, faces, uvs, error);
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Writes the parametrized mesh straight from pVec, uvVector and fVec. The faces which are -1 (replaced by the
+// refinement) are skipped as they are written. The obj file has a texture coordinate (vt) per vertex, with the
+// index of the vertex. A file with the MeshCache extension is written as a mesh cache, with the uvs as its texture
+// coordinates.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <string>
+#include <vector>
+
+
+//on failure returns false and sets error
+bool writeParametrizedMesh(const std::string& filename, const std::vector<Kernel::Point_3>& pVec, const std::vector<Point_3>& uvVector, const std::vector<int>& fVec, std::string& error);
+bool writeParametrizedObj(const std::string& filename, const std::vector<Kernel::Point_3>& pVec, const std::vector<Point_3>& uvVector, const std::vector<int>& fVec, std::string& error);
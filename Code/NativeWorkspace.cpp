@@ -0,0 +1,269 @@
+#include "stdafx.h"
+
+#include <cstdlib>
+
+
+static std::string trim(const std::string& s)
+{
+	size_t first = s.find_first_not_of(" \t\r\n");
+	if (first == std::string::npos)
+		return std::string();
+	size_t last = s.find_last_not_of(" \t\r\n");
+	return s.substr(first, last - first + 1);
+}
+
+//windows and plots
+static int ignoreStatement(NativeWorkspace& workspace, const std::string& statement)
+{
+	return 0;
+}
+
+//nis4: the two disk maps of the systems which main sets
+static int solveDiskMaps(NativeWorkspace& workspace, const std::string& statement)
+{
+	CGAL::Timer timer;
+	timer.start();
+	int res = workspace.solve("outSource", "weightsMatSource", "uSource");
+	double sourceTime = timer.time();
+	timer.reset();
+	if (res == 0)
+		res = workspace.solve("outTarget", "weightsMatTarget", "uTarget");
+	double targetTime = timer.time();
+	workspace.setDense("sTime", 1, 1, &sourceTime);
+	workspace.setDense("tTime", 1, 1, &targetTime);
+	return res;
+}
+
+//CSR of the entries. the exchange gives them row by row and by column in a row (the wsvector order), then the
+//values are moved and only the column indices are converted. other orders are sorted first.
+template <class T>
+static void setSparseEntries(NativeVariable& var, int nRows, int nCols, const std::vector<unsigned>& rows, const std::vector<unsigned>& cols, std::vector<T>& values, std::vector<T>& stored)
+{
+	var = NativeVariable();
+	var.nRows = nRows;
+	var.nCols = nCols;
+	var.isSparse = true;
+
+	int numEntries = (int)values.size();
+	bool sorted = true;
+	for (int k = 1; k < numEntries && sorted; ++k)
+		sorted = (rows[k - 1] < rows[k] || (rows[k - 1] == rows[k] && cols[k - 1] < cols[k]));
+
+	var.rowPtr.assign(nRows + 1, 0);
+	for (int k = 0; k < numEntries; ++k)
+		var.rowPtr[rows[k] + 1]++;
+	for (int i = 0; i < nRows; ++i)
+		var.rowPtr[i + 1] += var.rowPtr[i];
+
+	var.cols.resize(numEntries);
+	if (sorted)
+	{
+		for (int k = 0; k < numEntries; ++k)
+			var.cols[k] = (int)cols[k];
+		stored.swap(values);
+		return;
+	}
+
+	std::vector<std::pair<std::pair<unsigned, unsigned>, int> > order(numEntries);
+	for (int k = 0; k < numEntries; ++k)
+		order[k] = std::make_pair(std::make_pair(rows[k], cols[k]), k);
+	std::sort(order.begin(), order.end());
+	stored.resize(numEntries);
+	for (int k = 0; k < numEntries; ++k)
+	{
+		var.cols[k] = (int)order[k].first.second;
+		stored[k] = values[order[k].second];
+	}
+}
+
+
+NativeWorkspace::NativeWorkspace() : mIsActive(false), mSolverCache(NULL)
+{
+	registerHandler("nis4", solveDiskMaps);
+	const char* ignored[] = { "nis", "resMap", "figure", "hold", "axis", "trimesh", "impoly" };
+	for (int i = 0; i < (int)(sizeof(ignored) / sizeof(ignored[0])); ++i)
+		registerHandler(ignored[i], ignoreStatement);
+}
+
+NativeWorkspace& NativeWorkspace::Get()
+{
+	static NativeWorkspace workspace;
+	return workspace;
+}
+
+void NativeWorkspace::activate()
+{
+	mIsActive = true;
+}
+
+void NativeWorkspace::setDense(const char* name, int nRows, int nCols, const double* values)
+{
+	NativeVariable& var = mVariables[name];
+	var = NativeVariable();
+	var.nRows = nRows;
+	var.nCols = nCols;
+	var.real.assign(values, values + nRows * nCols);
+}
+
+void NativeWorkspace::setDense(const char* name, int nRows, int nCols, const std::complex<double>* values)
+{
+	NativeVariable& var = mVariables[name];
+	var = NativeVariable();
+	var.nRows = nRows;
+	var.nCols = nCols;
+	var.isComplex = true;
+	var.complex.assign(values, values + nRows * nCols);
+}
+
+void NativeWorkspace::setSparse(const char* name, int nRows, int nCols, const std::vector<unsigned>& rows, const std::vector<unsigned>& cols, std::vector<double>& values)
+{
+	NativeVariable& var = mVariables[name];
+	setSparseEntries(var, nRows, nCols, rows, cols, values, var.real);
+}
+
+void NativeWorkspace::setSparse(const char* name, int nRows, int nCols, const std::vector<unsigned>& rows, const std::vector<unsigned>& cols, std::vector<std::complex<double> >& values)
+{
+	NativeVariable& var = mVariables[name];
+	setSparseEntries(var, nRows, nCols, rows, cols, values, var.complex);
+	var.isComplex = true;
+}
+
+const NativeVariable* NativeWorkspace::find(const char* name) const
+{
+	std::map<std::string, NativeVariable>::const_iterator it = mVariables.find(name);
+	return (it == mVariables.end()) ? NULL : &it->second;
+}
+
+bool NativeWorkspace::take(const char* name, NativeVariable& var)
+{
+	std::map<std::string, NativeVariable>::iterator it = mVariables.find(name);
+	if (it == mVariables.end())
+		return false;
+	std::swap(var, it->second);
+	mVariables.erase(it);
+	return true;
+}
+
+int NativeWorkspace::Eval(const char* code)
+{
+	std::string statements(code);
+	size_t begin = 0;
+	while (begin <= statements.size())
+	{
+		size_t end = statements.find(';', begin);
+		if (end == std::string::npos)
+			end = statements.size();
+		std::string statement = trim(statements.substr(begin, end - begin));
+		if (!statement.empty())
+		{
+			int res = evalStatement(statement);
+			if (res != 0)
+				return res;
+		}
+		begin = end + 1;
+	}
+	return 0;
+}
+
+int NativeWorkspace::evalStatement(const std::string& statement)
+{
+	std::map<std::string, Handler>::iterator handler = mHandlers.find(statement);
+	if (handler != mHandlers.end())
+		return handler->second(*this, statement);
+
+	size_t assign = statement.find('=');
+	if (assign != std::string::npos && assign + 1 < statement.size() && statement[assign + 1] != '=')
+	{
+		std::string lhs = trim(statement.substr(0, assign));
+		std::string rhs = trim(statement.substr(assign + 1));
+
+		size_t backslash = rhs.find('\\');
+		if (backslash != std::string::npos)
+			return solve(lhs, trim(rhs.substr(0, backslash)), trim(rhs.substr(backslash + 1)));
+
+		//X = X + k
+		std::string shift = (rhs.compare(0, lhs.size(), lhs) == 0) ? trim(rhs.substr(lhs.size())) : std::string();
+		if (!shift.empty() && (shift[0] == '+' || shift[0] == '-') && mVariables.count(lhs) == 1)
+		{
+			char* end = NULL;
+			double k = strtod(shift.c_str() + 1, &end);
+			if (end != shift.c_str() + 1 && trim(end).empty())
+			{
+				if (shift[0] == '-')
+					k = -k;
+				NativeVariable& var = mVariables[lhs];
+				for (int i = 0; i < (int)var.real.size(); ++i)
+					var.real[i] += k;
+				for (int i = 0; i < (int)var.complex.size(); ++i)
+					var.complex[i] += k;
+				return 0;
+			}
+		}
+	}
+
+	handler = mHandlers.find(statement.substr(0, statement.find_first_of("( ")));
+	if (handler != mHandlers.end())
+		return handler->second(*this, statement);
+
+	std::cerr << "No native handler for \"" << statement << "\"\n";
+	return -1;
+}
+
+int NativeWorkspace::solve(const std::string& x, const std::string& a, const std::string& b)
+{
+	std::map<std::string, NativeVariable>::iterator itA = mVariables.find(a);
+	const NativeVariable* B = find(b.c_str());
+	NativeVariable* A = (itA == mVariables.end()) ? NULL : &itA->second;
+	if (A == NULL || B == NULL || !A->isSparse || A->isComplex || B->isComplex || A->nRows != A->nCols || B->nRows != A->nRows || B->nCols != 2)
+	{
+		std::cerr << "The native workspace can not solve " << x << " = " << a << " \\ " << b << "\n";
+		return -1;
+	}
+
+	//two interleaved columns, as HarmonicSolver wants them
+	int n = A->nRows;
+	std::vector<double> rhs(2 * n, 0.0), solution(2 * n, 0.0);
+	if (B->isSparse)
+	{
+		for (int i = 0; i < n; ++i)
+			for (int k = B->rowPtr[i]; k < B->rowPtr[i + 1]; ++k)
+				rhs[2 * i + B->cols[k]] += B->real[k];
+	}
+	else
+	{
+		for (int i = 0; i < n; ++i)
+		{
+			rhs[2 * i] = B->real[i];
+			rhs[2 * i + 1] = B->real[n + i];
+		}
+	}
+
+	//A is stored as CSR, its buffers are lent to the solver for the compute and given back
+	SparseMatrixCSR csr;
+	csr.nRows = csr.nCols = n;
+	csr.rowPtr.swap(A->rowPtr);
+	csr.colInd.swap(A->cols);
+	csr.values.swap(A->real);
+	HarmonicSolver newSolver(RunOptions::Get().solver);
+	HarmonicSolver& solver = (mSolverCache != NULL) ? mSolverCache->solver(csr, RunOptions::Get().solver) : newSolver;
+	bool computed = solver.compute(csr);
+	csr.rowPtr.swap(A->rowPtr);
+	csr.colInd.swap(A->cols);
+	csr.values.swap(A->real);
+	if (!computed)
+		return -1;
+	if (!solver.solve(rhs, solution))
+		std::cout << "Warning: the harmonic solver did not reach the requested tolerance for " << x << " (" << solver.report().residual[0] << "," << solver.report().residual[1] << ")\n";
+
+	NativeVariable& X = mVariables[x];
+	X = NativeVariable();
+	X.nRows = n;
+	X.nCols = 2;
+	X.real.resize(2 * n);
+	for (int i = 0; i < n; ++i)
+	{
+		X.real[i] = solution[2 * i];
+		X.real[n + i] = solution[2 * i + 1];
+	}
+	return 0;
+}
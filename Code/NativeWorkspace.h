@@ -0,0 +1,87 @@
+#pragma once
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// In process stand-in for the MATLAB engine (--native-workspace). MatlabGMMDataExchange keeps the named matrices
+// here instead of copying them element by element through mxArrays, and MatlabInterface::Eval evaluates the few
+// expressions of the pipeline with native handlers:
+//   X = A \ B        - A sparse and square, B with two columns (the disk map systems), solved with HarmonicSolver
+//   X = X + k        - shift of all the entries (the 0 to 1 based index shifts), also X = X - k
+//   nis4             - the disk maps: outSource, outTarget, sTime and tTime from the systems of main
+//   nis, resMap, figure, hold, axis, trimesh, impoly - windows and plots, they do nothing
+// Statements are separated by ';'. Statements are looked up as a whole and then by the name before '(' or ' ', so
+// more handlers can be registered. The interactive stages (nis2, nis3) have none, --target replaces them.
+// Dense matrices are kept column major, sparse matrices in CSR (rowPtr, cols and the values). Handlers and callers
+// read the stored buffers in place (variable), solve lends the CSR buffers of A to HarmonicSolver and take hands a
+// buffer over. The copies which stay: setDense (the caller keeps its matrix), the column indices of setSparse
+// (unsigned to int) and the interleaved right hand side and solution of HarmonicSolver.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <complex>
+#include <map>
+#include <string>
+#include <vector>
+
+
+class HarmonicSolverCache;
+
+
+struct NativeVariable
+{
+	NativeVariable() : nRows(0), nCols(0), isSparse(false), isComplex(false) {}
+
+	int nRows, nCols;
+	bool isSparse, isComplex;
+	std::vector<double> real; //dense - the entries column by column, sparse - the values of the entries
+	std::vector<std::complex<double> > complex; //the same for complex matrices
+	std::vector<int> rowPtr, cols; //CSR of a sparse matrix, the entries of row i are rowPtr[i] to rowPtr[i + 1] - 1
+};
+
+
+class NativeWorkspace
+{
+public:
+
+	//returns 0 on success, like MatlabInterface::Eval. statement has no surrounding spaces.
+	typedef int (*Handler)(NativeWorkspace& workspace, const std::string& statement);
+
+	static NativeWorkspace& Get();
+	static bool IsActive() { return Get().mIsActive; }
+	void activate();
+
+	void setDense(const char* name, int nRows, int nCols, const double* values);
+	void setDense(const char* name, int nRows, int nCols, const std::complex<double>* values);
+	//the entries in any order. entries sorted by row and column (as the exchange gives them) move values into the
+	//workspace and leave it empty, otherwise it is copied in sorted order.
+	void setSparse(const char* name, int nRows, int nCols, const std::vector<unsigned>& rows, const std::vector<unsigned>& cols, std::vector<double>& values);
+	void setSparse(const char* name, int nRows, int nCols, const std::vector<unsigned>& rows, const std::vector<unsigned>& cols, std::vector<std::complex<double> >& values);
+	NativeVariable& variable(const char* name) { return mVariables[name]; }
+	const NativeVariable* find(const char* name) const; //NULL if there is no such variable
+	//moves the variable into var and removes it from the workspace. false if there is no such variable.
+	bool take(const char* name, NativeVariable& var);
+	void clear(const char* name) { mVariables.erase(name); }
+
+	int Eval(const char* code);
+	void registerHandler(const std::string& name, Handler handler) { mHandlers[name] = handler; }
+
+	//X = A \ B. returns 0 on success.
+	int solve(const std::string& x, const std::string& a, const std::string& b);
+	//the solvers of solve come from the cache (main sets its own around nis4), NULL - a new solver for every system
+	void setSolverCache(HarmonicSolverCache* cache) { mSolverCache = cache; }
+
+protected:
+
+	NativeWorkspace();
+	NativeWorkspace(const NativeWorkspace&);
+	NativeWorkspace& operator=(const NativeWorkspace&);
+
+	int evalStatement(const std::string& statement);
+
+protected:
+
+	bool mIsActive;
+	HarmonicSolverCache* mSolverCache;
+	std::map<std::string, NativeVariable> mVariables;
+	std::map<std::string, Handler> mHandlers;
+};
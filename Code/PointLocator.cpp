@@ -0,0 +1,319 @@
+#include "stdafx.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+typedef CGAL::Arr_trapezoid_ric_point_location<Arrangement_2>			Trapezoid_pl;
+typedef CGAL::Arr_walk_along_line_point_location<Arrangement_2>		Walk_along_line_pl;
+
+
+const std::vector<std::string>& PointLocator::policies()
+{
+	static std::vector<std::string> names;
+	if (names.empty())
+	{
+		names.push_back("walk");
+		names.push_back("landmarks");
+		names.push_back("trapezoid");
+		names.push_back("walk-along-line");
+		names.push_back("grid");
+	}
+	return names;
+}
+
+PointLocator* PointLocator::create(const std::string& policy, const DiskLocator& disk, Mesh& mesh)
+{
+	if (policy == "walk")
+		return new WalkLocator(disk);
+	if (policy == "landmarks")
+		return new ArrangementLocator<Landmarks_pl>(disk, mesh, "landmarks");
+	if (policy == "trapezoid")
+		return new ArrangementLocator<Trapezoid_pl>(disk, mesh, "trapezoid");
+	if (policy == "walk-along-line")
+		return new ArrangementLocator<Walk_along_line_pl>(disk, mesh, "walk-along-line");
+	if (policy == "grid")
+		return new GridLocator(disk);
+	return NULL;
+}
+
+void PointLocator::locateBatch(const std::vector<EPoint_2>& points, std::vector<DiskLocator::Location>& locations) const
+{
+	std::vector<int> order;
+	hilbertSort(points, order);
+
+	locations.resize(points.size());
+	int hintFace = -1;
+	for (int k = 0; k < (int)order.size(); ++k)
+	{
+		DiskLocator::Location& location = locations[order[k]];
+		location = locateFrom(points[order[k]], hintFace);
+		if (location.face != -1)
+			hintFace = location.face;
+	}
+}
+
+//distance of (x, y) along the Hilbert curve which fills an n x n grid (n is a power of 2)
+static unsigned long long hilbertIndex(unsigned int n, unsigned int x, unsigned int y)
+{
+	unsigned long long d = 0;
+	for (unsigned int s = n / 2; s > 0; s /= 2)
+	{
+		unsigned int rx = (x & s) > 0;
+		unsigned int ry = (y & s) > 0;
+		d += (unsigned long long)s * s * ((3 * rx) ^ ry);
+		if (ry == 0)
+		{
+			if (rx == 1)
+			{
+				x = n - 1 - x;
+				y = n - 1 - y;
+			}
+			std::swap(x, y);
+		}
+	}
+	return d;
+}
+
+void hilbertSort(const std::vector<EPoint_2>& points, std::vector<int>& order)
+{
+	int numPoints = (int)points.size();
+	std::vector<double> x(numPoints), y(numPoints);
+	for (int i = 0; i < numPoints; ++i)
+	{
+		x[i] = CGAL::to_double(points[i].x());
+		y[i] = CGAL::to_double(points[i].y());
+	}
+	hilbertSort(x, y, order);
+}
+
+void hilbertSort(const std::vector<double>& x, const std::vector<double>& y, std::vector<int>& order)
+{
+	const unsigned int n = 1u << 16;
+	int numPoints = (int)x.size();
+	order.resize(numPoints);
+	if (numPoints == 0)
+		return;
+
+	double minX = *std::min_element(x.begin(), x.end()), maxX = *std::max_element(x.begin(), x.end());
+	double minY = *std::min_element(y.begin(), y.end()), maxY = *std::max_element(y.begin(), y.end());
+	double scale = (std::max)(maxX - minX, maxY - minY);
+	scale = (scale > 0.0) ? (n - 1) / scale : 0.0;
+
+	std::vector<std::pair<unsigned long long, int> > keys(numPoints);
+	for (int i = 0; i < numPoints; ++i)
+	{
+		unsigned int ix = (unsigned int)((x[i] - minX) * scale);
+		unsigned int iy = (unsigned int)((y[i] - minY) * scale);
+		keys[i] = std::make_pair(hilbertIndex(n, ix, iy), i);
+	}
+	std::sort(keys.begin(), keys.end());
+	for (int i = 0; i < numPoints; ++i)
+		order[i] = keys[i].second;
+}
+
+
+void GridLocator::build()
+{
+	int numVertices = mDisk.numVertices();
+	int numFaces = mDisk.numFaces();
+	if (numVertices == 0)
+		return;
+
+	double maxX = mMinX = mDisk.x(0);
+	double maxY = mMinY = mDisk.y(0);
+	for (int i = 1; i < numVertices; ++i)
+	{
+		mMinX = (std::min)(mMinX, mDisk.x(i));
+		mMinY = (std::min)(mMinY, mDisk.y(i));
+		maxX = (std::max)(maxX, mDisk.x(i));
+		maxY = (std::max)(maxY, mDisk.y(i));
+	}
+	//about two faces per cell
+	mGridSize = (std::max)(1, (int)std::sqrt(numFaces / 2.0));
+	mCellSize = (std::max)(maxX - mMinX, maxY - mMinY) / mGridSize;
+	if (mCellSize <= 0.0)
+		mCellSize = 1.0;
+
+	//the bounding boxes are padded, since the exact coordinates may round either way
+	const double pad = 1e-9 * mCellSize * mGridSize;
+	std::vector<int> faceCells[4]; //cell range of every face: i0, i1, j0, j1
+	for (int k = 0; k < 4; ++k)
+		faceCells[k].resize(numFaces);
+	mCellPtr.assign(mGridSize * mGridSize + 1, 0);
+	for (int f = 0; f < numFaces; ++f)
+	{
+		double x0 = mDisk.x(mDisk.vertexOfFace(f, 0)), x1 = x0;
+		double y0 = mDisk.y(mDisk.vertexOfFace(f, 0)), y1 = y0;
+		for (int j = 1; j < 3; ++j)
+		{
+			int v = mDisk.vertexOfFace(f, j);
+			x0 = (std::min)(x0, mDisk.x(v));
+			x1 = (std::max)(x1, mDisk.x(v));
+			y0 = (std::min)(y0, mDisk.y(v));
+			y1 = (std::max)(y1, mDisk.y(v));
+		}
+		faceCells[0][f] = (std::max)(0, (int)((x0 - pad - mMinX) / mCellSize));
+		faceCells[1][f] = (std::min)(mGridSize - 1, (int)((x1 + pad - mMinX) / mCellSize));
+		faceCells[2][f] = (std::max)(0, (int)((y0 - pad - mMinY) / mCellSize));
+		faceCells[3][f] = (std::min)(mGridSize - 1, (int)((y1 + pad - mMinY) / mCellSize));
+		for (int j = faceCells[2][f]; j <= faceCells[3][f]; ++j)
+			for (int i = faceCells[0][f]; i <= faceCells[1][f]; ++i)
+				mCellPtr[j * mGridSize + i + 1]++;
+	}
+	for (int cell = 0; cell < mGridSize * mGridSize; ++cell)
+		mCellPtr[cell + 1] += mCellPtr[cell];
+
+	mCellFaces.resize(mCellPtr.back());
+	std::vector<int> fill(mCellPtr.begin(), mCellPtr.end() - 1);
+	for (int f = 0; f < numFaces; ++f)
+		for (int j = faceCells[2][f]; j <= faceCells[3][f]; ++j)
+			for (int i = faceCells[0][f]; i <= faceCells[1][f]; ++i)
+				mCellFaces[fill[j * mGridSize + i]++] = f;
+}
+
+int GridLocator::cell(double x, double y) const
+{
+	int i = (std::min)((std::max)((int)((x - mMinX) / mCellSize), 0), mGridSize - 1);
+	int j = (std::min)((std::max)((int)((y - mMinY) / mCellSize), 0), mGridSize - 1);
+	return j * mGridSize + i;
+}
+
+DiskLocator::Location GridLocator::locateDouble(double x, double y, int hintFace) const
+{
+	int cell = this->cell(x, y);
+	for (int k = mCellPtr[cell]; k < mCellPtr[cell + 1]; ++k)
+	{
+		DiskLocator::Location location = mDisk.locateInFace(mCellFaces[k], x, y);
+		if (location.face != -1)
+			return location;
+	}
+	return mDisk.locate(x, y, hintFace);
+}
+
+DiskLocator::Location GridLocator::locate(const EPoint_2& p) const
+{
+	int cell = this->cell(CGAL::to_double(p.x()), CGAL::to_double(p.y()));
+
+	for (int k = mCellPtr[cell]; k < mCellPtr[cell + 1]; ++k)
+	{
+		DiskLocator::Location location = mDisk.locateInFace(mCellFaces[k], p);
+		if (location.face != -1)
+			return location;
+	}
+	return mDisk.locate(p, mCellPtr[cell] < mCellPtr[cell + 1] ? mCellFaces[mCellPtr[cell]] : -1);
+}
+
+
+RecordingLocator::RecordingLocator(const PointLocator& locator) : PointLocator(locator.disk()), mLocator(locator)
+{
+#ifdef _OPENMP
+	mBuffers.resize(omp_get_max_threads());
+#else
+	mBuffers.resize(1);
+#endif
+}
+
+RecordingLocator::Buffer& RecordingLocator::buffer(std::unique_lock<std::mutex>& lock) const
+{
+#ifdef _OPENMP
+	int thread = omp_get_thread_num();
+	if (thread < (int)mBuffers.size())
+		return mBuffers[thread];
+	lock = std::unique_lock<std::mutex>(mMutex);
+	return mSharedBuffer;
+#else
+	return mBuffers[0];
+#endif
+}
+
+void RecordingLocator::record(const EPoint_2& p) const
+{
+	std::unique_lock<std::mutex> lock;
+	buffer(lock).points.push_back(p);
+}
+
+void RecordingLocator::record(double x, double y) const
+{
+	std::unique_lock<std::mutex> lock;
+	Buffer& b = buffer(lock);
+	b.xy.push_back(x);
+	b.xy.push_back(y);
+}
+
+DiskLocator::Location RecordingLocator::locate(const EPoint_2& p) const
+{
+	record(p);
+	return mLocator.locate(p);
+}
+
+DiskLocator::Location RecordingLocator::locateFrom(const EPoint_2& p, int hintFace) const
+{
+	record(p);
+	return mLocator.locateFrom(p, hintFace);
+}
+
+DiskLocator::Location RecordingLocator::locateDouble(double x, double y, int hintFace) const
+{
+	record(x, y);
+	return mLocator.locateDouble(x, y, hintFace);
+}
+
+const std::vector<EPoint_2>& RecordingLocator::queries() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	for (int t = 0; t <= (int)mBuffers.size(); ++t)
+	{
+		Buffer& b = (t < (int)mBuffers.size()) ? mBuffers[t] : mSharedBuffer;
+		mQueries.insert(mQueries.end(), b.points.begin(), b.points.end());
+		for (int i = 0; i + 1 < (int)b.xy.size(); i += 2)
+			mQueries.push_back(EPoint_2(b.xy[i], b.xy[i + 1]));
+		b.points.clear();
+		b.xy.clear();
+	}
+	return mQueries;
+}
+
+void benchmarkPointLocators(const std::vector<EPoint_2>& queries, const DiskLocator& disk, Mesh& mesh, std::ostream& out)
+{
+	const std::vector<std::string>& names = PointLocator::policies();
+	std::vector<DiskLocator::Location> reference;
+
+	out << "Point location benchmark (" << queries.size() << " queries, " << disk.numFaces() << " faces):\n";
+	for (int n = 0; n < (int)names.size(); ++n)
+	{
+		PointLocator* locator = PointLocator::create(names[n], disk, mesh);
+
+		CGAL::Timer buildTimer, queryTimer;
+		buildTimer.start();
+		locator->build();
+		buildTimer.stop();
+
+		std::vector<DiskLocator::Location> results(queries.size());
+		queryTimer.start();
+		for (int i = 0; i < (int)queries.size(); ++i)
+			results[i] = locator->locate(queries[i]);
+		queryTimer.stop();
+
+		//a point on a vertex or an edge may be reported in any of the incident faces
+		int numDifferent = 0;
+		if (reference.empty())
+			reference = results;
+		else
+		{
+			for (int i = 0; i < (int)queries.size(); ++i)
+			{
+				if (results[i].type != reference[i].type)
+					numDifferent++;
+				else if (results[i].type == DiskLocator::FACE && results[i].face != reference[i].face)
+					numDifferent++;
+			}
+		}
+
+		out << "  " << names[n] << ":\tbuild " << buildTimer.time() << " s,\tqueries " << queryTimer.time() << " s";
+		if (n > 0)
+			out << ",\t" << numDifferent << " different answers";
+		out << "\n";
+		delete locator;
+	}
+}
@@ -0,0 +1,200 @@
+#pragma once
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Point location strategies for the target disk map. All of them answer with a DiskLocator::Location, so
+// the composition code does not depend on the strategy:
+//   walk            - visibility walk of DiskLocator (the default)
+//   landmarks       - CGAL landmarks over the arrangement of the disk map
+//   trapezoid       - CGAL trapezoidal map (randomized incremental construction)
+//   walk-along-line - CGAL walk along a vertical line
+//   grid            - uniform bucket grid of faces over the disk
+// The arrangement strategies build their own arrangement of the disk map.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <mutex>
+
+
+class PointLocator
+{
+public:
+
+	PointLocator(const DiskLocator& disk) : mDisk(disk) {}
+	virtual ~PointLocator() {}
+
+	virtual const char* name() const = 0;
+	virtual void build() {} //called after the disk locator was built
+	virtual DiskLocator::Location locate(const EPoint_2& p) const = 0;
+	virtual DiskLocator::Location locateFrom(const EPoint_2& p, int hintFace) const { return locate(p); } //hintFace is a face near p or -1
+
+	//queries on doubles. if isThreadSafe() they may be called concurrently, and so may the exact queries on points
+	//which are not shared between the threads.
+	virtual bool isThreadSafe() const { return false; }
+	virtual DiskLocator::Location locateDouble(double x, double y, int hintFace) const { return locateFrom(EPoint_2(x, y), hintFace); }
+
+	//locates the points in the order of a Hilbert curve over the disk, so every query starts near the previous answer
+	void locateBatch(const std::vector<EPoint_2>& points, std::vector<DiskLocator::Location>& locations) const;
+
+	const DiskLocator& disk() const { return mDisk; }
+
+	//returns NULL for an unknown policy
+	static PointLocator* create(const std::string& policy, const DiskLocator& disk, Mesh& mesh);
+	static const std::vector<std::string>& policies();
+
+protected:
+
+	const DiskLocator& mDisk;
+};
+
+
+class WalkLocator : public PointLocator
+{
+public:
+
+	WalkLocator(const DiskLocator& disk) : PointLocator(disk) {}
+
+	const char* name() const { return "walk"; }
+	DiskLocator::Location locate(const EPoint_2& p) const { return mDisk.locate(p); }
+	DiskLocator::Location locateFrom(const EPoint_2& p, int hintFace) const { return mDisk.locate(p, hintFace); }
+	bool isThreadSafe() const { return true; }
+	DiskLocator::Location locateDouble(double x, double y, int hintFace) const { return mDisk.locate(x, y, hintFace); }
+};
+
+
+class GridLocator : public PointLocator
+{
+public:
+
+	GridLocator(const DiskLocator& disk) : PointLocator(disk), mGridSize(0), mMinX(0.0), mMinY(0.0), mCellSize(1.0) {}
+
+	const char* name() const { return "grid"; }
+	void build();
+	DiskLocator::Location locate(const EPoint_2& p) const;
+	bool isThreadSafe() const { return true; }
+	DiskLocator::Location locateDouble(double x, double y, int hintFace) const;
+
+protected:
+
+	int cell(double x, double y) const;
+
+protected:
+
+	int mGridSize;
+	double mMinX, mMinY, mCellSize;
+	std::vector<int> mCellPtr, mCellFaces; //faces whose bounding box overlaps every cell
+};
+
+
+//Strategy is one of the CGAL arrangement point location classes
+template <class Strategy>
+class ArrangementLocator : public PointLocator
+{
+public:
+
+	ArrangementLocator(const DiskLocator& disk, Mesh& mesh, const char* name) : PointLocator(disk), mMesh(mesh), mName(name) {}
+
+	const char* name() const { return mName; }
+
+	void build()
+	{
+		BuildArrangement(mArr, mDisk.points(), mDisk.faces(), mMesh);
+		mStrategy.attach(mArr);
+	}
+
+	DiskLocator::Location locate(const EPoint_2& p) const
+	{
+		DiskLocator::Location location;
+		typename Strategy::result_type result = mStrategy.locate(p);
+		Arrangement_2::Face_const_handle face;
+		Arrangement_2::Vertex_const_handle vertex;
+		Arrangement_2::Halfedge_const_handle halfedge;
+
+		if (CGAL::assign(face, result))
+		{
+			if (face->is_unbounded())
+				return location;
+			location.type = DiskLocator::FACE;
+		}
+		else if (CGAL::assign(vertex, result))
+		{
+			location.type = DiskLocator::VERTEX;
+			location.v1 = vertex->data()->index();
+			face = vertex->incident_halfedges()->face();
+			if (face->is_unbounded())
+				face = vertex->incident_halfedges()->twin()->face();
+		}
+		else if (CGAL::assign(halfedge, result))
+		{
+			location.type = DiskLocator::EDGE;
+			location.v1 = halfedge->source()->data()->index();
+			location.v2 = halfedge->target()->data()->index();
+			face = halfedge->face();
+			if (face->is_unbounded())
+				face = halfedge->twin()->face();
+		}
+		else
+			return location;
+
+		location.face = face->data()->index();
+		return location;
+	}
+
+protected:
+
+	Mesh& mMesh;
+	const char* mName;
+	Arrangement_2 mArr;
+	Strategy mStrategy;
+};
+
+
+//forwards to another locator and keeps the queries, to replay them in benchmarkPointLocators. It is thread safe when
+//the locator is, so recording does not move the callers to their serial paths: every OpenMP thread records into a
+//buffer of its own, and queries() merges the buffers (thread by thread) once the queries are done.
+class RecordingLocator : public PointLocator
+{
+public:
+
+	RecordingLocator(const PointLocator& locator);
+
+	const char* name() const { return mLocator.name(); }
+	DiskLocator::Location locate(const EPoint_2& p) const;
+	DiskLocator::Location locateFrom(const EPoint_2& p, int hintFace) const;
+	bool isThreadSafe() const { return mLocator.isThreadSafe(); }
+	DiskLocator::Location locateDouble(double x, double y, int hintFace) const;
+
+	const std::vector<EPoint_2>& queries() const;
+
+protected:
+
+	struct Buffer
+	{
+		std::vector<EPoint_2> points;
+		std::vector<double> xy; //the double queries, kept as doubles so that recording makes no exact points
+	};
+
+	void record(const EPoint_2& p) const;
+	void record(double x, double y) const;
+	Buffer& buffer(std::unique_lock<std::mutex>& lock) const;
+
+protected:
+
+	const PointLocator& mLocator;
+	mutable std::vector<Buffer> mBuffers; //one per thread
+	mutable Buffer mSharedBuffer; //threads beyond the ones counted at construction (nested regions), under mMutex
+	mutable std::mutex mMutex;
+	mutable std::vector<EPoint_2> mQueries;
+};
+
+
+//indices of the points sorted along a Hilbert curve over their bounding box
+void hilbertSort(const std::vector<EPoint_2>& points, std::vector<int>& order);
+void hilbertSort(const std::vector<double>& x, const std::vector<double>& y, std::vector<int>& order);
+
+//builds every strategy over the disk map and replays the queries. prints the build and query times and the number
+//of answers which disagree with the walk.
+void benchmarkPointLocators(const std::vector<EPoint_2>& queries, const DiskLocator& disk, Mesh& mesh, std::ostream& out);
@@ -0,0 +1,99 @@
+#include "RunOptions.h"
+
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+
+RunOptions::RunOptions() : nativeSolver(false), nativeWorkspace(false), sweepArrangement(false), locator("walk"), reorder("none"), benchmarkLocators(false)
+{
+}
+
+RunOptions& RunOptions::Get()
+{
+	static RunOptions options;
+	return options;
+}
+
+void RunOptions::printUsage() const
+{
+	std::cout << "Options:\n"
+		<< "  --source <file>          source mesh, an obj file or a .mcache mesh cache (default: chosen in a file dialog)\n"
+		<< "  --target <file>          target spec file: polygon, rotation indices, orientation and weights (default: the MATLAB stages)\n"
+		<< "                           repeat it to map the source to several targets in one run\n"
+		<< "  --output <file>          write the parametrized mesh to an obj file (uvs as vt) or a .mcache mesh cache\n"
+		<< "                           with several targets, give one --output per target, in the same order\n"
+		<< "  --convert-cache <obj> <mcache>  write the mesh cache of an obj file and exit\n"
+		<< "  --native-solver          solve the disk maps in process (multigrid preconditioned CG)\n"
+		<< "  --native-workspace       run without MATLAB, the MATLAB stages are done in process (needs --target)\n"
+		<< "  --solver-tol <t>         relative residual of the native solver (default " << solver.tolerance << ")\n"
+		<< "  --solver-max-iter <n>    iteration limit of the native solver (default " << solver.maxIterations << ")\n"
+		<< "  --solver-threads <n>     number of threads of the native solver (default: all cores)\n"
+		<< "  --sweep-arrangement      build the arrangements with the sweep line instead of from the mesh connectivity\n"
+		<< "  --locator <policy>       point location in the target disk: walk, landmarks, trapezoid, walk-along-line or grid (default walk)\n"
+		<< "  --reorder <policy>       renumber the meshes for memory locality: none, rcm or morton (default none)\n"
+		<< "  --benchmark-locators     replay the target point location queries with every policy\n"
+		<< "  --verbose                print solver statistics\n";
+}
+
+bool RunOptions::parse(int argc, char* argv[])
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		const char* arg = argv[i];
+		bool hasValue = (i + 1 < argc);
+
+		if (!strcmp(arg, "--source") && hasValue)
+			sourceMesh = argv[++i];
+		else if (!strcmp(arg, "--target") && hasValue)
+			targetSpecs.push_back(argv[++i]);
+		else if (!strcmp(arg, "--output") && hasValue)
+			outputMeshes.push_back(argv[++i]);
+		else if (!strcmp(arg, "--convert-cache") && i + 2 < argc)
+		{
+			convertObj = argv[++i];
+			convertCache = argv[++i];
+		}
+		else if (!strcmp(arg, "--native-solver"))
+			nativeSolver = true;
+		else if (!strcmp(arg, "--native-workspace"))
+			nativeWorkspace = true;
+		else if (!strcmp(arg, "--solver-tol") && hasValue)
+			solver.tolerance = atof(argv[++i]);
+		else if (!strcmp(arg, "--solver-max-iter") && hasValue)
+			solver.maxIterations = atoi(argv[++i]);
+		else if (!strcmp(arg, "--solver-threads") && hasValue)
+			solver.numThreads = atoi(argv[++i]);
+		else if (!strcmp(arg, "--sweep-arrangement"))
+			sweepArrangement = true;
+		else if (!strcmp(arg, "--locator") && hasValue)
+			locator = argv[++i];
+		else if (!strcmp(arg, "--reorder") && hasValue)
+			reorder = argv[++i];
+		else if (!strcmp(arg, "--benchmark-locators"))
+			benchmarkLocators = true;
+		else if (!strcmp(arg, "--verbose"))
+			solver.verbose = true;
+		else
+		{
+			std::cerr << "Unknown option: " << arg << "\n";
+			printUsage();
+			return false;
+		}
+	}
+#ifdef NO_MATLAB
+	nativeWorkspace = true;	//built without the engine
+#endif
+	if (nativeWorkspace && targetSpecs.empty())
+	{
+		std::cerr << "--native-workspace needs --target, the target polygon is asked for in MATLAB otherwise\n";
+		return false;
+	}
+	if (!outputMeshes.empty() && outputMeshes.size() != (std::max)(targetSpecs.size(), (size_t)1))
+	{
+		std::cerr << "give one --output for every --target\n";
+		return false;
+	}
+	return true;
+}
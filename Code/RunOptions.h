@@ -0,0 +1,36 @@
+#pragma once
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Run time options of the application, parsed once from the command line in main()
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "HarmonicSolver.h"
+
+#include <string>
+#include <vector>
+
+
+struct RunOptions
+{
+	RunOptions();
+
+	bool parse(int argc, char* argv[]);
+	void printUsage() const;
+
+	static RunOptions& Get();
+
+	bool nativeSolver; //solve the disk maps in process instead of in the MATLAB stages
+	bool nativeWorkspace; //run without MATLAB: the exchanged matrices and the evaluated stages are handled by NativeWorkspace
+	bool sweepArrangement; //build the disk map arrangements with the sweep line and locate based matching
+	std::string locator; //point location policy in the target disk map, see PointLocator::create
+	std::string reorder; //renumbering of the source and target meshes, see MeshReordering
+	bool benchmarkLocators; //replay the target queries with every point location policy
+	std::string sourceMesh; //obj file or mesh cache of the source mesh, asked for with a file dialog if empty
+	//target polygon, rotation indices and weights (see TargetSpec), asked for in MATLAB if empty. the source is loaded
+	//once and mapped to every target in turn, and the solver setups are reused between the targets.
+	std::vector<std::string> targetSpecs;
+	//if set, one per target: the parametrized mesh is written to this obj file or mesh cache instead of sent to MATLAB
+	std::vector<std::string> outputMeshes;
+	std::string convertObj, convertCache; //if set, main only converts the obj file to a mesh cache
+	HarmonicSolverOptions solver;
+};
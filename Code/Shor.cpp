@@ -588,10 +588,11 @@ void sendToMatlab(std::vector<std::complex<double>>& meshVertices, std::vector<u
 		ff(index, 2) = triangleIndices[i+2];
 		index++;
 	}
-	MatlabGMMDataExchange::SetEngineDenseMatrix("pp", pp);
-	MatlabGMMDataExchange::SetEngineDenseMatrix("ff", ff);
-	MatlabInterface::GetEngine().Eval("ff=ff+1;trimesh( ff , pp(:,1) , pp(:,2) );hold on");
-
+	VisualizationFrame frame;
+	frame.add("pp", pp);
+	frame.add("ff", ff);
+	frame.command = "ff=ff+1;trimesh( ff , pp(:,1) , pp(:,2) );hold on";
+	VisualizationSink::Get().post(frame);
 }
 
 void Shor::simplify_triangulation()
@@ -860,6 +861,10 @@ void Shor::simplify_triangulation()
 
 
 
+	//the pieces are concatenated, so the target is renumbered for locality. nothing is written in the target order.
+	MeshReordering targetOrder;
+	targetOrder.apply(RunOptions::Get().reorder, pVec, fVec);
+
 	GMMDenseComplexColMatrix mesh_mat(pVec.size(),1);
 	GMMDenseColMatrix tri_indices(fVec.size(),1);
 	for ( int i = 0; i < (int)pVec.size(); ++i )
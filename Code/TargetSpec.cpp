@@ -0,0 +1,133 @@
+#include "stdafx.h"
+
+#include <fstream>
+#include <sstream>
+
+
+TargetSpec::TargetSpec() : mReverse(false), mSourceHarmonic(true), mTargetHarmonic(true)
+{
+}
+
+//true for harmonic (cotangent) weights, false for mean value weights
+static bool parseWeights(const std::string& name, bool& isHarmonic)
+{
+	if (name == "harmonic")
+		isHarmonic = true;
+	else if (name == "mean-value")
+		isHarmonic = false;
+	else
+		return false;
+	return true;
+}
+
+bool TargetSpec::load(const std::string& filename, std::string& error)
+{
+	std::ifstream in(filename.c_str());
+	if (!in.is_open())
+	{
+		error = "could not open " + filename;
+		return false;
+	}
+
+	*this = TargetSpec();
+	bool hasHeader = false;
+	int numVertices = -1;
+	std::string line;
+	for (int lineNumber = 1; std::getline(in, line); ++lineNumber)
+	{
+		size_t comment = line.find('#');
+		if (comment != std::string::npos)
+			line.erase(comment);
+		std::istringstream fields(line);
+		std::string keyword;
+		if (!(fields >> keyword))
+			continue;
+
+		std::ostringstream where;
+		where << filename << ":" << lineNumber << ": ";
+		std::string rest;
+		bool isValid = true;
+
+		if (!hasHeader)
+		{
+			int version = 0;
+			if (keyword != "target-spec" || !(fields >> version))
+			{
+				error = where.str() + "not a target spec (expected 'target-spec 1')";
+				return false;
+			}
+			if (version != 1)
+			{
+				error = where.str() + "unsupported target spec version";
+				return false;
+			}
+			hasHeader = true;
+		}
+		else if ((int)mVertices.size() < numVertices)
+		{
+			//a vertex line, so the keyword is the x coordinate
+			double x, y;
+			int rotIndex;
+			std::istringstream vertex(line);
+			if (!(vertex >> x >> y >> rotIndex) || rotIndex < 0 || (vertex >> rest))
+			{
+				error = where.str() + "expected '<x> <y> <rotation index>' with a rotation index >= 0";
+				return false;
+			}
+			mVertices.push_back(Point_2(x, y));
+			mRotIndices.push_back(rotIndex);
+			continue;
+		}
+		else if (keyword == "orientation")
+		{
+			std::string orientation;
+			isValid = (fields >> orientation) && (orientation == "keep" || orientation == "reverse");
+			mReverse = (orientation == "reverse");
+		}
+		else if (keyword == "weights")
+		{
+			std::string source, target;
+			isValid = (fields >> source >> target) && parseWeights(source, mSourceHarmonic) && parseWeights(target, mTargetHarmonic);
+		}
+		else if (keyword == "vertices" && numVertices == -1)
+			isValid = (fields >> numVertices) && numVertices >= 3;
+		else
+		{
+			error = where.str() + "unexpected '" + keyword + "'";
+			return false;
+		}
+
+		if (!isValid || (fields >> rest))
+		{
+			error = where.str() + "invalid '" + keyword + "' line";
+			return false;
+		}
+	}
+
+	if (!hasHeader)
+		error = filename + " is empty";
+	else if (numVertices == -1)
+		error = filename + " has no vertices";
+	else if ((int)mVertices.size() < numVertices)
+		error = filename + " has fewer vertices than declared";
+	else
+		return true;
+	return false;
+}
+
+void TargetSpec::getPolygon(Polygon_2& poly) const
+{
+	poly.clear();
+	if (mReverse)
+		poly.insert(poly.vertices_end(), mVertices.rbegin(), mVertices.rend());
+	else
+		poly.insert(poly.vertices_end(), mVertices.begin(), mVertices.end());
+}
+
+void TargetSpec::getRotationIndices(std::vector<int>& rotIndices) const
+{
+	if (mReverse)
+		rotIndices.assign(mRotIndices.rbegin(), mRotIndices.rend());
+	else
+		rotIndices.assign(mRotIndices.begin(), mRotIndices.end());
+}
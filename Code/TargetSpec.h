@@ -0,0 +1,43 @@
+#pragma once
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// The target of the map, read from a file instead of the interactive MATLAB stages (nis2 and nis3).
+// A text file of keyword lines, '#' starts a comment:
+//   target-spec 1
+//   orientation keep|reverse                       (optional, default keep)
+//   weights harmonic|mean-value harmonic|mean-value (optional, source then target, default harmonic harmonic)
+//   vertices <n>
+//   <x> <y> <rotation index>                       (n lines, in the order of the polygon)
+// reverse reverses the order of the vertices and of their rotation indices, as the flip option of stage 3.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include <string>
+#include <vector>
+
+
+class TargetSpec
+{
+public:
+
+	TargetSpec();
+
+	//on failure returns false and sets error
+	bool load(const std::string& filename, std::string& error);
+
+	//the polygon and its rotation indices, in the order of the orientation
+	void getPolygon(Polygon_2& poly) const;
+	void getRotationIndices(std::vector<int>& rotIndices) const;
+	int size() const { return (int)mVertices.size(); }
+
+	bool isSourceHarmonic() const { return mSourceHarmonic; }
+	bool isTargetHarmonic() const { return mTargetHarmonic; }
+
+protected:
+
+	std::vector<Point_2> mVertices; //in file order
+	std::vector<int> mRotIndices;
+	bool mReverse;
+	bool mSourceHarmonic, mTargetHarmonic;
+};
@@ -0,0 +1,101 @@
+#include "stdafx.h"
+
+
+void MatlabVisualizationBackend::show(VisualizationFrame& frame)
+{
+	std::lock_guard<std::recursive_mutex> lock(MatlabInterface::EngineMutex());
+	for (int i = 0; i < (int)frame.matrices.size(); ++i)
+		MatlabGMMDataExchange::SetEngineDenseMatrix(frame.matrices[i].first.c_str(), frame.matrices[i].second);
+	if (!frame.command.empty())
+		MatlabInterface::GetEngine().Eval(frame.command.c_str());
+}
+
+
+VisualizationSink::VisualizationSink() : mBackend(NULL), mCapacity(8), mNumDropped(0), mIsStarted(false), mIsFinishing(false), mIsDraining(false)
+{
+}
+
+VisualizationSink::~VisualizationSink()
+{
+	finish();
+	delete mBackend;
+}
+
+VisualizationSink& VisualizationSink::Get()
+{
+	static VisualizationSink sink;
+	return sink;
+}
+
+void VisualizationSink::post(const VisualizationFrame& frame)
+{
+	VisualizationFrame snapshot(frame); //copied before the lock, so other posting threads are not held up
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	if (!mIsStarted)
+	{
+		mIsStarted = true;
+		if (!NativeWorkspace::IsActive())
+			mBackend = new MatlabVisualizationBackend;
+	}
+	if (mBackend == NULL || mIsFinishing)
+	{
+		mNumDropped++;
+		return;
+	}
+
+	if ((int)mFrames.size() >= mCapacity)
+	{
+		std::deque<VisualizationFrame>::iterator oldest = mFrames.begin();
+		while (oldest != mFrames.end() && !oldest->isDroppable)
+			++oldest;
+		if (oldest == mFrames.end() && snapshot.isDroppable)
+		{
+			mNumDropped++;
+			return;
+		}
+		if (oldest != mFrames.end())
+		{
+			mFrames.erase(oldest);
+			mNumDropped++;
+		}
+	}
+	mFrames.push_back(VisualizationFrame());
+	std::swap(mFrames.back(), snapshot);
+}
+
+void VisualizationSink::drain()
+{
+	if (mIsDraining)
+		return;
+	mIsDraining = true;
+	while (true)
+	{
+		VisualizationFrame frame;
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			if (mFrames.empty())
+				break;
+			std::swap(frame, mFrames.front());
+			mFrames.pop_front();
+		}
+		mBackend->show(frame);
+	}
+	mIsDraining = false;
+}
+
+void VisualizationSink::finish()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		if (mIsFinishing)
+			return;
+		mIsFinishing = true;
+		if (mBackend == NULL)
+			return;
+	}
+	std::lock_guard<std::recursive_mutex> lock(MatlabInterface::EngineMutex());
+	drain();
+	if (mNumDropped > 0)
+		std::cout << "Visualization: " << mNumDropped << " frames were dropped\n";
+}
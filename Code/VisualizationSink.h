@@ -0,0 +1,82 @@
+#pragma once
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// Deferred display of snapshots (the debug plots and the final resMap). post copies the frame to a bounded queue and
+// returns, from any thread. The engine has one owner, the compute thread: MatlabInterface::Eval drains the queue
+// before it evaluates the code of the compute, so the frames are shown in the order of post and only between the
+// engine calls of the compute, and finish shows the rest (main calls it after the run).
+// When the queue is full the oldest droppable frame is dropped, frames which are not droppable (the results) are
+// always kept. With the native workspace there is no display and the frames are dropped as they come.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "GMM_Macros.h"
+
+#include <deque>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+struct VisualizationFrame
+{
+	VisualizationFrame() : isDroppable(true) {}
+
+	void add(const char* name, const GMMDenseColMatrix& matrix) { matrices.push_back(std::make_pair(std::string(name), matrix)); }
+
+	std::vector<std::pair<std::string, GMMDenseColMatrix> > matrices; //set before the command
+	std::string command; //e.g. "figure;impoly(gca,testPoly)"
+	bool isDroppable;
+};
+
+
+class VisualizationBackend
+{
+public:
+
+	virtual ~VisualizationBackend() {}
+	virtual void show(VisualizationFrame& frame) = 0;
+};
+
+
+class MatlabVisualizationBackend : public VisualizationBackend
+{
+public:
+
+	void show(VisualizationFrame& frame);
+};
+
+
+class VisualizationSink
+{
+public:
+
+	static VisualizationSink& Get();
+
+	void post(const VisualizationFrame& frame);
+	//shows the queued frames. only on the thread which owns the engine, with MatlabInterface::EngineMutex held.
+	void drain();
+	void finish();
+
+	void setCapacity(int capacity) { mCapacity = capacity; }
+	int numDropped() const { return mNumDropped; }
+
+protected:
+
+	VisualizationSink();
+	~VisualizationSink();
+	VisualizationSink(const VisualizationSink&);
+	VisualizationSink& operator=(const VisualizationSink&);
+
+protected:
+
+	VisualizationBackend* mBackend; //NULL - no display
+	std::mutex mMutex; //guards the queue, post may come from any thread
+	std::deque<VisualizationFrame> mFrames;
+	int mCapacity;
+	int mNumDropped;
+	bool mIsStarted, mIsFinishing;
+	bool mIsDraining; //the frames of drain evaluate their commands, which must not drain again
+};
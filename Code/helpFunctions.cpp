@@ -8,7 +8,7 @@ CGAL::Vector_3<Kernel> normalizeVector(CGAL::Vector_3<Kernel>& v)
 	return (CGAL::Vector_3<Kernel>( v[0] / len , v[1] / len ,v[2] / len) );
 }
 
-void matchPointsIndices(Arrangement_2& arrSource, const std::vector<EPoint_2>& sourceHarmonicMapPoints, const Landmarks_pl& sourceLandMark, Mesh& sourceMesh)
+void matchPointsIndices(Arrangement_2& arrSource, const std::vector<Point_2>& sourceHarmonicMapPoints, const Landmarks_pl& sourceLandMark, Mesh& sourceMesh)
 {
 	/*auto it = arrSource.vertices_begin();
 	while ( it!= arrSource.vertices_end() )
@@ -43,7 +43,7 @@ void matchPointsIndices(Arrangement_2& arrSource, const std::vector<EPoint_2>& s
 	{
 		index = vIt->index();
 		vIt->userIndex() = index;
-		auto res = sourceLandMark.locate(sourceHarmonicMapPoints[index]);
+		auto res = sourceLandMark.locate(EPoint_2(sourceHarmonicMapPoints[index].x(), sourceHarmonicMapPoints[index].y()));
 		Arrangement_2::Vertex_const_iterator vertex;
 		CGAL::assign(vertex, res);
 		if (vertex.ptr() == nullptr)
@@ -87,7 +87,7 @@ void matchEdges(Arrangement_2& arr, Mesh& source_mesh)
 
 }
 
-void matchFaces(Arrangement_2& arr, const std::vector<EPoint_2>& mapPoints, const std::vector<int> &fVec, Landmarks_pl& trap, Mesh& sourceMesh)
+void matchFaces(Arrangement_2& arr, const std::vector<Point_2>& mapPoints, const std::vector<int> &fVec, Landmarks_pl& trap, Mesh& sourceMesh)
 {
 	/*Arrangement_2::Face_handle face = arr.faces_begin();
 	const Arrangement_2::Face_handle faceEnd = arr.faces_end();
@@ -119,9 +119,9 @@ void matchFaces(Arrangement_2& arr, const std::vector<EPoint_2>& mapPoints, cons
 	int index = 0;
 	for (int i = 0; i < arr.number_of_faces() - 1; ++i)
 	{
-		ARRNumberType x = mapPoints[fVec[index]].x() + mapPoints[fVec[index + 1]].x() + mapPoints[fVec[index + 2]].x();
+		ARRNumberType x = ARRNumberType(mapPoints[fVec[index]].x()) + mapPoints[fVec[index + 1]].x() + mapPoints[fVec[index + 2]].x();
 		x = x / 3;
-		ARRNumberType y = mapPoints[fVec[index]].y() + mapPoints[fVec[index + 1]].y() + mapPoints[fVec[index + 2]].y();
+		ARRNumberType y = ARRNumberType(mapPoints[fVec[index]].y()) + mapPoints[fVec[index + 1]].y() + mapPoints[fVec[index + 2]].y();
 		y = y / 3;
 		EPoint_2 p(x, y);
 
@@ -143,60 +143,116 @@ void matchFaces(Arrangement_2& arr, const std::vector<EPoint_2>& mapPoints, cons
 
 }
 
-void loadSourceMesh( Mesh &source_mesh , std::vector<Kernel::Point_3> &pVec , std::vector<int> &fVec  )
+bool loadSourceMesh( Mesh &source_mesh , std::vector<Kernel::Point_3> &pVec , std::vector<int> &fVec , MeshReordering &reordering )
 {
 	MatlabInterface::GetEngine().Eval( "nis" );
 	//---------------load source mesh----------------------------
 	Wavefront_obj objParser;
-	const int strMaxLen = 10000;
-	OPENFILENAME ofn = {0};
-	TCHAR fileStr[strMaxLen] = {0};
-
-	ofn.lStructSize = sizeof(ofn);
-	ofn.lpstrFile = fileStr;
-	ofn.lpstrFile[0] = '\0';
-	ofn.nMaxFile = sizeof(fileStr)/sizeof(TCHAR) - 1;
-
-	GetOpenFileName(&ofn);
+	std::string fileName = RunOptions::Get().sourceMesh;
+#ifdef _WIN32
+	if (fileName.empty())
+	{
+		const int strMaxLen = 10000;
+		OPENFILENAME ofn = {0};
+		TCHAR fileStr[strMaxLen] = {0};
+
+		ofn.lStructSize = sizeof(ofn);
+		ofn.lpstrFile = fileStr;
+		ofn.lpstrFile[0] = '\0';
+		ofn.nMaxFile = sizeof(fileStr)/sizeof(TCHAR) - 1;
+
+		GetOpenFileName(&ofn);
+		for ( int i = 0; i < (int)strlen(fileStr); ++i)
+			fileName.push_back( (char)fileStr[i] );
+	}
+#endif
+	if (fileName.empty())
+	{
+		std::cerr << "No source mesh, use --source\n";
+		return false;
+	}
 	std::cout << "Loading source mesh...\n";
-	std::wstring str;
-	
-	for ( int i = 0; i < (int)strlen(fileStr); ++i)
-		str.push_back( fileStr[i] );
-	
-	objParser.load_file( str );
+
+	//a mesh cache (see MeshCache::convert) is mapped, an obj file is parsed
+	std::vector<double> uvs; //u, v of every texture coordinate
+	std::string error;
+	if (MeshCache::isCacheFile(fileName))
+	{
+		MeshCache cache;
+		if (!cache.open(fileName, error))
+		{
+			std::cerr << "Could not load the source mesh: " << error << "\n";
+			return false;
+		}
+		const double* positions = cache.positions();
+		pVec.reserve(cache.numVertices());
+		for ( int i = 0 ; i < cache.numVertices() ; ++i )
+			pVec.push_back( Kernel::Point_3( positions[3 * i], positions[3 * i + 1], positions[3 * i + 2] ) );
+		fVec.assign( cache.faces(), cache.faces() + 3 * cache.numFaces() );
+		uvs.assign( cache.uvs(), cache.uvs() + 2 * cache.numUVs() );
+	}
+	else
+	{
+		if (!objParser.load(fileName, error))
+		{
+			std::cerr << "Could not load the source mesh: " << error << "\n";
+			return false;
+		}
+		pVec.reserve(objParser.m_points.size());
+		for ( int i = 0 ; i < (int)objParser.m_points.size() ; ++i )
+			pVec.push_back( Kernel::Point_3( objParser.m_points[i][0], objParser.m_points[i][1], objParser.m_points[i][2] ) );
+		fVec.reserve(3 * objParser.m_faces.size());
+		for ( int i = 0 ; i < (int)objParser.m_faces.size() ; ++i )
+		{
+			fVec.push_back( objParser.m_faces[i].v[0]);
+			fVec.push_back( objParser.m_faces[i].v[1]);
+			fVec.push_back( objParser.m_faces[i].v[2]);
+		}
+		uvs.reserve(2 * objParser.m_textureCoordinates.size());
+		for ( int i = 0 ; i < (int)objParser.m_textureCoordinates.size() ; ++i )
+		{
+			uvs.push_back( objParser.m_textureCoordinates[i][0] );
+			uvs.push_back( objParser.m_textureCoordinates[i][1] );
+		}
+	}
+	if (uvs.size() < 2 * pVec.size())
+	{
+		std::cerr << "Could not load the source mesh: " << fileName << " needs a texture coordinate for every vertex\n";
+		return false;
+	}
 	
-	int p_size = (int)objParser.m_points.size();
+	int p_size = (int)pVec.size();
 	GMMDenseColMatrix m_points(p_size,3);
 	for ( int i = 0 ; i < p_size ; ++i )
 	{
-		Kernel::Point_3 point( objParser.m_points[i][0], objParser.m_points[i][1], objParser.m_points[i][2] );
-		pVec.push_back( point );
-		m_points(i,0) = objParser.m_points[i][0];
-		m_points(i,1) = objParser.m_points[i][1];
-		m_points(i,2) = objParser.m_points[i][2];
+		m_points(i,0) = pVec[i].x();
+		m_points(i,1) = pVec[i].y();
+		m_points(i,2) = pVec[i].z();
 	}
 	
-	int f_size = (int)objParser.m_faces.size();
+	int f_size = (int)fVec.size() / 3;
 	GMMDenseColMatrix m_faces(f_size,3);
 	for ( int i = 0 ; i < f_size ; ++i )
 	{
-		fVec.push_back( objParser.m_faces[i].v[0]);
-		fVec.push_back( objParser.m_faces[i].v[1]);
-		fVec.push_back( objParser.m_faces[i].v[2]);
-		m_faces(i,0) = objParser.m_faces[i].v[0];
-		m_faces(i,1) = objParser.m_faces[i].v[1];
-		m_faces(i,2) = objParser.m_faces[i].v[2];
+		m_faces(i,0) = fVec[3 * i];
+		m_faces(i,1) = fVec[3 * i + 1];
+		m_faces(i,2) = fVec[3 * i + 2];
 	}
 
-	int t_size = (int)objParser.m_textureCoordinates.size();
+	int t_size = (int)uvs.size() / 2;
 	GMMDenseColMatrix t_points(t_size, 2);
 	for (int i = 0; i < t_size; ++i)
 	{
-		t_points(i, 0) = objParser.m_textureCoordinates[i][0];
-		t_points(i, 1) = objParser.m_textureCoordinates[i][1];
+		t_points(i, 0) = uvs[2 * i];
+		t_points(i, 1) = uvs[2 * i + 1];
 	}
 
+	//matlab gets the mesh in the file order, like the final outputs (resMap draws m_faces with finalOut). from here on
+	//the vertices and faces are in the order of the run.
+	if (!reordering.apply(RunOptions::Get().reorder, pVec, fVec))
+		std::cerr << "Unknown reordering policy: " << RunOptions::Get().reorder << ", keeping the order of the file\n";
+	reordering.permute(uvs, 2);
+
 	//-----------------finish loading--------------------------------
 	//-----------------build mesh-------------------------------
 	MeshBuilder<Mesh::HalfedgeDS,Kernel> meshBuilder( &pVec, &fVec );
@@ -208,7 +264,7 @@ void loadSourceMesh( Mesh &source_mesh , std::vector<Kernel::Point_3> &pVec , st
 	while (sourceVertices != source_mesh.vertices_end())
 	{
 		int index = sourceVertices->index();
-		sourceVertices->uv() = Point_3(objParser.m_textureCoordinates[index][0], objParser.m_textureCoordinates[index][1], 0);
+		sourceVertices->uv() = Point_3(uvs[2 * index], uvs[2 * index + 1], 0);
 		sourceVertices++;
 	}
 	//---------------pass matlab the mesh----------------------
@@ -217,16 +273,24 @@ void loadSourceMesh( Mesh &source_mesh , std::vector<Kernel::Point_3> &pVec , st
 	MatlabGMMDataExchange::SetEngineDenseMatrix("t_points", t_points);
 	MatlabInterface::GetEngine().Eval("m_faces=m_faces+1");
 	std::cout << "Done!\n";
+	return true;
 }
 
 void HarmonicFlattening(Mesh &source_mesh, GMMSparseRowMatrix &u, GMMSparseRowMatrix &weightsMat, bool harmonic)
+{
+	IndexMesh mesh;
+	mesh.assign(source_mesh);
+	HarmonicFlattening(mesh, u, weightsMat, harmonic);
+}
+
+void HarmonicFlattening(const IndexMesh &mesh, GMMSparseRowMatrix &u, GMMSparseRowMatrix &weightsMat, bool harmonic)
 {
 			//Harmonic flattening
 
 
 		//***** Extracting Boundray Lengths & Boundray Vertices
 		// Input:
-		// std::vector<Mesh::Halfedge_iterator> borderHDS
+		// std::vector<int> borderHDS
 		//
 		// Output:
 		// std::vector<int> verticesIndices
@@ -236,18 +300,17 @@ void HarmonicFlattening(Mesh &source_mesh, GMMSparseRowMatrix &u, GMMSparseRowMa
 		static std::vector<double> sourceBoundary;
 		static Point_3 firstBoundaryVertex(RESET_NUM, RESET_NUM, RESET_NUM), secondBoundaryVertex(RESET_NUM, RESET_NUM, RESET_NUM);
 
-		std::vector<Mesh::Halfedge_iterator> borderHDS;
+		std::vector<int> borderHDS;
 		std::vector<int> verticesIndices;
 		std::vector<double> partialLengths;
 		double totalLength = 0, currLength = 0;
-		Mesh::Vertex_const_handle currentV;
-		Mesh::Halfedge_const_handle currH;
+		int currentV, currH;
 
-		source_mesh.getBorderHalfEdges(borderHDS);
+		mesh.getBorderHalfedges(borderHDS);
 		if (isFirst)
 		{
-			firstBoundaryVertex = borderHDS[0]->vertex()->uv();
-			secondBoundaryVertex = borderHDS[1]->vertex()->uv();
+			firstBoundaryVertex = mesh.uv(mesh.vertex(borderHDS[0]));
+			secondBoundaryVertex = mesh.uv(mesh.vertex(borderHDS[1]));
 		}
 
 		//GMMDenseColMatrix dMat(borderHDS.size(),2);
@@ -259,30 +322,29 @@ void HarmonicFlattening(Mesh &source_mesh, GMMSparseRowMatrix &u, GMMSparseRowMa
 			//dMat(i, 1) = borderHDS[i]->vertex()->point().y();
 
 			currH = borderHDS[i];
-			currentV = currH->vertex();
-			currLength = currH->length();
+			currentV = mesh.vertex(currH);
+			currLength = mesh.length(currH);
 			totalLength += currLength;
-			verticesIndices.push_back(currentV->index());
+			verticesIndices.push_back(currentV);
 			partialLengths.push_back(totalLength);
 		}
 
 		//MatlabGMMDataExchange::SetEngineDenseMatrix("dMat", dMat);
 
 	
-		int sourceMeshSize = source_mesh.size_of_vertices();
 		int count = 0;
 		int targetIndex = 0;
 		if (!isFirst)
 		{
 			targetIndex = -1;
 			for (int i = 0; i < (int)borderHDS.size(); ++i)
-				if (borderHDS[i]->vertex()->point() == firstBoundaryVertex)
+				if (mesh.point(mesh.vertex(borderHDS[i])) == firstBoundaryVertex)
 				{
 					targetIndex = i;
 					break;
 				}
 			assert(targetIndex != -1);
-			if (borderHDS[(targetIndex + 2) % borderHDS.size()]->vertex()->point() != secondBoundaryVertex)
+			if (mesh.point(mesh.vertex(borderHDS[(targetIndex + 2) % borderHDS.size()])) != secondBoundaryVertex)
 				assert(0);
 		}
 		//targetIndex = 0;
@@ -337,19 +399,14 @@ void HarmonicFlattening(Mesh &source_mesh, GMMSparseRowMatrix &u, GMMSparseRowMa
 
 		//************* Compute Weights **************
 		// Input:
-		// Mesh::Vertex_const_iterator currV; --begining of the vertices
-		// Mesh::Vertex_const_iterator endV;  --ending of the vertices
+		// const IndexMesh& mesh
 		//
 		// Output:
 		// WeightsMat
 		if (harmonic)
 		{
 			int numOfNegativeWeights = 0;
-			Mesh::Vertex_const_iterator currV, endV;
-			currV = source_mesh.vertices_begin();
-			endV = source_mesh.vertices_end();
-
-			Mesh::Halfedge_around_vertex_const_circulator hdgAroundV;
+			int hdgAroundV;
 
 			int vi, vj;
 			double sumCot = 0, cot1, cot2;
@@ -365,25 +422,23 @@ void HarmonicFlattening(Mesh &source_mesh, GMMSparseRowMatrix &u, GMMSparseRowMa
 			//	weightsMat[i].resize( mesh.size_of_vertices() );
 			// ********************************************************
 
-			for (; currV != endV; ++currV) // traverse through all mesh vertices
+			for (vi = 0; vi < mesh.numVertices(); ++vi) // traverse through all mesh vertices
 			{
-				vi = currV->index();
-				pi = currV->point();
-				if (currV->is_border())
+				pi = mesh.point(vi);
+				if (mesh.isBorderVertex(vi))
 				{
 					weightsMat(vi, vi) = 1;
 					continue;
 				}
 
-				hdgAroundV = currV->vertex_begin();
+				hdgAroundV = mesh.vertexHalfedge(vi);
 
 				do // traverse through connected edges
 				{
-					auto oppositeV = hdgAroundV->opposite()->vertex();
-					vj = oppositeV->index(); // opposite vertex index for curr edge
-					pj = oppositeV->point();
-					p1 = hdgAroundV->next()->vertex()->point(); // 3rd point from first triangle
-					p2 = hdgAroundV->opposite()->next()->vertex()->point(); // 3rd point from second triangle
+					vj = mesh.source(hdgAroundV); // opposite vertex index for curr edge
+					pj = mesh.point(vj);
+					p1 = mesh.point(mesh.vertex(mesh.next(hdgAroundV))); // 3rd point from first triangle
+					p2 = mesh.point(mesh.vertex(mesh.next(mesh.twin(hdgAroundV)))); // 3rd point from second triangle
 
 					/*vv1 = p1 - pi;
 					vv2 = p1 - pj;
@@ -405,8 +460,8 @@ void HarmonicFlattening(Mesh &source_mesh, GMMSparseRowMatrix &u, GMMSparseRowMa
 
 					if (weightsMat(vi, vj) < 0)
 						numOfNegativeWeights++;
-					hdgAroundV++;
-				} while (hdgAroundV != currV->vertex_begin());
+					hdgAroundV = mesh.nextAroundVertex(hdgAroundV);
+				} while (hdgAroundV != mesh.vertexHalfedge(vi));
 
 				weightsMat(vi, vi) = -1 * sumCot;
 				sumCot = 0;
@@ -419,28 +474,23 @@ void HarmonicFlattening(Mesh &source_mesh, GMMSparseRowMatrix &u, GMMSparseRowMa
 		else	//mean value
 		{
 
-			Mesh::Vertex_const_iterator currV, endV;
-			currV = source_mesh.vertices_begin();
-			endV = source_mesh.vertices_end();
-
-			Mesh::Halfedge_around_vertex_const_circulator hdgAroundV;
+			int hdgAroundV;
 
 			int vi, vj;
 			double sumCot = 0;// , t1, t2;
 			Mesh::Point_3 p1, p2, pi, pj;
 			CGAL::Vector_3<Kernel> vv1, vv2, vv3, vv4;
 
-			for (; currV != endV; ++currV) // traverse through all mesh vertices
+			for (vi = 0; vi < mesh.numVertices(); ++vi) // traverse through all mesh vertices
 			{
-				vi = currV->index();
-				pi = currV->point();
-				if (currV->is_border())
+				pi = mesh.point(vi);
+				if (mesh.isBorderVertex(vi))
 				{
 					weightsMat(vi, vi) = 1;
 					continue;
 				}
 
-				hdgAroundV = currV->vertex_begin();
+				hdgAroundV = mesh.vertexHalfedge(vi);
 
 				do // traverse through connected edges
 				{
@@ -475,12 +525,11 @@ void HarmonicFlattening(Mesh &source_mesh, GMMSparseRowMatrix &u, GMMSparseRowMa
 						*/
 
 
-					auto oppositeV = hdgAroundV->opposite()->vertex();
-					vj = oppositeV->index(); // opposite vertex index for curr edge
+					vj = mesh.source(hdgAroundV); // opposite vertex index for curr edge
 					Point_3 p0 = pi;
-					Point_3 p1 = oppositeV->point();
-					Point_3 p2 = hdgAroundV->next()->vertex()->point(); // 3rd point from first triangle
-					Point_3 p3 = hdgAroundV->opposite()->next()->vertex()->point(); // 3rd point from second triangle
+					Point_3 p1 = mesh.point(vj);
+					Point_3 p2 = mesh.point(mesh.vertex(mesh.next(hdgAroundV))); // 3rd point from first triangle
+					Point_3 p3 = mesh.point(mesh.vertex(mesh.next(mesh.twin(hdgAroundV)))); // 3rd point from second triangle
 
 					Vector_3 u = p1 - p0;
 					Vector_3 v = p2 - p0;
@@ -506,8 +555,8 @@ void HarmonicFlattening(Mesh &source_mesh, GMMSparseRowMatrix &u, GMMSparseRowMa
 					weightsMat(vi, vj) = weight;
 					sumCot += weightsMat(vi, vj);
 
-					hdgAroundV++;
-				} while (hdgAroundV != currV->vertex_begin());
+					hdgAroundV = mesh.nextAroundVertex(hdgAroundV);
+				} while (hdgAroundV != mesh.vertexHalfedge(vi));
 
 				weightsMat(vi, vi) = -1 * sumCot;
 				sumCot = 0;
@@ -516,6 +565,94 @@ void HarmonicFlattening(Mesh &source_mesh, GMMSparseRowMatrix &u, GMMSparseRowMa
 		isFirst = false;
 }
 
+void convertToCSR(GMMSparseRowMatrix &A, SparseMatrixCSR &csr)
+{
+	csr.clear();
+	csr.nRows = (int)gmm::mat_nrows(A);
+	csr.nCols = (int)gmm::mat_ncols(A);
+
+	for (int i = 0; i < csr.nRows; ++i)
+	{
+		//wsvector is ordered by index, so the columns come out sorted
+		for (gmm::wsvector<double>::iterator iter = A[i].begin(); iter != A[i].end(); ++iter)
+		{
+			csr.colInd.push_back((int)iter->first);
+			csr.values.push_back(iter->second);
+		}
+		csr.rowPtr.push_back((int)csr.colInd.size());
+	}
+}
+
+//number of triangles whose orientation in the disk map differs from the orientation of the majority. triangles with
+//zero area have no orientation, they are counted in numDegenerate and not as flipped.
+int countFlippedDiskTriangles(const GMMDenseColMatrix &map, const std::vector<int> &fVec, int &numDegenerate)
+{
+	int numPositive = 0, numNegative = 0;
+	numDegenerate = 0;
+	for (int i = 0; i + 2 < (int)fVec.size(); i += 3)
+	{
+		int a = fVec[i], b = fVec[i + 1], c = fVec[i + 2];
+		double cross = (map(b, 0) - map(a, 0)) * (map(c, 1) - map(a, 1)) - (map(b, 1) - map(a, 1)) * (map(c, 0) - map(a, 0));
+		if (cross > 0)
+			numPositive++;
+		else if (cross < 0)
+			numNegative++;
+		else
+			numDegenerate++;
+	}
+	return numPositive < numNegative ? numPositive : numNegative;
+}
+
+//solves weightsMat * map = u in process. The disk map has to be an embedding (BuildArrangement inserts its edges
+//as non intersecting curves), so the tolerance is tightened as long as the solution has flipped triangles.
+//The solver comes from the cache of the caller, so remapping a mesh with the same connectivity only redoes the
+//numeric setup.
+bool solveHarmonicMap(GMMSparseRowMatrix &weightsMat, GMMSparseRowMatrix &u, const std::vector<int> &fVec, GMMDenseColMatrix &map, const HarmonicSolverOptions &options, HarmonicSolverCache &solverCache)
+{
+	SparseMatrixCSR A;
+	convertToCSR(weightsMat, A);
+	int n = A.nRows;
+
+	std::vector<double> b(2 * n, 0.0), x(2 * n, 0.0);
+	for (int i = 0; i < n; ++i)
+	{
+		for (gmm::wsvector<double>::iterator iter = u[i].begin(); iter != u[i].end(); ++iter)
+			b[2 * i + iter->first] = iter->second;
+	}
+
+	HarmonicSolver &solver = solverCache.solver(A, options);
+	if (!solver.compute(A))
+		return false;
+
+	bool converged = false;
+	int numFlipped = 0, numDegenerate = 0;
+	while (true)
+	{
+		converged = solver.solve(b, x);
+
+		gmm::resize(map, n, 2);
+		for (int i = 0; i < n; ++i)
+		{
+			map(i, 0) = x[2 * i];
+			map(i, 1) = x[2 * i + 1];
+		}
+
+		//only flipped triangles tighten the tolerance, a triangle which is degenerate in the mesh stays degenerate
+		numFlipped = countFlippedDiskTriangles(map, fVec, numDegenerate);
+		if (numFlipped == 0 || solver.options().tolerance <= 1e-15)
+			break;
+		solver.options().tolerance = solver.options().tolerance * 1e-2 > 1e-15 ? solver.options().tolerance * 1e-2 : 1e-15;	//continue from the current solution
+	}
+
+	if (!converged)
+		std::cout << "Warning: the harmonic solver did not reach the requested tolerance (" << solver.report().residual[0] << "," << solver.report().residual[1] << ")\n";
+	if (numFlipped != 0)
+		std::cout << "Warning: " << numFlipped << " triangles are flipped in the disk map\n";
+	if (numDegenerate != 0)
+		std::cout << "Warning: " << numDegenerate << " triangles have zero area in the disk map\n";
+	return converged;
+}
+
 void addPointsToTarget( Polygon_2 &poly , int numOfBorder , double avg_arc )
 {
 	int n = (int)poly.size();
@@ -611,16 +748,136 @@ void addPointsToTarget( Polygon_2 &poly , int numOfBorder , double avg_arc )
 	}
 
 
-	void BuildArrangement(Arrangement_2& arr, Landmarks_pl& trap, const std::vector<EPoint_2>& vertices, const std::vector<int>& faces, /*Face_index_observer& obs,*/ Mesh &source_mesh)
+	//inserts the edge a->b of the disk map and returns the arrangement halfedge directed from a to b
+	static Arrangement_2::Halfedge_handle insertMapEdge(Arrangement_2& arr, const std::vector<Point_2>& vertices, std::vector<Arrangement_2::Vertex_handle>& arrVertices, std::vector<bool>& isInserted, int a, int b)
 	{
-		static bool firstTime = true;
-		if (firstTime)
+		EPoint_2 pa(vertices[a].x(), vertices[a].y()), pb(vertices[b].x(), vertices[b].y());
+		ESegment_2 segment(pa, pb);
+		Arrangement_2::Halfedge_handle he;
+
+		if (isInserted[a] && isInserted[b])
+			he = arr.insert_at_vertices(segment, arrVertices[a], arrVertices[b]);
+		else if (isInserted[a] || isInserted[b])
 		{
-			firstTime = false;
-			std::cout << "Building arrangement from source unit disk map...\n";
+			int oldV = isInserted[a] ? a : b;
+			int newV = isInserted[a] ? b : a;
+			if (CGAL::compare_xy(vertices[oldV], vertices[newV]) == CGAL::SMALLER)
+				he = arr.insert_from_left_vertex(segment, arrVertices[oldV]);
+			else
+				he = arr.insert_from_right_vertex(segment, arrVertices[oldV]);
+			arrVertices[newV] = he->target();
+			isInserted[newV] = true;
 		}
 		else
-			std::cout << "Building arrangement from target unit disk map...\n";
+		{
+			//first edge of a connected component of the map
+			he = arr.insert_in_face_interior(segment, arr.unbounded_face());
+			arrVertices[a] = (he->source()->point() == pa) ? he->source() : he->target();
+			arrVertices[b] = (he->source()->point() == pa) ? he->target() : he->source();
+			isInserted[a] = isInserted[b] = true;
+		}
+
+		if (he->source() != arrVertices[a])
+			he = he->twin();
+		assert(he->source() == arrVertices[a] && he->target() == arrVertices[b]);
+		return he;
+	}
+
+	//builds the arrangement of a disk map which is known to be an embedding. the faces are added in BFS order, so
+	//every edge is inserted at vertices which are already in the arrangement and no sweep or point location is needed.
+	//the vertex, halfedge and face data are set from the mesh connectivity as the edges are inserted.
+	void buildArrangementFromMesh(Arrangement_2& arr, const std::vector<Point_2>& vertices, Mesh& mesh)
+	{
+		arr.clear();
+
+		int numVertices = (int)mesh.size_of_vertices();
+		int numHalfedges = (int)mesh.size_of_halfedges();
+		std::vector<Arrangement_2::Vertex_handle> arrVertices(numVertices);
+		std::vector<bool> isInserted(numVertices, false);
+		std::vector<Arrangement_2::Halfedge_handle> arrHalfedges(numHalfedges);
+		std::vector<bool> isEdgeInserted(numHalfedges, false);
+
+		std::vector<Mesh::Facet_handle> facets;
+		facets.reserve(mesh.size_of_facets());
+		int index = 0;
+		for (Mesh::Facet_iterator fIt = mesh.facets_begin(); fIt != mesh.facets_end(); ++fIt, ++index)
+		{
+			fIt->index() = index;	//same order as fVec
+			facets.push_back(fIt);
+		}
+
+		std::vector<bool> isVisited(facets.size(), false);
+		std::queue<Mesh::Facet_handle> queue;
+		for (int seed = 0; seed < (int)facets.size(); ++seed)
+		{
+			if (isVisited[seed])
+				continue;
+			isVisited[seed] = true;
+			queue.push(facets[seed]);
+
+			while (!queue.empty())
+			{
+				Mesh::Facet_handle face = queue.front();
+				queue.pop();
+
+				Mesh::Halfedge_around_facet_circulator h = face->facet_begin();
+				const Mesh::Halfedge_around_facet_circulator hEnd = h;
+				do
+				{
+					if (!isEdgeInserted[h->index()])
+					{
+						int a = h->opposite()->vertex()->index();
+						int b = h->vertex()->index();
+						Arrangement_2::Halfedge_handle he = insertMapEdge(arr, vertices, arrVertices, isInserted, a, b);
+						arrHalfedges[h->index()] = he;
+						arrHalfedges[h->opposite()->index()] = he->twin();
+						isEdgeInserted[h->index()] = isEdgeInserted[h->opposite()->index()] = true;
+						he->set_data(h);
+						he->twin()->set_data(h->opposite());
+					}
+
+					if (!h->opposite()->is_border())
+					{
+						int neighbor = h->opposite()->facet()->index();
+						if (!isVisited[neighbor])
+						{
+							isVisited[neighbor] = true;
+							queue.push(h->opposite()->facet());
+						}
+					}
+					h++;
+				} while (h != hEnd);
+			}
+		}
+
+		for (Mesh::Vertex_iterator vIt = mesh.vertices_begin(); vIt != mesh.vertices_end(); ++vIt)
+		{
+			int i = vIt->index();
+			vIt->userIndex() = i;
+			if (isInserted[i])
+				arrVertices[i]->set_data(vIt);
+		}
+
+		//the triangle lies to the left of its arrangement halfedges if it is counter clockwise in the map
+		for (int i = 0; i < (int)facets.size(); ++i)
+		{
+			Mesh::Halfedge_handle h = facets[i]->halfedge();
+			int a = h->opposite()->vertex()->index();
+			int b = h->vertex()->index();
+			int c = h->next()->vertex()->index();
+			Arrangement_2::Halfedge_handle he = arrHalfedges[h->index()];
+			if (IKernel::Orientation_2()(IKernel::Point_2(vertices[a].x(), vertices[a].y()), IKernel::Point_2(vertices[b].x(), vertices[b].y()), IKernel::Point_2(vertices[c].x(), vertices[c].y())) != CGAL::LEFT_TURN)
+				he = he->twin();
+			assert(!he->face()->is_unbounded());
+			he->face()->set_data(facets[i]);
+		}
+
+		assert(arr.number_of_faces() == mesh.size_of_facets() + 1);
+	}
+
+	void BuildArrangement(Arrangement_2& arr, const std::vector<Point_2>& vertices, const std::vector<int>& faces, /*Face_index_observer& obs,*/ Mesh &source_mesh)
+	{
+		std::cout << "Building arrangement from target unit disk map...\n";
 /*
 		std::vector<ESegment_2>    segments;
 		//std::vector<EPoint_2> Evertices;
@@ -665,6 +922,13 @@ void addPointsToTarget( Polygon_2 &poly , int numOfBorder , double avg_arc )
 
 
 
+		if (!RunOptions::Get().sweepArrangement)
+		{
+			buildArrangementFromMesh(arr, vertices, source_mesh);
+			std::cout << "Done!\n";
+			return;
+		}
+
 		Mesh::Halfedge_iterator he = source_mesh.halfedges_begin();
 		const Mesh::Halfedge_iterator heEnd = source_mesh.halfedges_end();
 
@@ -692,7 +956,7 @@ void addPointsToTarget( Polygon_2 &poly , int numOfBorder , double avg_arc )
 
 		CGAL::insert_non_intersecting_curves(arr, segmentsList.begin(), segmentsList.end());
 
-		trap.attach(arr);
+		Landmarks_pl trap(arr);	//for the matching only
 		matchPointsIndices(arr, vertices, trap, source_mesh);
 		matchEdges(arr, source_mesh);
 		matchFaces(arr , vertices, faces, trap, source_mesh);
@@ -750,6 +1014,15 @@ void addPointsToTarget( Polygon_2 &poly , int numOfBorder , double avg_arc )
 		return -1;
 	}
 
+	//-1 (type OUTSIDE, targetFace -1) if the point is outside the disk, the caller decides what to do then
+	int findTarget(const PointLocator& target, const EPoint_2& point, int& type, int& targetFace)
+	{
+		DiskLocator::Location location = target.locate(point);
+		type = location.type;
+		targetFace = location.face;
+		return (location.face == -1) ? -1 : 1;
+	}
+
 	ARRNumberType crossProduct ( EVector_2 v1 , EVector_2 v2 )
 	{
 		ARRNumberType temp = v1.x() * v2.y() - v1.y() * v2.x() ;
@@ -783,6 +1056,112 @@ void addPointsToTarget( Polygon_2 &poly , int numOfBorder , double avg_arc )
 
 	}
 
+	//midpoint of the interval of an exact coordinate, error is the distance of the exact value from it
+	static double approximateCoordinate(const ARRNumberType& n, double& error)
+	{
+		std::pair<double, double> interval = CGAL::to_interval(n);
+		double mid = 0.5 * interval.first + 0.5 * interval.second;
+		error = (std::max)(interval.second - mid, mid - interval.first) + std::numeric_limits<double>::epsilon() * std::fabs(mid);
+		return mid;
+	}
+
+	//barycentricCord in doubles. every area gets a forward error bound (the rounding of the exact coordinates and of the
+	//double arithmetic). only when an area is within its bound of zero, i.e. the point is on or near the line of an edge and
+	//the sign of the area is not certain, the coordinates are computed exactly.
+	void barycentricCordFiltered(const std::vector<EPoint_2>& points, const EPoint_2& point, double res[3])
+	{
+		double x[4], y[4], error = 0.0;
+		for (int i = 0; i < 4; ++i)
+		{
+			const EPoint_2& p = (i < 3) ? points[i] : point;
+			double ex, ey;
+			x[i] = approximateCoordinate(p.x(), ex);
+			y[i] = approximateCoordinate(p.y(), ey);
+			error = (std::max)(error, (std::max)(ex, ey));
+		}
+
+		//area i is the area of the point and the edge opposite to vertex i
+		const double eps = std::numeric_limits<double>::epsilon();
+		double s[3], sum = 0.0;
+		bool certain = true;
+		for (int i = 0; i < 3 && certain; ++i)
+		{
+			int a = (i + 1) % 3, b = (i + 2) % 3;
+			double ax = x[a] - x[3], ay = y[a] - y[3];
+			double bx = x[b] - x[3], by = y[b] - y[3];
+			double t1 = ax * by, t2 = ay * bx;
+			double bound = 8.0 * eps * (std::fabs(t1) + std::fabs(t2)) + 2.0 * error * (std::fabs(ax) + std::fabs(ay) + std::fabs(bx) + std::fabs(by)) + 8.0 * error * error;
+			s[i] = std::fabs(t1 - t2);
+			certain = (s[i] > bound);
+			sum += s[i];
+		}
+
+		if (certain)
+		{
+			for (int i = 0; i < 3; ++i)
+				res[i] = s[i] / sum;
+			return;
+		}
+
+		ARRTraits_2::Point_3 exact;
+		barycentricCord(points, point, exact);
+		for (int i = 0; i < 3; ++i)
+			res[i] = CGAL::to_double(exact[i]);
+	}
+
+	//the point with barycentric coordinates bar in the planar (uv) target mesh face with the vertices indices
+	Point_3 barycentricCombination(Mesh& targetMesh, const std::vector<int>& indices, const double bar[3])
+	{
+		double u = 0.0, v = 0.0;
+		for (int j = 0; j < 3; ++j)
+		{
+			const Point_3& p = targetMesh.vertex(indices[j])->point();
+			u += bar[j] * p.x();
+			v += bar[j] * p.y();
+		}
+		return (Point_3(u, v, 0));
+	}
+
+	static CGAL::MP_Float absCross(double ax, double ay, double bx, double by, double cx, double cy)
+	{
+		CGAL::MP_Float cross = (CGAL::MP_Float(bx) - CGAL::MP_Float(ax)) * (CGAL::MP_Float(cy) - CGAL::MP_Float(ay)) - (CGAL::MP_Float(by) - CGAL::MP_Float(ay)) * (CGAL::MP_Float(cx) - CGAL::MP_Float(ax));
+		return (cross < 0) ? -cross : cross;
+	}
+
+	//absCross in doubles, with the bound of barycentricCordFiltered for exact input coordinates. false when the area is
+	//within the bound, i.e. the double area can not be trusted.
+	static bool absCrossFiltered(double ax, double ay, double bx, double by, double cx, double cy, double& area)
+	{
+		double t1 = (bx - ax) * (cy - ay), t2 = (by - ay) * (cx - ax);
+		area = std::fabs(t1 - t2);
+		return (area > 8.0 * std::numeric_limits<double>::epsilon() * (std::fabs(t1) + std::fabs(t2)));
+	}
+
+	//barycentricCord and reverseBarycentric for a point and a triangle given by doubles (x0, y0, x1, y1, x2, y2).
+	//the areas are computed in doubles and only when one of them is within its error bound of zero (the point is on or
+	//near the line of an edge) the computation is exact up to the final rounding. neither path uses lazy exact objects,
+	//so it is thread safe.
+	Point_2 mapThroughTriangle(double x, double y, const double triangle[6], const double image[6])
+	{
+		double a1, a2, a3;
+		if (absCrossFiltered(x, y, triangle[4], triangle[5], triangle[2], triangle[3], a1) &&
+			absCrossFiltered(x, y, triangle[4], triangle[5], triangle[0], triangle[1], a2) &&
+			absCrossFiltered(x, y, triangle[0], triangle[1], triangle[2], triangle[3], a3))
+		{
+			double a = a1 + a2 + a3;
+			return (Point_2((a1 * image[0] + a2 * image[2] + a3 * image[4]) / a, (a1 * image[1] + a2 * image[3] + a3 * image[5]) / a));
+		}
+
+		CGAL::MP_Float s1 = absCross(x, y, triangle[4], triangle[5], triangle[2], triangle[3]);
+		CGAL::MP_Float s2 = absCross(x, y, triangle[4], triangle[5], triangle[0], triangle[1]);
+		CGAL::MP_Float s3 = absCross(x, y, triangle[0], triangle[1], triangle[2], triangle[3]);
+		CGAL::MP_Float s = s1 + s2 + s3;
+
+		MPNumberType u(s1 * CGAL::MP_Float(image[0]) + s2 * CGAL::MP_Float(image[2]) + s3 * CGAL::MP_Float(image[4]), s);
+		MPNumberType v(s1 * CGAL::MP_Float(image[1]) + s2 * CGAL::MP_Float(image[3]) + s3 * CGAL::MP_Float(image[5]), s);
+		return (Point_2(CGAL::to_double(u), CGAL::to_double(v)));
+	}
+
 	EPoint_2 reverseBarycentric ( const std::vector<EPoint_2>& points, ARRTraits_2::Point_3 bar )
 	{
 		EPoint_2 p1 = points[0], p2 = points[1], p3 = points[2]; 
@@ -813,7 +1192,7 @@ void addPointsToTarget( Polygon_2 &poly , int numOfBorder , double avg_arc )
 		/////////////*/
 	}
 
-	std::vector<int> updateUVs(Mesh& sourceMesh, Mesh& targetMesh, const Arrangement_2& source, const Arrangement_2& target, const Landmarks_pl& sourceLandMark, const Landmarks_pl& targetLandMark, /*Face_index_observer& sourceObs, Face_index_observer& targetObs,*/ std::vector<EPoint_2>& sourceHarmonicMapPoints, std::vector<int>& fVec, std::vector<Point_3>& uvVector)
+	std::vector<int> updateUVs(Mesh& sourceMesh, Mesh& targetMesh, const PointLocator& targetLocator, std::vector<Point_2>& sourceHarmonicMapPoints, std::vector<int>& fVec, std::vector<Point_3>& uvVector)
 	{
 		/*GMMDenseColMatrix newFvec(source.number_of_faces()-1,3);
 		int count=0;
@@ -890,360 +1269,479 @@ void addPointsToTarget( Polygon_2 &poly , int numOfBorder , double avg_arc )
 		}
 		MatlabGMMDataExchange::SetEngineDenseMatrix( "newFvec" , newFvec );
 		return negativeOrientationTriangles;*/
-		int numOfTri = (int)fVec.size() / 3 , index,type;
-		EPoint_2 potentialUV[3];
+		int numOfTri = (int)fVec.size() / 3;
 		std::vector<int> indicesOrder ;
 		std::vector<EPoint_2> points;
-		std::vector<EPoint_2> targetMeshPoints;
-		ARRTraits_2::Point_3 barPoint;
-		Arrangement_2::Face_const_handle targetFace;
 		std::vector<int> negativeOrientationTriangles;
 
-		for (int i = 0; i < numOfTri; ++i)
+		//the vertices which are not mapped yet (the boundary is set by setBoundaryUV), located together
+		std::vector<int> queryVertices;
+		std::vector<double> queryX, queryY;
+		std::vector<bool> isQueried(uvVector.size(), false);
+		for (int i = 0; i < 3 * numOfTri; ++i)
 		{
-			for (int j = 0; j < 3; ++j)
+			int v = fVec[i];
+			if (uvVector[v].z() == RESET_NUM && !isQueried[v])
 			{
-				if (uvVector[fVec[3*i + j]].z() != RESET_NUM)
-				{
-					potentialUV[j] = EPoint_2(uvVector[fVec[3*i + j]].x(), uvVector[fVec[3*i + j]].y());	
-				}
-				else
+				isQueried[v] = true;
+				queryVertices.push_back(v);
+				queryX.push_back(sourceHarmonicMapPoints[v].x());
+				queryY.push_back(sourceHarmonicMapPoints[v].y());
+			}
+		}
+		int numQueries = (int)queryVertices.size();
+		int numUnmapped = 0; //outside the disk and not snapped, their uv stays unset
+
+		if (targetLocator.isThreadSafe())
+		{
+			//the source disk points are doubles, so every vertex is mapped with double queries and MP_Float arithmetic,
+			//and no lazy exact object is shared between the threads. every thread walks along its own part of the
+			//Hilbert order, starting from its previous answer.
+			std::vector<int> order;
+			hilbertSort(queryX, queryY, order);
+
+			int numTargetVertices = (int)targetMesh.size_of_vertices();
+			std::vector<double> targetPoints(2 * numTargetVertices);
+			for (int i = 0; i < numTargetVertices; ++i)
+			{
+				targetPoints[2 * i] = targetMesh.vertex(i)->point().x();
+				targetPoints[2 * i + 1] = targetMesh.vertex(i)->point().y();
+			}
+			const DiskLocator& disk = targetLocator.disk();
+
+#pragma omp parallel
+			{
+				int hintFace = -1;
+				double triangle[6], image[6];
+#pragma omp for schedule(static) reduction(+:numUnmapped)
+				for (int k = 0; k < numQueries; ++k)
 				{
-					EPoint_2 tempP = sourceHarmonicMapPoints[fVec[3 * i + j]];
-					indicesOrder.clear();
-					points.clear();
-					targetMeshPoints.clear();
+					int q = order[k];
+					double x = queryX[q], y = queryY[q];
+					DiskLocator::Location location = targetLocator.locateDouble(x, y, hintFace);
+					if (location.face == -1)
+					{
+						//outside the disk by rounding, snapped to the nearest point of the boundary
+						Point_2 nearest;
+						location.face = disk.nearestBoundaryPoint(x, y, nearest);
+						if (location.face == -1)
+						{
+							numUnmapped++;
+							continue;
+						}
+						x = nearest.x();
+						y = nearest.y();
+					}
+					hintFace = location.face;
 
-					index = findTarget(targetLandMark, tempP, type, targetFace); // face index
-					//targetFace = targetMesh.face(index);//targetObs.getFace(index);
-					getPointsFromFace(targetFace, points, indicesOrder);
-	
-					barycentricCord(points, tempP, barPoint);
-					getPointsFromFace_Mesh(targetMesh, targetMeshPoints, indicesOrder);
-					potentialUV[j] = (reverseBarycentric(targetMeshPoints, barPoint));
-					uvVector[fVec[3*i + j]] = Mesh::Point_3(CGAL::to_double<ARRNumberType>(potentialUV[j].x()), CGAL::to_double<ARRNumberType>(potentialUV[j].y()), 0);
+					for (int j = 0; j < 3; ++j)
+					{
+						int v = disk.vertexOfFace(location.face, j);
+						triangle[2 * j] = disk.x(v);
+						triangle[2 * j + 1] = disk.y(v);
+						image[2 * j] = targetPoints[2 * v];
+						image[2 * j + 1] = targetPoints[2 * v + 1];
+					}
+					Point_2 uv = mapThroughTriangle(x, y, triangle, image);
+					uvVector[queryVertices[q]] = Mesh::Point_3(uv.x(), uv.y(), 0);
 				}
 			}
+		}
+		else
+		{
+			std::vector<EPoint_2> queryPoints(numQueries);
+			for (int k = 0; k < numQueries; ++k)
+				queryPoints[k] = EPoint_2(queryX[k], queryY[k]);
 
-			ARRKernel::Triangle_2 tri(potentialUV[0], potentialUV[1], potentialUV[2]);
-			if (tri.orientation() != 1)
-				negativeOrientationTriangles.push_back(i);
+			std::vector<DiskLocator::Location> locations;
+			targetLocator.locateBatch(queryPoints, locations);
 
-			
+			double bar[3];
+			for (int k = 0; k < numQueries; ++k)
+			{
+				if (locations[k].face == -1)
+				{
+					//outside the disk by rounding, snapped to the nearest point of the boundary
+					Point_2 nearest;
+					locations[k].face = targetLocator.disk().nearestBoundaryPoint(queryX[k], queryY[k], nearest);
+					queryPoints[k] = EPoint_2(nearest.x(), nearest.y());
+				}
+				if (!targetLocator.disk().getFace(locations[k].face, points, indicesOrder))
+				{
+					numUnmapped++;
+					continue;
+				}
+
+				barycentricCordFiltered(points, queryPoints[k], bar);
+				uvVector[queryVertices[k]] = barycentricCombination(targetMesh, indicesOrder, bar);
+			}
 		}
+		if (numUnmapped != 0)
+			std::cerr << "updateUVs: " << numUnmapped << " vertices are outside the target disk, which has no boundary to snap them to. Their uv is not set.\n";
+
+		//orientation of the mapped faces, flagged in parallel and collected in face order
+		std::vector<char> isNegative(numOfTri, 0);
+#pragma omp parallel for
+		for (int i = 0; i < numOfTri; ++i)
+		{
+			IKernel::Point_2 p0(uvVector[fVec[3 * i]].x(), uvVector[fVec[3 * i]].y());
+			IKernel::Point_2 p1(uvVector[fVec[3 * i + 1]].x(), uvVector[fVec[3 * i + 1]].y());
+			IKernel::Point_2 p2(uvVector[fVec[3 * i + 2]].x(), uvVector[fVec[3 * i + 2]].y());
+			isNegative[i] = (IKernel::Orientation_2()(p0, p1, p2) != CGAL::LEFT_TURN);
+		}
+		for (int i = 0; i < numOfTri; ++i)
+			if (isNegative[i])
+				negativeOrientationTriangles.push_back(i);
 		return (negativeOrientationTriangles);
 	}
 
 	void setBoundaryUV(Mesh &source_mesh, Mesh &target_mesh, std::vector<Point_3>& uvVector)
 	{
-		std::vector<Mesh::Halfedge_iterator> borderSourceHDS, borderTargetHDS;
-		source_mesh.getBorderHalfEdges(borderSourceHDS);
-		target_mesh.getBorderHalfEdges(borderTargetHDS);
+		IndexMesh source, target;
+		source.assign(source_mesh);
+		target.assign(target_mesh);
+		setBoundaryUV(source, target, uvVector);
+		for_each_vertex(v, source_mesh)
+			v->uv() = source.uv(v->index());
+	}
+
+	void setBoundaryUV(IndexMesh &source, const IndexMesh &target, std::vector<Point_3>& uvVector)
+	{
+		std::vector<int> borderSourceHDS, borderTargetHDS;
+		source.getBorderHalfedges(borderSourceHDS);
+		target.getBorderHalfedges(borderTargetHDS);
 
-		auto firstBoundaryVertex = borderSourceHDS[0]->vertex()->uv();
-		auto secondBoundaryVertex = borderSourceHDS[1]->vertex()->uv();
+		Point_3 firstBoundaryVertex = source.uv(source.vertex(borderSourceHDS[0]));
+		Point_3 secondBoundaryVertex = source.uv(source.vertex(borderSourceHDS[1]));
 
 		int targetIndex = -1;
 		for (int i = 0; i < (int)borderTargetHDS.size(); ++i)
 		{
-			if (borderTargetHDS[i]->vertex()->uv() == firstBoundaryVertex)
+			if (target.uv(target.vertex(borderTargetHDS[i])) == firstBoundaryVertex)
 			{
 				targetIndex = i;
 				break;
 			}
 		}
 		assert(targetIndex != -1);
-		if (secondBoundaryVertex != borderTargetHDS[(targetIndex + 2) % borderTargetHDS.size()]->vertex()->uv())
+		if (secondBoundaryVertex != target.uv(target.vertex(borderTargetHDS[(targetIndex + 2) % borderTargetHDS.size()])))
 			assert(0);
 	
-		int jj = 0;
-		for (auto i = source_mesh.vertices_begin(); i != source_mesh.vertices_end(); ++i)	//reset all uv's
+		for (int i = 0; i < source.numVertices(); ++i)	//reset all uv's
 		{
-			i->uv() = Point_3(RESET_NUM, RESET_NUM, RESET_NUM);
-			uvVector[jj] = i->uv();
-			jj++;
+			source.uv(i) = Point_3(RESET_NUM, RESET_NUM, RESET_NUM);
+			uvVector[i] = source.uv(i);
 		}
 
 		int N = borderTargetHDS.size();
 
 		for ( int i = 0 ; i < (int)borderSourceHDS.size() ; ++i )
 		{
-			//std::cout<<"borderS index: "<<borderSourceHDS[i]->vertex()->index()<<"\t"<<"borderT index: "<<borderTargetHDS[i]->vertex()->index()<<"\n";
-			//std::cout << "borderS: (" << borderSourceHDS[i]->vertex()->point().x() << "," << borderSourceHDS[i]->vertex()->point().y() << ")\t" << "borderT: (" << borderTargetHDS[i]->vertex()->point().x() << "," << borderTargetHDS[i]->vertex()->point().y()<< ")\n";
-			source_mesh.vertex(borderSourceHDS[i]->vertex()->index())->uv() = borderTargetHDS[(targetIndex+2*i)%N]->vertex()->point();
-			uvVector[borderSourceHDS[i]->vertex()->index()] = Point_3(borderTargetHDS[(targetIndex+2*i)%N]->vertex()->point().x(), borderTargetHDS[(targetIndex+2*i)%N]->vertex()->point().y(), 1);	// the z=1 is to mark that this is boundary vertex
-	
-			//std::cout << borderSourceHDS[i]->vertex()->index() << ":\t(" << uvVector[borderSourceHDS[i]->vertex()->index()].x() << "," << uvVector[borderSourceHDS[i]->vertex()->index()].y() << ")\n";
+			int sourceVertex = source.vertex(borderSourceHDS[i]);
+			const Kernel::Point_3& targetPoint = target.point(target.vertex(borderTargetHDS[(targetIndex + 2 * i) % N]));
+			source.uv(sourceVertex) = targetPoint;
+			uvVector[sourceVertex] = Point_3(targetPoint.x(), targetPoint.y(), 1);	// the z=1 is to mark that this is boundary vertex
 		}
 	}
 
-	int refine(std::vector<int>& neg, Mesh& sourceMesh, Mesh& targetMesh, Arrangement_2& source, Arrangement_2& target, const Landmarks_pl& sourceLandMark, const Landmarks_pl& targetLandMark, /*Face_index_observer& targetObs,*/ std::vector<EPoint_2>& sourceHarmonicMapPoints, std::vector<Kernel::Point_3> &pVec, std::vector<int>& fVec, std::vector<Point_3>& uvVector)
+	//the refinement of a group of foldovers. the groups start from the components of the flipped faces and their
+	//one-rings, so they are refined independently as long as they do not grow into each other.
+	struct RefineRegion
 	{
-		int size = neg.size();
-
-		if (size == 0)
+		RefineRegion(int firstId) : pMap(firstId), isDone(false) {}
+
+		std::vector<int> seeds;			//the flipped faces, in the order of neg
+		std::vector<int> faces;			//every face which was put in the list, seeds first
+		PointMap pMap;					//local ids from the size of uvVector on
+		std::vector<int> newFaces;		//the triangulations of the refined faces
+		std::vector<int> replacedFaces;	//the faces which the triangulations replace
+		bool isDone;
+	};
+
+	//splits the flipped faces by the connected components of the flipped faces and their one-rings
+	static void groupFoldovers(const std::vector<int>& neg, const FaceAdjacency& sourceAdjacency, int firstId, std::vector<RefineRegion>& regions)
+	{
+		int numFaces = sourceAdjacency.numFaces();
+		std::vector<bool> inSet(numFaces, false);
+		for (int i = 0; i < (int)neg.size(); ++i)
 		{
-			std::cout << "No need to refine.\n";
-			return 0;
+			inSet[neg[i]] = true;
+			for (int j = 0; j < 3; ++j)
+				if (sourceAdjacency.neighbor(neg[i], j) != -1)
+					inSet[sourceAdjacency.neighbor(neg[i], j)] = true;
 		}
-		else
-			std::cout << "# of negative triangles: " << size << "\nrefine...\n";
-
-		// --- find all the neighbors of the triangles in 'neg' ---// we found them inside the loop
-		//findNegativeNeighbors(neg, sourceHarmonicMapPoints, fVec, source, sourceLandMark);
-		int startSize = pVec.size();
-		std::vector<Point_3> tempUV = uvVector;
-		PointMap pMap;
-		int updatedNumOfPoints = uvVector.size();
 
-		std::vector<bool> isRefined(fVec.size() / 3), inTheList(fVec.size() / 3), isTriangulated(fVec.size() / 3);
-
-		// ----init the boolean vectors-------------
-		for (int i = 0; i < isRefined.size(); ++i)
+		std::vector<int> component(numFaces, -1), stack;
+		for (int i = 0; i < (int)neg.size(); ++i)
 		{
-			isRefined[i] = false;
-			inTheList[i] = false;
-			isTriangulated[i] = false;
+			if (component[neg[i]] == -1)
+			{
+				component[neg[i]] = (int)regions.size();
+				stack.push_back(neg[i]);
+				while (!stack.empty())
+				{
+					int face = stack.back();
+					stack.pop_back();
+					for (int j = 0; j < 3; ++j)
+					{
+						int neighbor = sourceAdjacency.neighbor(face, j);
+						if (neighbor != -1 && inSet[neighbor] && component[neighbor] == -1)
+						{
+							component[neighbor] = (int)regions.size();
+							stack.push_back(neighbor);
+						}
+					}
+				}
+				regions.push_back(RefineRegion(firstId));
+			}
+			regions[component[neg[i]]].seeds.push_back(neg[i]);
 		}
+	}
 
+	//refines the seeds and the neighbors which are not simple after their edges were refined, simplifies the new
+	//points and triangulates the faces. fVec and uvVector are only read. inTheList and isRefined are false on return.
+	static void refineRegion(RefineRegion& region, Mesh& targetMesh, const FaceAdjacency& sourceAdjacency, const PointLocator& targetLocator, std::vector<Point_2>& sourceHarmonicMapPoints, std::vector<Kernel::Point_3> &pVec, std::vector<int>& fVec, std::vector<Point_3>& uvVector, std::vector<bool>& inTheList, std::vector<bool>& isRefined)
+	{
+		std::vector<int>& list = region.faces;
+		PointMap& pMap = region.pMap;
+		int size = (int)region.seeds.size();
+		list = region.seeds;
 		for (int i = 0; i < size; ++i)
-			inTheList[neg[i]] = true;
-		//-----------------------------------------
+			inTheList[list[i]] = true;
 
-		for (int i = 0; i < neg.size(); ++i)
+		for (int i = 0; i < (int)list.size(); ++i)
 		{
 			if (i < size)
 			{
-				findTriangleNeighbors(neg[i], fVec, sourceHarmonicMapPoints, sourceLandMark, neg, inTheList);
-				refineTriangle(neg[i], fVec, sourceHarmonicMapPoints, pMap, uvVector, targetMesh, target, targetLandMark, sourceLandMark, /*targetObs,*/ pVec, updatedNumOfPoints);
-				isRefined[ neg[i] ] = true;
+				findTriangleNeighbors(list[i], fVec, sourceHarmonicMapPoints, sourceAdjacency, list, inTheList);
+				refineTriangle(list[i], fVec, sourceHarmonicMapPoints, pMap, targetMesh, sourceAdjacency, targetLocator, pVec);
+				isRefined[list[i]] = true;
 				continue;
 			}
 
-			if (isRefined[neg[i]])
+			if (isRefined[list[i]])
 				continue;
 
-			if (checkIfSimple(neg[i], fVec, pMap, uvVector))
-			{
-				inTheList[neg[i]] = false;
-				continue;
-			}
+			if (checkIfSimple(list[i], fVec, pMap, uvVector))
+				inTheList[list[i]] = false;
 			else
 			{
-				findTriangleNeighbors(neg[i], fVec, sourceHarmonicMapPoints, sourceLandMark, neg, inTheList);
-				refineTriangle(neg[i], fVec, sourceHarmonicMapPoints, pMap, uvVector, targetMesh, target, targetLandMark, sourceLandMark, /*targetObs,*/ pVec, updatedNumOfPoints);
-				isRefined[neg[i]] = true;
+				findTriangleNeighbors(list[i], fVec, sourceHarmonicMapPoints, sourceAdjacency, list, inTheList);
+				refineTriangle(list[i], fVec, sourceHarmonicMapPoints, pMap, targetMesh, sourceAdjacency, targetLocator, pVec);
+				isRefined[list[i]] = true;
 			}
-			/*if ( !triangulateNeighbor(neg[i], fVec,  sourceHarmonicMapPoints,  pMap, uvVector) )
-			{
-				findTriangleNeighbors(neg[i], fVec, sourceHarmonicMapPoints, sourceLandMark, neg);
-				refineTriangle(neg[i], fVec, sourceHarmonicMapPoints, pMap, uvVector, targetMesh, target, targetLandMark, sourceLandMark, targetObs, pVec, updatedNumOfPoints);
-			}*/
 		}
-
-		std::cout << "Done!\nSimplify - trying to reduce number of new points...\n";
-
-		// need to add here simplify function
-		CGAL::Timer simplifyTimer;
-		simplifyTimer.start();
-		simplify(pMap, fVec, uvVector);
-		simplifyTimer.stop();
-		
-		std::cout << "Done!\n" << "Total time to simplify : " << simplifyTimer.time() << " seconds\nTriangulating new polygons...\n";
-
-		int updateSize = tempUV.size();
-		std::map<Point_3, int> newUVtoIndicesMap;
-		std::set<Pair> visitedPairs;
-		auto mapIt = pMap.edgeToFace.begin();
-		auto mapEnd = pMap.edgeToFace.end();
-		while (mapIt != mapEnd)
+		for (int i = 0; i < (int)list.size(); ++i)
 		{
-			Pair e = mapIt->first;
-			if (visitedPairs.count(e) != 0)
-			{
-				mapIt++;
-				continue;
-			}
-			visitedPairs.insert(e);
-			visitedPairs.insert(e.reverse());
-			std::vector<Point_3> &vecOfPointsP1 = pMap.getEdgeUVs(e);
-			std::vector<Point_3> & meshVecP1 = pMap.getNewMeshPointsVec(e);
-			for (int i = 1; i < vecOfPointsP1.size() - 1; ++i)
-			{
-				newUVtoIndicesMap[vecOfPointsP1[i]] = updateSize;
-				tempUV.push_back(vecOfPointsP1[i]);
-				pVec.push_back(meshVecP1[i]);
-				updateSize++;
-			}
-			mapIt++;
+			inTheList[list[i]] = false;
+			isRefined[list[i]] = false;
 		}
 
-		bool result;
-		int len = neg.size();
-		for (int i = 0; i < len; ++i)
+		simplify(pMap, fVec, uvVector);
+		pMap.renumber();
+
+		//a face may be in the list more than once, isRefined marks the faces which are triangulated
+		region.newFaces.clear();
+		region.replacedFaces.clear();
+		for (int i = 0; i < (int)list.size(); ++i)
 		{
-			if (isTriangulated[neg[i]])
+			if (isRefined[list[i]])
 				continue;
-			result = triangulateNeighbor(neg[i], fVec, sourceHarmonicMapPoints, pMap, tempUV, newUVtoIndicesMap);
+			isRefined[list[i]] = true;
+			int numNewFaces = (int)region.newFaces.size();
+			bool result = triangulateNeighbor(list[i], fVec, sourceHarmonicMapPoints, pMap, uvVector, region.newFaces);
 			assert(result);
-			isTriangulated[neg[i]] = true;
+			if ((int)region.newFaces.size() > numNewFaces)
+				region.replacedFaces.push_back(list[i]);
 		}
-		
-		//////////////////////////////////////////////////
-		// -- need to triangulate all neighbors faces --//
-		//////////////////////////////////////////////////
-
-		//triangulateNeighbors(neighTri, fVec, sourceHarmonicMapPoints,pMap, uvVector);
-		int numOfNewPoints = pVec.size() - startSize;
-		std::cout << "Done!\n# of new points: " << numOfNewPoints << "\n";
-		uvVector = tempUV;
-		return (numOfNewPoints);
+		for (int i = 0; i < (int)list.size(); ++i)
+			isRefined[list[i]] = false;
+		region.isDone = true;
 	}
 
-	void findIntersection( Arrangement_2& target, const Landmarks_pl& targetLandMark, ESegment_2 seg , std::vector<EPoint_2>& intersectionPoints)
+	static int findRoot(std::vector<int>& parent, int r)
 	{
-		std::list<CGAL::Object> intersectionList;
-		Arrangement_2::Halfedge_handle halfedge;
-		Arrangement_2::Vertex_handle ver;
-		Arrangement_2::Face_handle face;
-		EPoint_2 p1, p2, pp1(RESET_NUM, RESET_NUM), pp2(RESET_NUM, RESET_NUM);
+		while (parent[r] != r)
+			r = parent[r] = parent[parent[r]];
+		return (r);
+	}
 
-		CGAL::zone(target, seg, std::back_inserter(intersectionList), targetLandMark);
+	//merges the regions which share a face. the merged regions are refined again, the others keep their result.
+	//returns false if the regions are disjoint.
+	static bool mergeOverlappingRegions(std::vector<RefineRegion>& regions, int firstId, std::vector<int>& owner)
+	{
+		int numRegions = (int)regions.size();
+		std::vector<int> parent(numRegions), numMembers(numRegions, 0);
+		for (int r = 0; r < numRegions; ++r)
+			parent[r] = r;
 
-		//std::vector<Arrangement_2::Halfedge_handle> temp;
-		//int k = 0;
-		//std::cout << "from:\t(" << seg.source().x() << "," << seg.source().y() << ")\n";
-		if (intersectionList.size() < 2)
-			return;
-		auto it = intersectionList.begin();
-		auto itEnd = intersectionList.end();
-		it++;
-		itEnd--;
+		bool isOverlapping = false;
+		for (int r = 0; r < numRegions; ++r)
+		{
+			const std::vector<int>& faces = regions[r].faces;
+			for (int i = 0; i < (int)faces.size(); ++i)
+			{
+				if (owner[faces[i]] == -1)
+				{
+					owner[faces[i]] = r;
+					continue;
+				}
+				int a = findRoot(parent, owner[faces[i]]), b = findRoot(parent, r);
+				if (a != b)
+				{
+					parent[(std::max)(a, b)] = (std::min)(a, b);	//the root is the first region of the group
+					isOverlapping = true;
+				}
+			}
+		}
+		for (int r = 0; r < numRegions; ++r)
+			for (int i = 0; i < (int)regions[r].faces.size(); ++i)
+				owner[regions[r].faces[i]] = -1;
+		if (!isOverlapping)
+			return (false);
 
-		for (; it != itEnd; it++)
-		//for (int i = 1; i < (int)intersectionList.size()-1; ++i)
+		for (int r = 0; r < numRegions; ++r)
+			numMembers[findRoot(parent, r)]++;
+		std::vector<RefineRegion> merged;
+		std::vector<int> slot(numRegions, -1);
+		for (int r = 0; r < numRegions; ++r)
 		{
-			if (assign(face, *it /*intersectionList[i]*/))
+			int root = findRoot(parent, r);
+			if (numMembers[root] == 1)
 			{
-				if (face->is_unbounded())
-					assert(0);
+				merged.push_back(RefineRegion(firstId));
+				std::swap(merged.back(), regions[r]);
 				continue;
 			}
-
-			if (assign(halfedge, *it /*intersectionList[i]*/))
+			if (root == r)
 			{
-				if (halfedge->next()->next()->next()->data()->index() != halfedge->data()->index())
-				{
-					halfedge = halfedge->twin();
-					//continue;
-				}
-
-				p1 = halfedge->source()->point();
-				p2 = halfedge->target()->point();
-				if ( ( (p1 == pp1) && (p2 == pp2) ) || ( (p1 == pp2) && (p2 == pp1) ) )
-					continue;
-				pp1 = p1;
-				pp2 = p2;
-
-				//std::cout << "p1 = (" << p1.x() << "," << p1.y() << ")\tp2 = (" << p2.x() << "," << p2.y() << ")\n";
+				slot[r] = (int)merged.size();
+				merged.push_back(RefineRegion(firstId));
+			}
+			std::vector<int>& seeds = merged[slot[root]].seeds;
+			seeds.insert(seeds.end(), regions[r].seeds.begin(), regions[r].seeds.end());
+		}
+		regions.swap(merged);
+		return (true);
+	}
 
-				std::vector<EPoint_2> localIntersectionPoints;
-				std::vector<ESegment_2> pp(2);
-				pp[0] = seg;
-				pp[1] = ESegment_2(p1, p2);				
-				CGAL::compute_intersection_points(pp.begin(), pp.end(), std::back_inserter(localIntersectionPoints));
+	int refine(std::vector<int>& neg, Mesh& sourceMesh, Mesh& targetMesh, const PointLocator& targetLocator, std::vector<Point_2>& sourceHarmonicMapPoints, std::vector<Kernel::Point_3> &pVec, std::vector<int>& fVec, std::vector<Point_3>& uvVector)
+	{
+		int size = neg.size();
 
-				if (localIntersectionPoints.size() == 1)
-					intersectionPoints.push_back(localIntersectionPoints[0]);
+		if (size == 0)
+		{
+			std::cout << "No need to refine.\n";
+			return 0;
+		}
+		else
+			std::cout << "# of negative triangles: " << size << "\nrefine...\n";
 
-				continue;
-				//std::cout << k << ":\t(" << intersectionPoints[k].x() << "," << intersectionPoints[k].y() << ")\n";
-				//k++;
+		//the source is only asked for the neighbors of the faces around the foldovers, which the halfedges of the mesh give
+		FaceAdjacency sourceAdjacency;
+		sourceAdjacency.attach(sourceMesh, fVec);
 
+		//the foldovers in different parts of the mesh are refined concurrently, each region with its own point map.
+		//the new points of every region get ids from firstId on, and the regions are merged in order. regions which
+		//grow into each other are merged and refined again, until they are disjoint. the exact queries on the target
+		//locator use points of the thread only, so a locator which is thread safe is shared.
+		int startSize = pVec.size();
+		int firstId = uvVector.size();
+		int numFaces = fVec.size() / 3;
+		std::vector<RefineRegion> regions;
+		groupFoldovers(neg, sourceAdjacency, firstId, regions);
+		std::cout << "# of foldover regions: " << regions.size() << "\n";
+
+		bool isParallel = targetLocator.isThreadSafe();
+		std::vector<int> owner(numFaces, -1);
+		do
+		{
+			int numRegions = (int)regions.size();
+#pragma omp parallel if (isParallel)
+			{
+				std::vector<bool> inTheList(numFaces, false), isRefined(numFaces, false);
+#pragma omp for schedule(dynamic)
+				for (int r = 0; r < numRegions; ++r)
+					if (!regions[r].isDone)
+						refineRegion(regions[r], targetMesh, sourceAdjacency, targetLocator, sourceHarmonicMapPoints, pVec, fVec, uvVector, inTheList, isRefined);
 			}
+		} while (mergeOverlappingRegions(regions, firstId, owner));
 
-			if (assign(ver, *it /*intersectionList[i]*/))
+		//the new points of the regions, and their triangulations, in the order of the regions
+		for (int r = 0; r < (int)regions.size(); ++r)
+		{
+			const RefineRegion& region = regions[r];
+			int shift = (int)uvVector.size() - firstId;
+			for (int k = 0; k < region.pMap.numOfNewPoints(); ++k)
 			{
-				intersectionPoints.push_back(ver->point());
-				//std::cout << k << ":\t(" << intersectionPoints[k].x() << "," << intersectionPoints[k].y() << ")\n";
-				//k++;
-				//std::cout << "I'm vertex!\n";
+				uvVector.push_back(region.pMap.uv(firstId + k, uvVector));
+				pVec.push_back(region.pMap.meshPoint(firstId + k));
 			}
-			
+			for (int i = 0; i < (int)region.replacedFaces.size(); ++i)
+			{
+				fVec[3 * region.replacedFaces[i] + 0] = -1;
+				fVec[3 * region.replacedFaces[i] + 1] = -1;
+				fVec[3 * region.replacedFaces[i] + 2] = -1;
+			}
+			for (int i = 0; i < (int)region.newFaces.size(); ++i)
+				fVec.push_back((region.newFaces[i] >= firstId) ? region.newFaces[i] + shift : region.newFaces[i]);
 		}
 
-
-		//std::cout << "to:\t(" << seg.target().x() << "," << seg.target().y() << ")\n\n\n";
-	}
-
-	void inverseList(std::vector<EPoint_2>& intersectionPoints)
-	{
-		std::reverse(intersectionPoints.begin(), intersectionPoints.end());
-		/*std::vector<EPoint_2> revList;
-		for (int i = (int)intersectionPoints.size() - 1; i >= 0; --i)
-			revList.push_back(intersectionPoints[i]);
-		for (int i = 0; i < (int)intersectionPoints.size(); ++i)
-			intersectionPoints[i] = revList[i];*/
-		
+		int numOfNewPoints = pVec.size() - startSize;
+		std::cout << "Done!\n# of new points: " << numOfNewPoints << "\n";
+		return (numOfNewPoints);
 	}
 
-	Point_3 calcNewUV(EPoint_2 tempP, Mesh& targetMesh, const Landmarks_pl& targetLandMark, /*Face_index_observer& targetObs,*/ std::vector<Point_3>& uvVector)
+	Point_3 calcNewUV(EPoint_2 tempP, Mesh& targetMesh, const PointLocator& targetLocator)
 	{
 		std::vector<int> indicesOrder;
 		std::vector<EPoint_2> points;
-		std::vector<EPoint_2> targetMeshPoints;
-		ARRTraits_2::Point_3 barPoint;
-		Arrangement_2::Face_const_handle targetFace;
+		int targetFace;
 
 		int type;
-		int index = findTarget(targetLandMark, tempP, type, targetFace); // face index
-		//targetFace = targetObs.getFace(index);
-		getPointsFromFace(targetFace, points, indicesOrder);
+		int index = findTarget(targetLocator, tempP, type, targetFace); // face index
+		if (index == -1)
+		{
+			//a crossing which the rounding of the disk maps puts just outside the target disk, it is snapped to the
+			//nearest point of the boundary
+			Point_2 nearest;
+			targetFace = targetLocator.disk().nearestBoundaryPoint(CGAL::to_double(tempP.x()), CGAL::to_double(tempP.y()), nearest);
+			tempP = EPoint_2(nearest.x(), nearest.y());
+		}
+		if (!targetLocator.disk().getFace(targetFace, points, indicesOrder))
+		{
+			std::cerr << "calcNewUV: the point is not in the target disk, and the disk has no boundary\n";
+			return Point_3(0, 0, 0);
+		}
 
-		barycentricCord(points, tempP, barPoint);
-		getPointsFromFace_Mesh(targetMesh, targetMeshPoints, indicesOrder);
-		auto res = reverseBarycentric(targetMeshPoints, barPoint);
-		uvVector.push_back(Mesh::Point_3(CGAL::to_double<ARRNumberType>(res.x()), CGAL::to_double<ARRNumberType>(res.y()), 0));
-		return ( uvVector[uvVector.size()-1] );
+		double bar[3];
+		barycentricCordFiltered(points, tempP, bar);
+		return (barycentricCombination(targetMesh, indicesOrder, bar));
 	}
 
-	Point_3 calcNewMeshPoint(EPoint_2 tempP, int faceIndex, std::vector<EPoint_2>& sourceHarmonicMapPoints, std::vector<Kernel::Point_3> &pVec, std::vector<int>& fVec)
+	Point_3 calcNewMeshPoint(EPoint_2 tempP, int faceIndex, std::vector<Point_2>& sourceHarmonicMapPoints, std::vector<Kernel::Point_3> &pVec, std::vector<int>& fVec)
 	{
 		std::vector<Point_3> meshFacePoints;
 		std::vector<int> indicesOrder;
 		std::vector<EPoint_2> points;
-		ARRTraits_2::Point_3 barPoint;
 	
 		points.resize(3);
 		meshFacePoints.resize(3);
 		for (int i = 0; i < 3; ++i)
 		{
-			points[i] = sourceHarmonicMapPoints[fVec[3 * faceIndex + i]];
+			points[i] = EPoint_2(sourceHarmonicMapPoints[fVec[3 * faceIndex + i]].x(), sourceHarmonicMapPoints[fVec[3 * faceIndex + i]].y());
 			meshFacePoints[i] = pVec[fVec[3 * faceIndex + i]];
 		}
 
-		barycentricCord(points, tempP, barPoint);
-		Point_3 p = reverseBarycentric(meshFacePoints, barPoint);
+		double bar[3];
+		barycentricCordFiltered(points, tempP, bar);
+		Point_3 p0 = meshFacePoints[0], p1 = meshFacePoints[1], p2 = meshFacePoints[2];
+		Point_3 p(p0.x()*bar[0] + p1.x()*bar[1] + p2.x()*bar[2], p0.y()*bar[0] + p1.y()*bar[1] + p2.y()*bar[2], p0.z()*bar[0] + p1.z()*bar[1] + p2.z()*bar[2]);
 		
 		return(p);
 		//pVec.push_back(p);
 	}
 
-	void extractIndicesFromPair(Pair& p, PointMap& pMap, std::vector<int>& polygonIndices, std::map<Point_3, int>& newUVtoIndicesMap)
-	{
-		polygonIndices.push_back(p.x);
-		auto vec = pMap.getEdgeUVs(p);
-		for (int i = 1; i < (int)vec.size()-1; ++i)
-			polygonIndices.push_back( newUVtoIndicesMap[vec[i]] );
-	}
-
-	void extractIndicesFromPair(Pair& e1, Pair& e2, Pair& e3, PointMap& pMap, std::vector<int>& polygonIndices, std::map<Point_3, int>& newUVtoIndicesMap)
-	{
-		extractIndicesFromPair(e1, pMap, polygonIndices, newUVtoIndicesMap);
-		extractIndicesFromPair(e2, pMap, polygonIndices, newUVtoIndicesMap);
-		extractIndicesFromPair(e3, pMap, polygonIndices, newUVtoIndicesMap);
-	}
-
 	void triangulateNewPolygon(std::vector<int>& polygonIndices, std::vector<Point_3>& uvVector, std::vector<int>& fVec)
 	{
 		std::map <int, int> mapToOriginalIndices;
@@ -1289,7 +1787,7 @@ void addPointsToTarget( Polygon_2 &poly , int numOfBorder , double avg_arc )
 
 
 
-	void findNegativeNeighbors(std::vector<int>& neg, std::vector<EPoint_2>& sourceHarmonicMapPoints, std::vector<int>& fVec, Arrangement_2& source, const Landmarks_pl& sourceLandMark)
+	void findNegativeNeighbors(std::vector<int>& neg, std::vector<Point_2>& sourceHarmonicMapPoints, std::vector<int>& fVec, Arrangement_2& source, const Landmarks_pl& sourceLandMark)
 	{
 		// i don't use this function anymore!
 		int N = neg.size();
@@ -1299,43 +1797,22 @@ void addPointsToTarget( Polygon_2 &poly , int numOfBorder , double avg_arc )
 	
 	}
 
-	void findTriangleNeighbors(int triIndex, std::vector<int>& fVec, std::vector<EPoint_2>& sourceHarmonicMapPoints, const Landmarks_pl& sourceLandMark, std::vector<int>& neighTri, std::vector<bool>& inTheList)
+	void findTriangleNeighbors(int triIndex, std::vector<int>& fVec, std::vector<Point_2>& sourceHarmonicMapPoints, const FaceAdjacency& sourceAdjacency, std::vector<int>& neighTri, std::vector<bool>& inTheList)
 	{
 		for (int j = 0; j < 3; ++j)
 		{
-			int v1 = 3 * triIndex + j;
-			int v2 = 3 * triIndex + ((j + 1) % 3);
-			EPoint_2 p1 = sourceHarmonicMapPoints[fVec[v1]];
-			EPoint_2 p2 = sourceHarmonicMapPoints[fVec[v2]];
-			ARRNumberType x = p1.x() + p2.x();
-			ARRNumberType y = p1.y() + p2.y();
-			EPoint_2 p(x / 2, y / 2);
-			auto res = sourceLandMark.locate(p);
-			Arrangement_2::Halfedge_const_iterator halfedge;
-			if (!CGAL::assign(halfedge, res))
-				assert(0);
-			if ((halfedge->face()->is_unbounded()) || (halfedge->twin()->face()->is_unbounded()))
+			int neighbor = sourceAdjacency.neighbor(triIndex, j);	//the face across the edge (j, j+1)
+			if (neighbor == -1)	//boundary edge
 				continue;
-			if (halfedge->face()->data()->index() != triIndex)
+			if (inTheList[neighbor] == false)
 			{
-				if (inTheList[halfedge->face()->data()->index()] == false)
-				{
-					inTheList[halfedge->face()->data()->index()] = true;
-					neighTri.push_back(halfedge->face()->data()->index());
-				}
-			}
-			else
-			{
-				if (inTheList[halfedge->twin()->face()->data()->index()] == false)
-				{
-					inTheList[halfedge->twin()->face()->data()->index()] = true;
-					neighTri.push_back(halfedge->twin()->face()->data()->index());
-				}
+				inTheList[neighbor] = true;
+				neighTri.push_back(neighbor);
 			}
 		}
 	}
 
-	void refineTriangle(int triIndex, std::vector<int>& fVec, std::vector<EPoint_2>& sourceHarmonicMapPoints, PointMap& pMap, std::vector<Point_3>& uvVector, Mesh& targetMesh, Arrangement_2& target, const Landmarks_pl& targetLandMark, const Landmarks_pl& sourceLandMark, /*Face_index_observer& targetObs,*/ std::vector<Kernel::Point_3> &pVec, int& updatedNumOfPoints)
+	void refineTriangle(int triIndex, std::vector<int>& fVec, std::vector<Point_2>& sourceHarmonicMapPoints, PointMap& pMap, Mesh& targetMesh, const FaceAdjacency& sourceAdjacency, const PointLocator& targetLocator, std::vector<Kernel::Point_3> &pVec)
 	{
 		for (int j = 0; j < 3; ++j)	//for each edge in the triangle find the intersections
 		{
@@ -1345,62 +1822,22 @@ void addPointsToTarget( Polygon_2 &poly , int numOfBorder , double avg_arc )
 			Pair e(fVec[v1], fVec[v2]);
 
 
-			if (((pMap[e]).size() != 0) || ((pMap[e.reverse()]).size() != 0))	//check if we already find the intersections
+			if (pMap.contains(e))	//check if we already find the intersections
 				continue;
 
-			ESegment_2 seg = ESegment_2(sourceHarmonicMapPoints[fVec[v1]], sourceHarmonicMapPoints[fVec[v2]]);
-			if (checkIfBoundaryEdge(seg, sourceLandMark))
+			if (checkIfBoundaryEdge(triIndex, j, sourceAdjacency))
 				continue;
 
-			findIntersection(target, targetLandMark, seg, intersectionPoints);
+			//the crossings of the edge with the target disk map, ordered from v1
+			targetLocator.disk().segmentCrossings(sourceHarmonicMapPoints[fVec[v1]], sourceHarmonicMapPoints[fVec[v2]], intersectionPoints);
 			if (intersectionPoints.size() == 0)
 				continue;
 
-			std::vector<Point_3> edgeUV, newMeshVec;
-			edgeUV.push_back(uvVector[fVec[v1]]);
-			newMeshVec.push_back(pVec[fVec[v1]]);
-
-			if (intersectionPoints.size()>1)
-			{
-				ESegment_2 s1(sourceHarmonicMapPoints[fVec[v1]], intersectionPoints[0]);
-				ESegment_2 s2(sourceHarmonicMapPoints[fVec[v1]], intersectionPoints[1]);
-				if (s1.line().to_vector().squared_length() > s2.line().to_vector().squared_length())
-					inverseList(intersectionPoints);
-			}
-
-			pMap.insert(e, intersectionPoints);	//update the map
+			//the face of the edge and the face of the opposite edge
+			int run = pMap.insertEdge(e, triIndex, sourceAdjacency.neighbor(triIndex, j));
 
 			for (int k = 0; k < (int)intersectionPoints.size(); ++k)	// for each new point find the uv cord , and the point to refine in the original source mesh
-			{
-				pMap.updateNewPoint(updatedNumOfPoints, intersectionPoints[k]);
-				updatedNumOfPoints++;
-
-				edgeUV.push_back ( calcNewUV(intersectionPoints[k], targetMesh, targetLandMark, /*targetObs,*/ uvVector) );
-				newMeshVec.push_back( calcNewMeshPoint(intersectionPoints[k], triIndex, sourceHarmonicMapPoints, pVec, fVec) );
-				//pVec.push_back(newMeshVec[newMeshVec.size() - 1]);	//need to remove it after the simplify function work!
-			}
-			edgeUV.push_back(uvVector[fVec[v2]]);
-			newMeshVec.push_back(pVec[fVec[v2]]);
-			pMap.insertUV(e, edgeUV);
-			pMap.insertNewMeshPoint(e, newMeshVec);
-
-			//now we found the face index of the edge and the opposite edge
-			pMap.edgeToFace[e] = triIndex;
-
-			EPoint_2 p1 = sourceHarmonicMapPoints[fVec[v1]];
-			EPoint_2 p2 = sourceHarmonicMapPoints[fVec[v2]];
-			ARRNumberType x = p1.x() + p2.x();
-			ARRNumberType y = p1.y() + p2.y();
-			EPoint_2 p(x / 2, y / 2);
-			auto res = sourceLandMark.locate(p);
-			Arrangement_2::Halfedge_const_iterator halfedge;
-			if (!CGAL::assign(halfedge, res))
-				assert(0);
-			if (halfedge->face()->data()->index() != triIndex)
-				pMap.edgeToFace[e.reverse()] = halfedge->face()->data()->index();
-			else
-				pMap.edgeToFace[e.reverse()] = halfedge->twin()->face()->data()->index();
-			
+				pMap.addPoint(run, calcNewUV(intersectionPoints[k], targetMesh, targetLocator), calcNewMeshPoint(intersectionPoints[k], triIndex, sourceHarmonicMapPoints, pVec, fVec));
 
 		}
 		// now we need to triangulate the polygon with the new points
@@ -1422,7 +1859,7 @@ void addPointsToTarget( Polygon_2 &poly , int numOfBorder , double avg_arc )
 	}
 
 
-	void triangulateNeighbors(std::vector<int>& neighTri, std::vector<int>& fVec, std::vector<EPoint_2>& sourceHarmonicMapPoints, PointMap& pMap, std::vector<Point_3>& uvVector)
+	void triangulateNeighbors(std::vector<int>& neighTri, std::vector<int>& fVec, std::vector<Point_2>& sourceHarmonicMapPoints, PointMap& pMap, std::vector<Point_3>& uvVector)
 	{
 		int N = neighTri.size();
 		for (int i = 0; i < N; ++i)
@@ -1450,7 +1887,7 @@ void addPointsToTarget( Polygon_2 &poly , int numOfBorder , double avg_arc )
 	
 	}
 
-	bool triangulateNewPolygon(std::vector<int>& polygonIndices, std::vector<EPoint_2>& sourceHarmonicMapPoints, std::vector<int>& fVec, PointMap& pMap, std::vector<Point_3>& uvVector)
+	bool triangulateNewPolygon(std::vector<int>& polygonIndices, std::vector<Point_2>& sourceHarmonicMapPoints, std::vector<int>& fVec, PointMap& pMap, std::vector<Point_3>& uvVector)
 	{
 
 		std::map <int, int> mapToOriginalIndices;
@@ -1460,7 +1897,7 @@ void addPointsToTarget( Polygon_2 &poly , int numOfBorder , double avg_arc )
 		for (int i = 0; i < N; ++i)
 		{
 			mapToOriginalIndices[i] = polygonIndices[i];
-			localPoly.push_back(Point_2(uvVector[polygonIndices[i]].x(), uvVector[polygonIndices[i]].y()));
+			localPoly.push_back(Point_2(pMap.uv(polygonIndices[i], uvVector).x(), pMap.uv(polygonIndices[i], uvVector).y()));
 		}
 
 #ifdef DEBUG_MATLAB1
@@ -1470,9 +1907,10 @@ void addPointsToTarget( Polygon_2 &poly , int numOfBorder , double avg_arc )
 			testPoly(i, 0) = localPoly[i].x();
 			testPoly(i, 1) = localPoly[i].y();
 		}
-		MatlabGMMDataExchange::SetEngineDenseMatrix("testPoly", testPoly);
-		MatlabInterface::GetEngine().Eval("figure");
-		MatlabInterface::GetEngine().Eval("impoly(gca,testPoly)");
+		VisualizationFrame frame;
+		frame.add("testPoly", testPoly);
+		frame.command = "figure;impoly(gca,testPoly)";
+		VisualizationSink::Get().post(frame);
 #endif
 
 		Shor localShor;
@@ -1492,28 +1930,16 @@ void addPointsToTarget( Polygon_2 &poly , int numOfBorder , double avg_arc )
 	
 
 
-	bool checkIfBoundaryEdge(ESegment_2& seg, const Landmarks_pl& sourceLandMark)
+	bool checkIfBoundaryEdge(int triIndex, int edge, const FaceAdjacency& sourceAdjacency)
 	{
-		EPoint_2 p1 = seg.source();
-		EPoint_2 p2 = seg.target();
-		ARRNumberType x = p1.x() + p2.x();
-		ARRNumberType y = p1.y() + p2.y();
-		EPoint_2 p(x / 2, y / 2);
-		auto res = sourceLandMark.locate(p);
-		Arrangement_2::Halfedge_const_iterator halfedge;
-		if (!CGAL::assign(halfedge, res))
-			assert(0);
-
-		if ((halfedge->face()->is_unbounded()) || (halfedge->twin()->face()->is_unbounded()))
-			return (true);
-		else
-			return (false);
+		return (sourceAdjacency.isBoundaryEdge(triIndex, edge));
 	}
 
 	
 
 
-	bool triangulateNeighbor(int triIndex, std::vector<int>& fVec, std::vector<EPoint_2>& sourceHarmonicMapPoints, PointMap& pMap, std::vector<Point_3>& uvVector, std::map<Point_3, int>& newUVtoIndicesMap)
+	//appends the triangulation of the refined face to newFaces, fVec is not changed
+	bool triangulateNeighbor(int triIndex, std::vector<int>& fVec, std::vector<Point_2>& sourceHarmonicMapPoints, PointMap& pMap, std::vector<Point_3>& uvVector, std::vector<int>& newFaces)
 	{
 		Pair e1(fVec[3 * triIndex + 0], fVec[3 * triIndex + 1]);
 		Pair e2(fVec[3 * triIndex + 1], fVec[3 * triIndex + 2]);
@@ -1523,19 +1949,12 @@ void addPointsToTarget( Polygon_2 &poly , int numOfBorder , double avg_arc )
 			return (true);	// already triangulated
 
 		std::vector<int> polygonIndices;
-		extractIndicesFromPair(e1, e2, e3, pMap, polygonIndices, newUVtoIndicesMap);
+		extractIndicesFromPair(e1, e2, e3, pMap, polygonIndices);
 
 		if (polygonIndices.size() == 3)
 			return (true); // no need to triangulate
 
-		if (!triangulateNewPolygon(polygonIndices, sourceHarmonicMapPoints, fVec, pMap, uvVector))
-			return (false);
-
-		fVec[3 * triIndex + 0] = -1;
-		fVec[3 * triIndex + 1] = -1;
-		fVec[3 * triIndex + 2] = -1;
-	
-		return (true);
+		return (triangulateNewPolygon(polygonIndices, sourceHarmonicMapPoints, newFaces, pMap, uvVector));
 	}
 
 
@@ -1555,7 +1974,7 @@ void addPointsToTarget( Polygon_2 &poly , int numOfBorder , double avg_arc )
 		int N = (int)polygonIndices.size();
 
 		for (int i = 0; i < N; ++i)
-			localPoly.push_back(Point_2(uvVector[polygonIndices[i]].x(), uvVector[polygonIndices[i]].y()));
+			localPoly.push_back(Point_2(pMap.uv(polygonIndices[i], uvVector).x(), pMap.uv(polygonIndices[i], uvVector).y()));
 		
 
 		if (localPoly.is_simple())
@@ -1632,175 +2051,258 @@ void addPointsToTarget( Polygon_2 &poly , int numOfBorder , double avg_arc )
 	
 	
 	*/
-	void setOrderOfEdges(Pair *p, int face, std::vector<int>& fVec)
+	//removes new points from the refined edges as long as the polygons of the two faces of the edge stay simple and
+	//counter clockwise in the uv plane. the points are tried in the order of the area of the triangle they make with
+	//their neighbors, so the points which change the shape least go first. a removal replaces the segments (a, p) and
+	//(p, b) by (a, b), so only (a, b) is tested against the other segments of the two polygons. the polygons are small,
+	//so the segments are scanned with a bounding box test first. the neighbors of a removed point, and the points which
+	//were rejected in the two faces, are queued again.
+	class ChainSimplifier
 	{
-		Pair e1(fVec[3 * face + 0], fVec[3 * face + 1]);
-		Pair e2(fVec[3 * face + 1], fVec[3 * face + 2]);
-		Pair e3(fVec[3 * face + 2], fVec[3 * face + 0]);
+	public:
 
-		if (p[0] == e1)
+		ChainSimplifier(PointMap& pMap, std::vector<int>& fVec, std::vector<Point_3>& uvVector) : pMap(pMap), fVec(fVec), uvVector(uvVector)
 		{
-			p[1] = e2;
-			p[2] = e3;
-			return;
-		}
-		if (p[0] == e2)
-		{
-			p[1] = e3;
-			p[2] = e1;
-			return;
-		}
-		if (p[0] == e3)
-		{
-			p[1] = e1;
-			p[2] = e2;
-			return;
-		}
-		assert(0); //problem
-	}
+			firstId = pMap.firstId();
+			int numIds = pMap.numOfNewPoints();
+			prev.resize(numIds);
+			next.resize(numIds);
+			runOf.resize(numIds);
+			stamp.assign(numIds, 0);
+			isRemoved.assign(numIds, false);
+			head.resize(pMap.numEdges());
+
+			for (int run = 0; run < pMap.numEdges(); ++run)
+			{
+				const PointMap::EdgeRun& edge = pMap.edge(run);
+				Pair e(edge.from, edge.to);
+				int last = edge.from;
+				head[run] = (edge.size > 0) ? pMap.id(e, 0) : edge.to;
+				for (int i = 0; i < edge.size; ++i)
+				{
+					int id = pMap.id(e, i);
+					runOf[id - firstId] = run;
+					prev[id - firstId] = last;
+					next[id - firstId] = (i + 1 < edge.size) ? pMap.id(e, i + 1) : edge.to;
+					last = id;
+				}
+			}
 
-	void checkForNull(std::vector<Point_3>& v, Pair e, std::vector<Point_3>& uvVector, std::vector<Point_3>& refVec)
-	{
-		if (v.size() > 0)
-		{
-			if (v[0] == refVec[refVec.size() - 1])
-				return;
-			assert(0);
-		}
-		if (uvVector[e.x] == refVec[refVec.size() - 1]) 
-		{
-			v.push_back(uvVector[e.x]);
-			v.push_back(uvVector[e.y]);
-		}
-		else
-		{
-			v.push_back(uvVector[e.y]);
-			v.push_back(uvVector[e.x]);
+			//only faces which start simple and counter clockwise lose points
+			for (int run = 0; run < pMap.numEdges(); ++run)
+			{
+				initFace(pMap.edge(run).face);
+				initFace(pMap.edge(run).oppositeFace);
+			}
 		}
-		
-	}
 
-	void simplify(PointMap& pMap, std::vector<int>& fVec, std::vector<Point_3>& uvVector)
-	{
-		bool stopFlag = true;
-		Pair p1[3], p2[3];	//represent the polygons we want to reduce in thier shared edges the number of points
-		std::vector<Point_3> tempVec, tempVec2;	//the polygons that we check if they are simple will be here
-		while (stopFlag)
+		void run()
 		{
-			stopFlag = false;
-			auto mapIt = pMap.edgeToFace.begin();
-			auto mapEnd = pMap.edgeToFace.end();
-			while (mapIt != mapEnd)
-			{
-				p1[0] = Pair((mapIt->first).x, (mapIt->first).y);
-				p2[0] = p1[0].reverse();
-				setOrderOfEdges(p1, mapIt->second, fVec);
-				setOrderOfEdges(p2, pMap.edgeToFace[p2[0]], fVec);
+			for (int id = firstId; id < firstId + (int)prev.size(); ++id)
+				push(id);
 
-				std::vector<Point_3> &vecOfPointsP1 = pMap.getEdgeUVs(p1[0]);
-				std::vector<Point_3> &vecOfPointsP2 = pMap.getEdgeUVs(p2[0]);
-				std::vector<Point_3> & meshVecP1 = pMap.getNewMeshPointsVec(p1[0]);
-				std::vector<Point_3> & meshVecP2 = pMap.getNewMeshPointsVec(p2[0]);
+			while (!queue.empty())
+			{
+				Candidate candidate = queue.top();
+				queue.pop();
+				int k = candidate.id - firstId;
+				if (isRemoved[k] || candidate.stamp != stamp[k])
+					continue;
 
-				tempVec.clear();
-				tempVec2.clear();
+				const PointMap::EdgeRun& edge = pMap.edge(runOf[k]);
+				if (!tryRemove(candidate.id, edge))
+				{
+					rejected[slot(edge.face)].push_back(candidate.id);
+					rejected[slot(edge.oppositeFace)].push_back(candidate.id);
+					continue;
+				}
 
-				tempVec = vecOfPointsP1;
-				tempVec2 = vecOfPointsP2;
+				int a = prev[k], b = next[k];
+				if (a >= firstId)
+					push(a);
+				if (b >= firstId)
+					push(b);
+				retry(edge.face);
+				retry(edge.oppositeFace);
+			}
 
-				if (tempVec.size() == 0)
-					assert(0);
+			pMap.removeIds(isRemoved);
+		}
 
-				std::vector<Point_3>  vec21 = pMap.getEdgeUVs(p1[1]), vec31 = pMap.getEdgeUVs(p1[2]);	//p1 edges
-				std::vector<Point_3>  vec22 = pMap.getEdgeUVs(p2[1]), vec32 = pMap.getEdgeUVs(p2[2]);	//p2 edges
+	protected:
 
-				checkForNull(vec21, p1[1], uvVector, tempVec);
-				checkForNull(vec22, p2[1], uvVector, tempVec2);
-				tempVec.pop_back();
-				tempVec2.pop_back();
+		struct Candidate
+		{
+			double priority;
+			int id, stamp;
+			bool operator<(const Candidate& other) const { return (priority > other.priority); } //smallest first
+		};
 
-				tempVec.insert(tempVec.end(), vec21.begin(), vec21.end());
-				tempVec2.insert(tempVec2.end(), vec22.begin(), vec22.end());
+		const Point_3& uv(int index) const { return (pMap.uv(index, uvVector)); }
+		IKernel::Point_2 point(int index) const { return (IKernel::Point_2(uv(index).x(), uv(index).y())); }
 
-				checkForNull(vec31, p1[2], uvVector, tempVec);
-				checkForNull(vec32, p2[2], uvVector, tempVec2);
-				tempVec.pop_back();
-				tempVec2.pop_back();
+		//twice the signed area of the triangle (a, p, b)
+		double cross(int a, int p, int b) const
+		{
+			const Point_3 &pa = uv(a), &pp = uv(p), &pb = uv(b);
+			return ((pp.x() - pa.x()) * (pb.y() - pa.y()) - (pp.y() - pa.y()) * (pb.x() - pa.x()));
+		}
 
-				tempVec.insert(tempVec.end(), vec31.begin(), vec31.end());
-				tempVec2.insert(tempVec2.end(), vec32.begin(), vec32.end());
-				tempVec.pop_back();
-				tempVec2.pop_back();
+		int slot(int face) const { return (slotOf.find(face)->second); }
 
-				Polygon_2 poly1, poly2;
-				for (int j = 0; j < (int)tempVec.size(); ++j)
-					poly1.push_back(Point_2(tempVec[j][0], tempVec[j][1]));
-				for (int j = 0; j < (int)tempVec2.size(); ++j)
-					poly2.push_back(Point_2(tempVec2[j][0], tempVec2[j][1]));
+		void initFace(int face)
+		{
+			if (face < 0 || slotOf.count(face) > 0)
+				return;
+			slotOf[face] = (int)area.size();
+			Pair e1(fVec[3 * face + 0], fVec[3 * face + 1]);
+			Pair e2(fVec[3 * face + 1], fVec[3 * face + 2]);
+			Pair e3(fVec[3 * face + 2], fVec[3 * face + 0]);
+			std::vector<int> polygonIndices;
+			extractIndicesFromPair(e1, e2, e3, pMap, polygonIndices);
 
-				int len = vecOfPointsP1.size();
-				for (int i = 1; i < len - 1; ++i)
-				{
-					auto save = poly1[i];
-					if (save != Point_2(vecOfPointsP1[i][0], vecOfPointsP1[i][1]))
-						assert(0);
-					poly1.erase(poly1.vertices_begin() + i);
-					poly2.erase(poly2.vertices_begin() + (len - 1 - i));
-					//vecOfPointsP1.erase(vecOfPointsP1.begin() + i);
-					//vecOfPointsP2.erase(vecOfPointsP2.begin() + (len-1-i));
-					
-					/*/GMMDenseColMatrix testPoly(tempVec.size(), 2) , testPoly2(tempVec2.size(),2);
+			CGAL::Polygon_2<IKernel> poly;
+			for (int i = 0; i < (int)polygonIndices.size(); ++i)
+				poly.push_back(point(polygonIndices[i]));
+			area.push_back(CGAL::to_double(poly.area()));
+			isFrozen.push_back(!(poly.is_simple() && poly.orientation() == CGAL::COUNTERCLOCKWISE));
+			rejected.push_back(std::vector<int>());
+		}
 
-					
+		void push(int id)
+		{
+			int k = id - firstId;
+			Candidate candidate = { std::fabs(cross(prev[k], id, next[k])), id, ++stamp[k] };
+			queue.push(candidate);
+		}
 
-						//testPoly(j, 0) = tempVec[j][0];
-						//testPoly(j, 1) = tempVec[j][1];
-					//}
-					
+		void retry(int face)
+		{
+			std::vector<int>& points = rejected[slot(face)];
+			for (int i = 0; i < (int)points.size(); ++i)
+				if (!isRemoved[points[i] - firstId])
+					push(points[i]);
+			points.clear();
+		}
 
-						//testPoly2(j, 0) = tempVec2[j][0];
-						//testPoly2(j, 1) = tempVec2[j][1];
-					//}
+		//the node after node in the chain of the run, from edge.from to edge.to
+		int following(int run, int node) const
+		{
+			return ((node == pMap.edge(run).from) ? head[run] : next[node - firstId]);
+		}
 
-					//MatlabGMMDataExchange::SetEngineDenseMatrix("testPoly", testPoly);
-					//MatlabGMMDataExchange::SetEngineDenseMatrix("testPoly2", testPoly2);
-					//MatlabInterface::GetEngine().Eval("figure");
-					//MatlabInterface::GetEngine().Eval("subplot(2,1,1);impoly(gca,testPoly);subplot(2,1,2);impoly(gca,testPoly2)");*/
+		//false if the segment (c, d) of the polygon is in the way of (a, b), which replaces (a, p) and (p, b)
+		bool isAllowed(int a, int p, int b, int c, int d) const
+		{
+			if (c == p || d == p)
+				return (true);	//(a, p) or (p, b)
 
+			int shared = -1, other = -1;
+			if (c == a || c == b)
+			{
+				shared = c;
+				other = d;
+			}
+			else if (d == a || d == b)
+			{
+				shared = d;
+				other = c;
+			}
+			if (shared != -1)
+			{
+				if (other == a || other == b)
+					return (false);	//the polygon would have two vertices
+				//an adjacent segment only overlaps (a, b) if it goes back along it
+				int end = (shared == a) ? b : a;
+				return (!(CGAL::collinear(point(shared), point(end), point(other)) && !CGAL::collinear_are_ordered_along_line(point(other), point(shared), point(end))));
+			}
 
+			const Point_3 &pa = uv(a), &pb = uv(b), &pc = uv(c), &pd = uv(d);
+			if ((std::max)(pc.x(), pd.x()) < (std::min)(pa.x(), pb.x()) || (std::min)(pc.x(), pd.x()) > (std::max)(pa.x(), pb.x()) ||
+				(std::max)(pc.y(), pd.y()) < (std::min)(pa.y(), pb.y()) || (std::min)(pc.y(), pd.y()) > (std::max)(pa.y(), pb.y()))
+				return (true);
+			return (!CGAL::do_intersect(IKernel::Segment_2(point(a), point(b)), IKernel::Segment_2(point(c), point(d))));
+		}
 
-					if ((poly1.is_simple()) && (poly2.is_simple()) && (poly1.orientation() == 1) && (poly2.orientation() == 1))
-					{
-						vecOfPointsP1.erase(vecOfPointsP1.begin() + i);
-						vecOfPointsP2.erase(vecOfPointsP2.begin() + (len-1-i));
-						len--;
-						i--;
-						meshVecP1.erase(meshVecP1.begin()+i);
-						meshVecP2.erase(meshVecP2.begin() + (len-1-i) );
-						stopFlag = true;
-					}
-					else
-					{
-						poly1.insert(poly1.vertices_begin() + i, save);
-						poly2.insert(poly2.vertices_begin() + (len - 1 - i), save);
-						//vecOfPointsP1.insert(vecOfPointsP1.begin() + i , save);
-						//vecOfPointsP2.insert(vecOfPointsP2.begin() + (len - 1 - i) , save);
-					}
+		bool isAllowedInFace(int face, int a, int p, int b) const
+		{
+			for (int j = 0; j < 3; ++j)
+			{
+				int u = fVec[3 * face + j], w = fVec[3 * face + (j + 1) % 3];
+				int run = pMap.find(Pair(u, w));
+				if (run == -1)
+				{
+					if (!isAllowed(a, p, b, u, w))
+						return (false);
+					continue;
+				}
+				for (int node = pMap.edge(run).from; node != pMap.edge(run).to; )
+				{
+					int nextNode = following(run, node);
+					if (!isAllowed(a, p, b, node, nextNode))
+						return (false);
+					node = nextNode;
 				}
-
-				mapIt++;
 			}
+			return (true);
+		}
 
+		bool tryRemove(int id, const PointMap::EdgeRun& edge)
+		{
+			if (edge.oppositeFace < 0)
+				return (false);
+			int face = slot(edge.face), oppositeFace = slot(edge.oppositeFace);
+			if (isFrozen[face] || isFrozen[oppositeFace])
+				return (false);
+
+			//(a, p, b) goes along the polygon of edge.face and backwards along the polygon of edge.oppositeFace
+			int k = id - firstId;
+			int a = prev[k], b = next[k];
+			double change = 0.5 * cross(a, id, b);
+			if (area[face] - change <= 0.0 || area[oppositeFace] + change <= 0.0)
+				return (false);
+			if (!isAllowedInFace(edge.face, a, id, b) || !isAllowedInFace(edge.oppositeFace, a, id, b))
+				return (false);
+
+			area[face] -= change;
+			area[oppositeFace] += change;
+			isRemoved[k] = true;
+			if (a >= firstId)
+				next[a - firstId] = b;
+			else
+				head[runOf[k]] = b;
+			if (b >= firstId)
+				prev[b - firstId] = a;
+			return (true);
 		}
-	
+
+	protected:
+
+		PointMap& pMap;
+		std::vector<int>& fVec;
+		std::vector<Point_3>& uvVector;
+		int firstId;
+		std::vector<int> prev, next, runOf, stamp;	//by id - firstId
+		std::vector<bool> isRemoved;
+		std::vector<int> head;	//first node after the start of every run
+		std::unordered_map<int, int> slotOf;	//slot of every face of the runs
+		std::vector<double> area;	//by slot
+		std::vector<bool> isFrozen;
+		std::vector<std::vector<int> > rejected;	//points which failed
+		std::priority_queue<Candidate> queue;
+	};
+
+	void simplify(PointMap& pMap, std::vector<int>& fVec, std::vector<Point_3>& uvVector)
+	{
+		ChainSimplifier simplifier(pMap, fVec, uvVector);
+		simplifier.run();
 	}
 
 
 	void extractIndicesFromPair(Pair& p, PointMap& pMap, std::vector<int>& polygonIndices)
 	{
 		polygonIndices.push_back(p.x);
-		for (int i = 0; i < (int)pMap[p].size(); ++i)
-			polygonIndices.push_back(pMap.getNewIndex(pMap[p][i]));
+		pMap.getIds(p, polygonIndices);
 	}
 
 	void extractIndicesFromPair(Pair& e1, Pair& e2, Pair& e3, PointMap& pMap, std::vector<int>& polygonIndices)
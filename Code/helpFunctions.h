@@ -1,4 +1,6 @@
 #pragma once
+class PointLocator;
+
 class Pair
 {
 public:
@@ -26,183 +28,192 @@ public:
 	~Pair(){}
 };
 
+//the new points of the refined source edges. every undirected edge keeps the ids of its new points once, in a flat
+//array and in the direction it was inserted with. a run is read in either direction. the new points get the ids from
+//firstId on, and the map keeps their uvs and mesh points, so the ids below firstId are the vertices of uvVector.
 class PointMap
 {
-	//std::vector < std::vector<EPoint_2> > pMap;
-	//std::vector < Pair > indexMap;
-	std::vector<EPoint_2> nullVector;
-	std::vector<Point_3> nullVec;
-
-	std::vector<EPoint_2> newPoints;
-	std::vector <int> newIndices;
-
-	std::map< Pair, std::vector<EPoint_2> > pairToVectorMap;
-	std::map< int, EPoint_2 > indexToPointMap;
-	std::map < EPoint_2, int > invIndexToPointMap;
-
-	std::map< int, Point_3 > indexToNewUV;
-	std::map < Point_3, int > invIndexToNewUV;
-
-	std::map< Pair, std::vector<Point_3> > EdgesUV;
-	std::map< Pair, std::vector<Point_3> > edgeToMesh;
-
 public:
-	std::map< Pair, int > edgeToFace;
-	PointMap(){ nullVector.clear(); nullVec.clear(); }
-	~PointMap(){}
-	std::vector<EPoint_2>& operator[](Pair key)
-	{ 
-		/*int val = -1;
-		for (int i = 0; i < (int)this->indexMap.size(); ++i)
-			if (indexMap[i] == key)
-			{
-				val = i;
-				break;
-			}
-		if (val != -1)
-			return (pMap[val]);
-		else
-			return (nullVector);*/
-		if (pairToVectorMap.count(key) == 0)
-			return (nullVector);
-		return (pairToVectorMap[key]);
-	}
-
-	void insert(Pair key, std::vector<EPoint_2>& val)
+	struct EdgeRun
 	{
-		pairToVectorMap[key] = val;
-		//indexMap.push_back(key);
-		//this->pMap.push_back(val);
-
-		Pair revKey = key.reverse();
-		std::vector<EPoint_2> revVal(val.rbegin(),val.rend());
-		//std::vector<CGAL::Point_2<Kernel>> revPointsVec(pointsVec.rbegin(), pointsVec.rend());
-		//for (int i = (int)val.size()-1; i >= 0; --i)
-		//	revVal.push_back(val[i]);
-
-		pairToVectorMap[revKey] = revVal;
-		//indexMap.push_back(revKey);
-		//this->pMap.push_back(revVal);
-	}
+		int from, to;		//the direction of the ids
+		int begin, size;	//the ids are mIds[begin, begin + size)
+		int face, oppositeFace;	//the face of (from, to) and the face of (to, from)
+	};
 
-	void insertUV(Pair key, std::vector<Point_3>& val)
+	PointMap(int firstId) : mFirstId(firstId) {}
+
+	int numEdges() const { return (int)mRuns.size(); }
+	const EdgeRun& edge(int run) const { return mRuns[run]; }
+	bool contains(Pair e) const { return (find(e) != -1); }
+
+	//index of the run of the edge in either direction, -1 if the edge has no new points
+	int find(Pair e) const
 	{
-		EdgesUV[key] = val;
-		Pair revKey = key.reverse();
-		std::vector<Point_3> revVal(val.rbegin(), val.rend());
-		EdgesUV[revKey] = revVal;
+		std::unordered_map<unsigned long long, int>::const_iterator it = mEdgeToRun.find(key(e));
+		return ((it == mEdgeToRun.end()) ? -1 : it->second);
 	}
 
-	void insertNewMeshPoint(Pair key, std::vector<Point_3>& val)
+	//the points of the new run are added with addPoint before the next edge is inserted
+	int insertEdge(Pair e, int face, int oppositeFace)
 	{
-		edgeToMesh[key] = val;
-		Pair revKey = key.reverse();
-		std::vector<Point_3> revVal(val.rbegin(), val.rend());
-		edgeToMesh[revKey] = revVal;
+		EdgeRun run = { e.x, e.y, (int)mIds.size(), 0, face, oppositeFace };
+		mRuns.push_back(run);
+		mEdgeToRun[key(e)] = (int)mRuns.size() - 1;
+		return ((int)mRuns.size() - 1);
 	}
 
-	std::vector<Point_3>& getEdgeUVs(Pair edge)
+	//returns the id of the new point
+	int addPoint(int run, const Point_3& uv, const Point_3& meshPoint)
 	{
-		if (EdgesUV.count(edge) == 0)
-			return (nullVec);
-		return (EdgesUV[edge]);
+		assert(run == (int)mRuns.size() - 1);
+		int id = mFirstId + (int)mMeshPoints.size();
+		mIds.push_back(id);
+		mRuns[run].size++;
+		mUVs.push_back(uv);
+		mMeshPoints.push_back(meshPoint);
+		return (id);
 	}
 
-	std::vector<Point_3>& getNewMeshPointsVec(Pair edge)
+	//the face on the left of the directed edge
+	int face(Pair e) const
 	{
-		return (edgeToMesh[edge]);
+		const EdgeRun& run = mRuns[find(e)];
+		return ((run.from == e.x) ? run.face : run.oppositeFace);
 	}
 
-	void updateNewPoint(int newIndex, EPoint_2& newPoint)
+	int numPoints(Pair e) const
 	{
-		indexToPointMap[newIndex] = newPoint;
-		invIndexToPointMap[newPoint] = newIndex;
-		//this->newPoints.push_back(newPoint);
-		//this->newIndices.push_back(newIndex);
+		int run = find(e);
+		return ((run == -1) ? 0 : mRuns[run].size);
 	}
 
-	void updateNewUV(int newIndex, Point_3& newUV)
+	//the i'th new point from e.x
+	int id(Pair e, int i) const
 	{
-		indexToNewUV[newIndex] = newUV;
-		invIndexToNewUV[newUV] = newIndex;
+		const EdgeRun& run = mRuns[find(e)];
+		return ((run.from == e.x) ? mIds[run.begin + i] : mIds[run.begin + run.size - 1 - i]);
 	}
 
-	int getNewIndex(EPoint_2& newPoint)
+	//appends the ids of the new points, ordered from e.x
+	void getIds(Pair e, std::vector<int>& ids) const
 	{
-		return (invIndexToPointMap[newPoint]);
-		/*for (int i = 0; i < (int)newPoints.size(); ++i)
-			if (newPoints[i] == newPoint)
-				return (newIndices[i]);*/
+		int n = numPoints(e);
+		for (int i = 0; i < n; ++i)
+			ids.push_back(id(e, i));
 	}
 
-	EPoint_2& getNewPoint(int index)
+	void erase(Pair e, int i)
 	{
-		return (indexToPointMap[index]);
-		//for (int i = 0; i < (int)newIndices.size(); ++i)
-		//	if (newIndices[i] == index)
-		//		return (newPoints[i]);
+		EdgeRun& run = mRuns[find(e)];
+		int k = (run.from == e.x) ? i : run.size - 1 - i;
+		for (int t = run.begin + k; t < run.begin + run.size - 1; ++t)	//the following runs stay in place
+			mIds[t] = mIds[t + 1];
+		run.size--;
 	}
 
-	int numOfNewPoints()
+	//drops the ids which are flagged (by id - firstId()) from all the runs
+	void removeIds(const std::vector<bool>& isRemoved)
 	{
-		return((int)indexToPointMap.size());
+		for (int r = 0; r < (int)mRuns.size(); ++r)
+		{
+			EdgeRun& run = mRuns[r];
+			int size = 0;
+			for (int i = 0; i < run.size; ++i)
+				if (!isRemoved[mIds[run.begin + i] - mFirstId])
+					mIds[run.begin + size++] = mIds[run.begin + i];
+			run.size = size;
+		}
 	}
 
-	void test()
+	//gives the points which are left consecutive ids from firstId, in the order of the runs
+	void renumber()
 	{
-		/*for (int i = 0; i < (int)pMap.size(); ++i)
+		std::vector<Point_3> uvs, meshPoints;
+		for (int r = 0; r < (int)mRuns.size(); ++r)
 		{
-			std::cout << "Pair - (" << indexMap[i].x << "," << indexMap[i].y << ")\n";
-			for (int j = 0; j < (int)pMap[i].size(); ++j)
+			const EdgeRun& run = mRuns[r];
+			for (int t = run.begin; t < run.begin + run.size; ++t)
 			{
-				std::cout << "(" << pMap[i][j].x() << "," << pMap[i][j].y() << ")\n";
+				uvs.push_back(mUVs[mIds[t] - mFirstId]);
+				meshPoints.push_back(mMeshPoints[mIds[t] - mFirstId]);
+				mIds[t] = mFirstId + (int)uvs.size() - 1;
 			}
-		}*/
-	
+		}
+		mUVs.swap(uvs);
+		mMeshPoints.swap(meshPoints);
 	}
+
+	const Point_3& uv(int id, const std::vector<Point_3>& uvVector) const { return ((id < mFirstId) ? uvVector[id] : mUVs[id - mFirstId]); }
+	const Point_3& meshPoint(int id) const { return mMeshPoints[id - mFirstId]; }
+	int firstId() const { return mFirstId; }
+	int numOfNewPoints() const { return (int)mMeshPoints.size(); }
+
+protected:
+
+	static unsigned long long key(Pair e)
+	{
+		unsigned int a = (unsigned int)((e.x < e.y) ? e.x : e.y);
+		unsigned int b = (unsigned int)((e.x < e.y) ? e.y : e.x);
+		return (((unsigned long long)a << 32) | b);
+	}
+
+protected:
+
+	int mFirstId;
+	std::unordered_map<unsigned long long, int> mEdgeToRun;
+	std::vector<EdgeRun> mRuns;
+	std::vector<int> mIds;
+	std::vector<Point_3> mUVs, mMeshPoints; //by id - mFirstId
 };
 
 
-void loadSourceMesh( Mesh &source_mesh , std::vector<Kernel::Point_3> &pVec , std::vector<int> &fVec );
+//pVec and fVec are renumbered with the policy of RunOptions::reorder, reordering keeps the permutation
+bool loadSourceMesh( Mesh &source_mesh , std::vector<Kernel::Point_3> &pVec , std::vector<int> &fVec , MeshReordering &reordering );
 void addPointsToTarget( Polygon_2 &poly , int numOfBorder , double avg_arc );
 void HarmonicFlattening(Mesh &source_mesh, GMMSparseRowMatrix &u, GMMSparseRowMatrix &weightsMat, bool harmonic = true);
+void HarmonicFlattening(const IndexMesh &mesh, GMMSparseRowMatrix &u, GMMSparseRowMatrix &weightsMat, bool harmonic = true);
+void convertToCSR(GMMSparseRowMatrix &A, SparseMatrixCSR &csr);
+int countFlippedDiskTriangles(const GMMDenseColMatrix &map, const std::vector<int> &fVec, int &numDegenerate);
+bool solveHarmonicMap(GMMSparseRowMatrix &weightsMat, GMMSparseRowMatrix &u, const std::vector<int> &fVec, GMMDenseColMatrix &map, const HarmonicSolverOptions &options, HarmonicSolverCache &solverCache);
 void getPointsFromFace( const Arrangement_2::Face_const_handle& face, std::vector<EPoint_2>& points , std::vector<int>& indicesOrder);
 void getPointsFromFace_Mesh( Mesh& targetMesh/*const Mesh::Face_const_handle& face*/, std::vector<EPoint_2>& points , std::vector<int>& indicesOrder );
-void BuildArrangement(Arrangement_2& arr, Landmarks_pl& trap, const std::vector<EPoint_2>& vertices, const std::vector<int>& faces, /*Face_index_observer& obs,*/ Mesh &source_mesh);
+void BuildArrangement(Arrangement_2& arr, const std::vector<Point_2>& vertices, const std::vector<int>& faces, /*Face_index_observer& obs,*/ Mesh &source_mesh);
+void buildArrangementFromMesh(Arrangement_2& arr, const std::vector<Point_2>& vertices, Mesh& mesh);
 int findTarget(const Landmarks_pl& target, const EPoint_2& point, int& type, Arrangement_2::Face_const_handle& targetFace);
+int findTarget(const PointLocator& target, const EPoint_2& point, int& type, int& targetFace);
 ARRNumberType crossProduct ( EVector_2 v1 , EVector_2 v2 );
 void barycentricCord( const std::vector<EPoint_2>& points, EPoint_2 point, ARRTraits_2::Point_3 &res );
 EPoint_2 reverseBarycentric ( const std::vector<EPoint_2>& points, ARRTraits_2::Point_3 bar );
+void barycentricCordFiltered(const std::vector<EPoint_2>& points, const EPoint_2& point, double res[3]);
+Point_3 barycentricCombination(Mesh& targetMesh, const std::vector<int>& indices, const double bar[3]);
+Point_2 mapThroughTriangle(double x, double y, const double triangle[6], const double image[6]);
 void updateMeshUV( Mesh& mesh, int index , Mesh::Point_3 point );
-std::vector<int> updateUVs(Mesh& sourceMesh, Mesh& targetMesh, const Arrangement_2& source, const Arrangement_2& target, const Landmarks_pl& sourceLandMark, const Landmarks_pl& targetLandMark, /*Face_index_observer& sourceObs, Face_index_observer& targetObs,*/ std::vector<EPoint_2>& sourceHarmonicMapPoints, std::vector<int>& fVec, std::vector<Point_3>& uvVector);
+std::vector<int> updateUVs(Mesh& sourceMesh, Mesh& targetMesh, const PointLocator& targetLocator, std::vector<Point_2>& sourceHarmonicMapPoints, std::vector<int>& fVec, std::vector<Point_3>& uvVector);
 void setBoundaryUV( Mesh &source_mesh, Mesh &target_mesh, std::vector<Point_3>& uvVector );
+void setBoundaryUV( IndexMesh &source, const IndexMesh &target, std::vector<Point_3>& uvVector );
 
-void matchPointsIndices(Arrangement_2& arrSource, const std::vector<EPoint_2>& sourceHarmonicMapPoints, const Landmarks_pl& sourceLandMark, Mesh& sourceMesh);
+void matchPointsIndices(Arrangement_2& arrSource, const std::vector<Point_2>& sourceHarmonicMapPoints, const Landmarks_pl& sourceLandMark, Mesh& sourceMesh);
 void matchEdges(Arrangement_2& arr, Mesh& source_mesh);
-void matchFaces(Arrangement_2& arr, const std::vector<EPoint_2>& mapPoints, const std::vector<int> &fVec, Landmarks_pl& trap, Mesh& sourceMesh);
-
-int refine(std::vector<int>& neg, Mesh& sourceMesh, Mesh& targetMesh, Arrangement_2& source, Arrangement_2& target, const Landmarks_pl& sourceLandMark, const Landmarks_pl& targetLandMark, /*Face_index_observer& targetObs,*/ std::vector<EPoint_2>& sourceHarmonicMapPoints, std::vector<Kernel::Point_3> &pVec, std::vector<int>& fVec, std::vector<Point_3>& uvVector);
-void findIntersection(Arrangement_2& target, const Landmarks_pl& targetLandMark, ESegment_2 seg, std::vector<EPoint_2>& intersectionPoints);
-void inverseList(std::vector<EPoint_2>& intersectionPoints);
-Point_3 calcNewUV(EPoint_2 tempP, Mesh& targetMesh, const Landmarks_pl& targetLandMark, /*Face_index_observer& targetObs,*/ std::vector<Point_3>& uvVector);
-Point_3 calcNewMeshPoint(EPoint_2 tempP, int faceIndex, std::vector<EPoint_2>& sourceHarmonicMapPoints, std::vector<Kernel::Point_3> &pVec, std::vector<int>& fVec);
-void extractIndicesFromPair(Pair& p, PointMap& pMap, std::vector<int>& polygonIndices, std::map<Point_3, int>& newUVtoIndicesMap);
-void extractIndicesFromPair(Pair& e1, Pair& e2, Pair& e3, PointMap& pMap, std::vector<int>& polygonIndices, std::map<Point_3, int>& newUVtoIndicesMap);
+void matchFaces(Arrangement_2& arr, const std::vector<Point_2>& mapPoints, const std::vector<int> &fVec, Landmarks_pl& trap, Mesh& sourceMesh);
 
+int refine(std::vector<int>& neg, Mesh& sourceMesh, Mesh& targetMesh, const PointLocator& targetLocator, std::vector<Point_2>& sourceHarmonicMapPoints, std::vector<Kernel::Point_3> &pVec, std::vector<int>& fVec, std::vector<Point_3>& uvVector);
+Point_3 calcNewUV(EPoint_2 tempP, Mesh& targetMesh, const PointLocator& targetLocator);
+Point_3 calcNewMeshPoint(EPoint_2 tempP, int faceIndex, std::vector<Point_2>& sourceHarmonicMapPoints, std::vector<Kernel::Point_3> &pVec, std::vector<int>& fVec);
 void extractIndicesFromPair(Pair& p, PointMap& pMap, std::vector<int>& polygonIndices);
 void extractIndicesFromPair(Pair& e1, Pair& e2, Pair& e3, PointMap& pMap, std::vector<int>& polygonIndices);
 
 void triangulateNewPolygon(std::vector<int>& polygonIndices, std::vector<Point_3>& uvVector, std::vector<int>& fVec);
 
-void findNegativeNeighbors(std::vector<int>& neg, std::vector<EPoint_2>& sourceHarmonicMapPoints, std::vector<int>& fVec, Arrangement_2& source, const Landmarks_pl& sourceLandMark);
-void triangulateNeighbors(std::vector<int>& neighTri, std::vector<int>& fVec, std::vector<EPoint_2>& sourceHarmonicMapPoints, PointMap& pMap, std::vector<Point_3>& uvVector);
-bool triangulateNewPolygon(std::vector<int>& polygonIndices, std::vector<EPoint_2>& sourceHarmonicMapPoints, std::vector<int>& fVec, PointMap& pMap, std::vector<Point_3>& uvVector);
+void findNegativeNeighbors(std::vector<int>& neg, std::vector<Point_2>& sourceHarmonicMapPoints, std::vector<int>& fVec, Arrangement_2& source, const Landmarks_pl& sourceLandMark);
+void triangulateNeighbors(std::vector<int>& neighTri, std::vector<int>& fVec, std::vector<Point_2>& sourceHarmonicMapPoints, PointMap& pMap, std::vector<Point_3>& uvVector);
+bool triangulateNewPolygon(std::vector<int>& polygonIndices, std::vector<Point_2>& sourceHarmonicMapPoints, std::vector<int>& fVec, PointMap& pMap, std::vector<Point_3>& uvVector);
 
-bool checkIfBoundaryEdge(ESegment_2& seg, const Landmarks_pl& sourceLandMark);
+bool checkIfBoundaryEdge(int triIndex, int edge, const FaceAdjacency& sourceAdjacency);
 
-void refineTriangle(int triIndex, std::vector<int>& fVec, std::vector<EPoint_2>& sourceHarmonicMapPoints, PointMap& pMap, std::vector<Point_3>& uvVector, Mesh& targetMesh, Arrangement_2& target, const Landmarks_pl& targetLandMark, const Landmarks_pl& sourceLandMark, /*Face_index_observer& targetObs,*/ std::vector<Kernel::Point_3> &pVec, int& updatedNumOfPoints);
-void findTriangleNeighbors(int triIndex, std::vector<int>& fVec, std::vector<EPoint_2>& sourceHarmonicMapPoints, const Landmarks_pl& sourceLandMark, std::vector<int>& neighTri, std::vector<bool>& inTheList);
-bool triangulateNeighbor(int triIndex, std::vector<int>& fVec, std::vector<EPoint_2>& sourceHarmonicMapPoints, PointMap& pMap, std::vector<Point_3>& uvVector, std::map<Point_3, int>& newUVtoIndicesMap);
+void refineTriangle(int triIndex, std::vector<int>& fVec, std::vector<Point_2>& sourceHarmonicMapPoints, PointMap& pMap, Mesh& targetMesh, const FaceAdjacency& sourceAdjacency, const PointLocator& targetLocator, std::vector<Kernel::Point_3> &pVec);
+void findTriangleNeighbors(int triIndex, std::vector<int>& fVec, std::vector<Point_2>& sourceHarmonicMapPoints, const FaceAdjacency& sourceAdjacency, std::vector<int>& neighTri, std::vector<bool>& inTheList);
+bool triangulateNeighbor(int triIndex, std::vector<int>& fVec, std::vector<Point_2>& sourceHarmonicMapPoints, PointMap& pMap, std::vector<Point_3>& uvVector, std::vector<int>& newFaces);
 
 bool checkIfSimple(int triIndex, std::vector<int>& fVec, PointMap& pMap, std::vector<Point_3>& uvVector);
 
@@ -1,46 +1,122 @@
 #include "stdafx.h"
 
-void run();
+void run(HarmonicSolverCache& solverCache);
+void mapToTarget(Mesh& source_mesh, std::vector<Kernel::Point_3>& pVec, std::vector<int>& fVec, const MeshReordering& sourceOrder,
+	const std::string& targetSpecFile, const std::string& outputMesh, HarmonicSolverCache& solverCache, ofstream& logFile);
 const std::string currentDateTime();
 
-void main()
+int main(int argc, char* argv[])
 {
+	if (!RunOptions::Get().parse(argc, argv))
+		return 1;
+	if (RunOptions::Get().nativeWorkspace)
+		NativeWorkspace::Get().activate();
+
+	if (!RunOptions::Get().convertCache.empty())
+	{
+		std::string error;
+		if (!MeshCache::convert(RunOptions::Get().convertObj, RunOptions::Get().convertCache, error))
+		{
+			std::cerr << "Could not convert " << RunOptions::Get().convertObj << ": " << error << "\n";
+			return 1;
+		}
+		std::cout << "Wrote " << RunOptions::Get().convertCache << "\n";
+		return 0;
+	}
+
 	//std::ofstream out("log.txt");
 	//std::streambuf *coutbuf = std::cout.rdbuf(); //save old buf
 	//std::cout.rdbuf(out.rdbuf()); //redirect std::cout to out.txt!
 	std::cout << "****************\nProgram start at: " << currentDateTime() <<"\n";
-	run();
+	//the solver setups live as long as the process, so the systems of every target of the run can reuse them
+	HarmonicSolverCache solverCache;
+	run(solverCache);
+	VisualizationSink::Get().finish();
 	std::cout << "****************";
+	return 0;
 }
 
-void run()
+void run(HarmonicSolverCache& solverCache)
 {
 	ofstream logFile;
 	logFile.open("log.txt");
-	double sumTime = 0;
 	std::vector<Kernel::Point_3> pVec;
 	std::vector<int> fVec;
 	Mesh source_mesh;
-	loadSourceMesh( source_mesh ,pVec , fVec);
+	MeshReordering sourceOrder;
+	if (!loadSourceMesh( source_mesh ,pVec , fVec , sourceOrder))
+		return;
 
 	logFile << "Mesh loaded successfully.\n# of vertices: " << pVec.size() << "\n# of faces: " << fVec.size()/3 << "\n\n" ;
 
+	//the source is loaded once. every target gets copies of its points and faces, which the refinement appends to.
+	const RunOptions& options = RunOptions::Get();
+	int numTargets = (int)(std::max)(options.targetSpecs.size(), (size_t)1);
+	for (int t = 0; t < numTargets; ++t)
+	{
+		std::string targetSpecFile = options.targetSpecs.empty() ? std::string() : options.targetSpecs[t];
+		std::string outputMesh = options.outputMeshes.empty() ? std::string() : options.outputMeshes[t];
+		if (numTargets > 1)
+		{
+			std::cout << "****************\nTarget " << t + 1 << " of " << numTargets << ": " << targetSpecFile << "\n";
+			logFile << "\n****************\nTarget " << t + 1 << " of " << numTargets << ": " << targetSpecFile << "\n";
+		}
+
+		std::vector<Kernel::Point_3> targetPVec(pVec);
+		std::vector<int> targetFVec(fVec);
+		int numHits = solverCache.numHits(), numMisses = solverCache.numMisses();
+		mapToTarget(source_mesh, targetPVec, targetFVec, sourceOrder, targetSpecFile, outputMesh, solverCache, logFile);
+
+		std::cout << "Solver cache: " << solverCache.numHits() - numHits << " setups reused, " << solverCache.numMisses() - numMisses << " analyzed\n";
+		logFile << "Solver cache: " << solverCache.numHits() - numHits << " setups reused, " << solverCache.numMisses() - numMisses << " analyzed\n";
+	}
+	logFile.close();
+}
+
+//maps the loaded source to one target. pVec and fVec are the source lists, the refinement appends to them.
+void mapToTarget(Mesh& source_mesh, std::vector<Kernel::Point_3>& pVec, std::vector<int>& fVec, const MeshReordering& sourceOrder,
+	const std::string& targetSpecFile, const std::string& outputMesh, HarmonicSolverCache& solverCache, ofstream& logFile)
+{
+	double sumTime = 0;
 	std::vector<Mesh::Halfedge_iterator> border;
 	source_mesh.getBorderHalfEdges( border );
 	int numOfBorder = (int)border.size();
 
-	//--------------get data from matlab about the target polygon-----------
-	MatlabInterface::GetEngine().Eval("nis2");
-	GMMDenseColMatrix target_size;
-	MatlabGMMDataExchange::GetEngineDenseMatrix("n_bSize" , target_size);
-	GMMDenseColMatrix targetVertices((int)target_size(0, 0), 2), rotIndices(1, (int)target_size(0, 0));
-	MatlabGMMDataExchange::GetEngineDenseMatrix("n_b" , targetVertices);
-	MatlabGMMDataExchange::GetEngineDenseMatrix("rotIndices", rotIndices);
+	//--------------get data about the target polygon, from the target spec or from matlab-----------
+	TargetSpec targetSpec;
+	Polygon_2 poly,bPoly;
+	std::vector<int> rotIndices;
+	if (!targetSpecFile.empty())
+	{
+		std::string error;
+		if (!targetSpec.load(targetSpecFile, error))
+		{
+			std::cout << "Error: " << error << "\n";
+			logFile << "Error: " << error << "\n";
+			return;
+		}
+		targetSpec.getPolygon(poly);
+		targetSpec.getRotationIndices(rotIndices);
+	}
+	else
+	{
+		MatlabInterface::GetEngine().Eval("nis2");
+		GMMDenseColMatrix target_size;
+		MatlabGMMDataExchange::GetEngineDenseMatrix("n_bSize" , target_size);
+		GMMDenseColMatrix targetVertices((int)target_size(0, 0), 2), targetRotIndices(1, (int)target_size(0, 0));
+		MatlabGMMDataExchange::GetEngineDenseMatrix("n_b" , targetVertices);
+		MatlabGMMDataExchange::GetEngineDenseMatrix("rotIndices", targetRotIndices);
+		for ( int i = 0; i < target_size(0,0); ++i )
+		{
+			poly.push_back( Point_2( targetVertices(i,0) , targetVertices(i,1) ) );
+			rotIndices.push_back( (int)targetRotIndices(0, i) );
+		}
+	}
 
 	// set full rotation indices array
-	int *rArr = new int[(int)target_size(0, 0)];
-	for (int i = 0; i < (int)target_size(0, 0); ++i)
-		rArr[i] = rotIndices(0, i);
+	int *rArr = new int[rotIndices.size()];
+	for (int i = 0; i < (int)rotIndices.size(); ++i)
+		rArr[i] = rotIndices[i];
 	
 	// calculate avg length of source edges on border
 	double avg_arc = 0;
@@ -50,11 +126,6 @@ void run()
 	
 	avg_arc = avg_arc / numOfBorder;
 	//----------------------------------------------------------------------------------------------------------------------
-	Polygon_2 poly,bPoly;
-
-	for ( int i = 0; i < target_size(0,0); ++i )
-		poly.push_back( Point_2( targetVertices(i,0) , targetVertices(i,1) ) );
-
 	bPoly = poly;
 	addPointsToTarget( bPoly , numOfBorder , avg_arc );
 
@@ -83,7 +154,6 @@ void run()
 	{
 		std::cout << "Error: the target polygon is not self-overlapping polygon! \n";
 		logFile << "Error: the target polygon is not self-overlapping polygon! \nIf you think it's indeed SOP, try to choose the 'reverse boundary orientation' option, or change the rotation indices.\n";
-		logFile.close();
 		return;		
 	}
 
@@ -94,11 +164,16 @@ void run()
 	//if we got here that means the target mesh is set
 	//***********************************************
 
-	MatlabInterface::GetEngine().Eval("nis3");
-	GMMDenseColMatrix weightsSelect(1, 2);
-	MatlabGMMDataExchange::GetEngineDenseMatrix("weightsSelect", weightsSelect);
-	bool isSourceHarmonic = weightsSelect(0, 0) == 1;
-	bool isTargetHarmonic = weightsSelect(0, 1) == 1;
+	bool isSourceHarmonic = targetSpec.isSourceHarmonic();
+	bool isTargetHarmonic = targetSpec.isTargetHarmonic();
+	if (targetSpecFile.empty())
+	{
+		MatlabInterface::GetEngine().Eval("nis3");
+		GMMDenseColMatrix weightsSelect(1, 2);
+		MatlabGMMDataExchange::GetEngineDenseMatrix("weightsSelect", weightsSelect);
+		isSourceHarmonic = weightsSelect(0, 0) == 1;
+		isTargetHarmonic = weightsSelect(0, 1) == 1;
+	}
 
 	int sourceMeshSize = source_mesh.size_of_vertices();
 	int targetMeshSize = shor.target_mesh.size_of_vertices();
@@ -108,49 +183,71 @@ void run()
 	std::cout << "Mapping source and target meshes to the unit disk... \n";
 	CGAL::Timer harmonicTimer;
 	harmonicTimer.start();
-	HarmonicFlattening(source_mesh, uSource, weightsMatSource, isSourceHarmonic);
-	HarmonicFlattening(shor.target_mesh, uTarget, weightsMatTarget, isTargetHarmonic);
+	IndexMesh sourceIndexMesh, targetIndexMesh;
+	sourceIndexMesh.assign(source_mesh);
+	targetIndexMesh.assign(shor.target_mesh);
+	HarmonicFlattening(sourceIndexMesh, uSource, weightsMatSource, isSourceHarmonic);
+	HarmonicFlattening(targetIndexMesh, uTarget, weightsMatTarget, isTargetHarmonic);
 	//meanValueWeights(source_mesh, uSource, weightsMatSource);
 	//meanValueWeights(shor.target_mesh, uTarget, weightsMatTarget);
 	harmonicTimer.stop();
 	std::cout << "Done!\n";
 	
-	MatlabGMMDataExchange::SetEngineSparseMatrix( "uSource" , uSource );
-	MatlabGMMDataExchange::SetEngineSparseMatrix( "weightsMatSource" , weightsMatSource );
-	MatlabGMMDataExchange::SetEngineSparseMatrix( "uTarget" , uTarget );
-	MatlabGMMDataExchange::SetEngineSparseMatrix( "weightsMatTarget" , weightsMatTarget );
-	MatlabInterface::GetEngine().Eval("nis4");
-	//*************************************************
 	GMMDenseColMatrix sTime(1, 1), tTime(1, 1);
 	GMMDenseColMatrix sourceMap(sourceMeshSize, 2), targetMap(targetMeshSize, 2);
-	MatlabGMMDataExchange::GetEngineDenseMatrix("outSource", sourceMap);
-	MatlabGMMDataExchange::GetEngineDenseMatrix("outTarget", targetMap);
-	MatlabGMMDataExchange::GetEngineDenseMatrix("sTime", sTime);
-	MatlabGMMDataExchange::GetEngineDenseMatrix("tTime", tTime);
+	if (RunOptions::Get().nativeSolver)
+	{
+		std::cout << "Solving the disk maps...\n";
+		CGAL::Timer solveTimer;
+		solveTimer.start();
+		solveHarmonicMap(weightsMatSource, uSource, fVec, sourceMap, RunOptions::Get().solver, solverCache);
+		sTime(0, 0) = solveTimer.time();
+		solveTimer.reset();
+		solveHarmonicMap(weightsMatTarget, uTarget, shor.fVec, targetMap, RunOptions::Get().solver, solverCache);
+		tTime(0, 0) = solveTimer.time();
+		solveTimer.stop();
+		std::cout << "Done!\n";
+	}
+	else
+	{
+		MatlabGMMDataExchange::SetEngineSparseMatrix( "uSource" , uSource );
+		MatlabGMMDataExchange::SetEngineSparseMatrix( "weightsMatSource" , weightsMatSource );
+		MatlabGMMDataExchange::SetEngineSparseMatrix( "uTarget" , uTarget );
+		MatlabGMMDataExchange::SetEngineSparseMatrix( "weightsMatTarget" , weightsMatTarget );
+		NativeWorkspace::Get().setSolverCache(&solverCache);
+		MatlabInterface::GetEngine().Eval("nis4");
+		NativeWorkspace::Get().setSolverCache(NULL);
+		//*************************************************
+		MatlabGMMDataExchange::GetEngineDenseMatrix("outSource", sourceMap);
+		MatlabGMMDataExchange::GetEngineDenseMatrix("outTarget", targetMap);
+		MatlabGMMDataExchange::GetEngineDenseMatrix("sTime", sTime);
+		MatlabGMMDataExchange::GetEngineDenseMatrix("tTime", tTime);
+	}
 	std::cout << "Total time to construct the 2 harmonic maps: " << harmonicTimer.time() + sTime(0, 0) + tTime(0, 0) << " seconds\n";
 	logFile << "Total time to construct the 2 harmonic maps (to the unit disk): " << harmonicTimer.time() + sTime(0, 0) + tTime(0, 0) << " seconds\n";
 	sumTime += harmonicTimer.time() + sTime(0, 0) + tTime(0, 0);
 
-	Arrangement_2 arrSource,arrTarget;
-	Landmarks_pl sourceLm,targetLm;
+	DiskLocator targetLocator;
 	//Face_index_observer sourceObs(arrSource),targetObs(arrTarget);
 
-	std::vector<EPoint_2> sourceHarmonicMapPoints,targetHarmonicMapPoints;
+	//the harmonic maps are kept as doubles, exact points are made only where a construction needs them
+	std::vector<Point_2> sourceHarmonicMapPoints,targetHarmonicMapPoints;
 	sourceHarmonicMapPoints.resize(sourceMeshSize);
 	targetHarmonicMapPoints.resize(targetMeshSize);
 	for (int i = 0; i < sourceMeshSize; ++i)
 	{
-		sourceHarmonicMapPoints[i] = EPoint_2(sourceMap(i, 0), sourceMap(i, 1));
+		sourceHarmonicMapPoints[i] = Point_2(sourceMap(i, 0), sourceMap(i, 1));
 		//std::cout << "(" << sourceHarmonicMapPoints[i].x() << "," << sourceHarmonicMapPoints[i].y() << ")\n";
 	}
 	for ( int i = 0; i < targetMeshSize; ++i )
-		targetHarmonicMapPoints[i] = EPoint_2(targetMap(i,0),targetMap(i,1)) ;
+		targetHarmonicMapPoints[i] = Point_2(targetMap(i,0),targetMap(i,1)) ;
 
 	auto vItSource = source_mesh.vertices_begin();
 	while (vItSource != source_mesh.vertices_end())
 	{
 		int i = vItSource->index();
 		vItSource->uv() = Point_3(sourceMap(i, 0) , sourceMap(i, 1) , 0);
+		sourceIndexMesh.uv(i) = vItSource->uv();
 		vItSource++;
 	}
 	auto vItTarget = shor.target_mesh.vertices_begin();
@@ -158,17 +255,26 @@ void run()
 	{
 		int i = vItTarget->index();
 		vItTarget->uv() = Point_3(targetMap(i, 0), targetMap(i, 1), 0);
+		targetIndexMesh.uv(i) = vItTarget->uv();
 		vItTarget++;
 	}
 
 
 	CGAL::Timer arrangementBuildTimer;
 	arrangementBuildTimer.start();
-	BuildArrangement ( arrSource , sourceLm , sourceHarmonicMapPoints , fVec , /*sourceObs ,*/ source_mesh);
-	BuildArrangement ( arrTarget , targetLm , targetHarmonicMapPoints , shor.fVec , /*targetObs ,*/ shor.target_mesh);
+	targetLocator.build(targetHarmonicMapPoints, shor.fVec);
+	PointLocator* targetPointLocator = PointLocator::create(RunOptions::Get().locator, targetLocator, shor.target_mesh);
+	if (targetPointLocator == NULL)
+	{
+		std::cout << "Unknown point location policy: " << RunOptions::Get().locator << ", using walk\n";
+		targetPointLocator = new WalkLocator(targetLocator);
+	}
+	targetPointLocator->build();
+	RecordingLocator targetRecorder(*targetPointLocator);
+	const PointLocator& targetQueries = RunOptions::Get().benchmarkLocators ? (const PointLocator&)targetRecorder : *targetPointLocator;
 	arrangementBuildTimer.stop();
-	std::cout << "Total time to build the CGAL Arrangements: " << arrangementBuildTimer.time() << " seconds\n";
-	logFile << "Total time to build the CGAL Arrangements: " << arrangementBuildTimer.time() << " seconds\n";
+	std::cout << "Total time to build the point location structures: " << arrangementBuildTimer.time() << " seconds\n";
+	logFile << "Total time to build the point location structures: " << arrangementBuildTimer.time() << " seconds\n";
 	sumTime += arrangementBuildTimer.time();
 	//matchPointsIndices( arrSource , sourceMap );
 	//matchPointsIndices( arrTarget , targetMap );
@@ -178,19 +284,45 @@ void run()
 
 	std::vector<Point_3> uvVector;
 	uvVector.resize(sourceMeshSize);
-	setBoundaryUV(source_mesh, shor.target_mesh, uvVector);
+	setBoundaryUV(sourceIndexMesh, targetIndexMesh, uvVector);
 	std::cout << "Calculating new UV's... \n";
-	std::vector<int> neg = updateUVs(source_mesh, shor.target_mesh, arrSource, arrTarget, sourceLm, targetLm, /*sourceObs, targetObs,*/ sourceHarmonicMapPoints, fVec, uvVector);
+	std::vector<int> neg = updateUVs(source_mesh, shor.target_mesh, targetQueries, sourceHarmonicMapPoints, fVec, uvVector);
 	std::cout << "Done!\n";
 
-	int aa = refine(neg, source_mesh, shor.target_mesh, arrSource, arrTarget, sourceLm, targetLm, /*targetObs,*/ sourceHarmonicMapPoints, pVec, fVec, uvVector);
+	int aa = refine(neg, source_mesh, shor.target_mesh, targetQueries, sourceHarmonicMapPoints, pVec, fVec, uvVector);
 	
 	buildMapTimer.stop();
 	std::cout << "Total time of composition and refinement: " << buildMapTimer.time() << " seconds\n";
 	logFile << "Total time of composition and refinement: " << buildMapTimer.time() << " seconds\n";
 	sumTime += buildMapTimer.time();
 	logFile << "\n# of new points: " << aa << "\n\nTotal run time: " << sumTime <<"\n";
-	
+
+	if (RunOptions::Get().benchmarkLocators)
+	{
+		std::ostringstream report;
+		benchmarkPointLocators(targetRecorder.queries(), targetLocator, shor.target_mesh, report);
+		std::cout << report.str();
+		logFile << report.str();
+	}
+	delete targetPointLocator;
+
+	//back to the order of the source file. the vertices and faces of the refinement stay behind the others.
+	sourceOrder.restore(pVec);
+	sourceOrder.restore(uvVector);
+	sourceOrder.restoreFaces(fVec);
+
+	if (!outputMesh.empty())
+	{
+		CGAL::Timer writeTimer;
+		writeTimer.start();
+		std::string error;
+		if (writeParametrizedMesh(outputMesh, pVec, uvVector, fVec, error))
+			logFile << "Wrote " << outputMesh << " in " << writeTimer.time() << " seconds\n";
+		else
+			std::cerr << "Error: " << error << "\n";
+		delete[] rArr;
+		return;
+	}
 
 	GMMDenseColMatrix finalOut(uvVector.size(), 2);
 	//auto it = source_mesh.vertices_begin();
@@ -236,14 +368,16 @@ void run()
 		finalPvec(i, 2) = pVec[i].z();
 	}
 
-	MatlabGMMDataExchange::SetEngineDenseMatrix( "finalOut" , finalOut );
-	MatlabGMMDataExchange::SetEngineDenseMatrix("finalFvec", finalFvec);
-	MatlabGMMDataExchange::SetEngineDenseMatrix("finalPvec", finalPvec);
-	MatlabInterface::GetEngine().Eval("finalFvec = finalFvec +1");
-	MatlabInterface::GetEngine().Eval("resMap");
+	//shown at the next engine call or by finish, the results are never dropped
+	VisualizationFrame resultFrame;
+	resultFrame.add("finalOut", finalOut);
+	resultFrame.add("finalFvec", finalFvec);
+	resultFrame.add("finalPvec", finalPvec);
+	resultFrame.command = "finalFvec = finalFvec +1;resMap";
+	resultFrame.isDroppable = false;
+	VisualizationSink::Get().post(resultFrame);
 
 	delete[] rArr;
-	logFile.close();
 }
 
 
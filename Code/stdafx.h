@@ -5,11 +5,15 @@
 #include <CGAL/Timer.h>
 #include <CGAL/Polygon_2.h>
 #include <CGAL/Exact_predicates_inexact_constructions_kernel.h>
+#include <CGAL/MP_Float.h>
+#include <CGAL/Quotient.h>
 #include <CGAL/enum.h>
 #include <CGAL/Exact_predicates_exact_constructions_kernel.h>
 #include <CGAL/Arrangement_2.h>
 #include <CGAL/Arr_segment_traits_2.h>
 #include <CGAL/Arr_landmarks_point_location.h>
+#include <CGAL/Arr_trapezoid_ric_point_location.h>
+#include <CGAL/Arr_walk_along_line_point_location.h>
 #include <CGAL/Arr_extended_dcel.h>
 #include <CGAL/Arr_default_overlay_traits.h>
 #include <CGAL/Gmpq.h>
@@ -23,6 +27,8 @@
 #include <CGAL/HalfedgeDS_halfedge_base.h>
 #include <CGAL/Polyhedron_3.h>
 #include <CGAL/Polyhedron_incremental_builder_3.h>
+#include <CGAL/HalfedgeDS_decorator.h>
+#include <unordered_map>
 #include "CGAL_Vertex.h"
 #include "CGAL_Halfedge.h"
 #include "CGAL_Face.h"
@@ -40,6 +46,9 @@ typedef Kernel::Vector_2 Vector_2;
 typedef CGAL::Polygon_2<Kernel>    Polygon_2;//Contour;
 typedef CGAL::Triangle_2<Kernel> Triangle_2;
 
+typedef CGAL::Exact_predicates_inexact_constructions_kernel		IKernel;	//exact predicates on doubles, safe to use from several threads
+typedef CGAL::Quotient<CGAL::MP_Float>							MPNumberType;
+
 typedef CGAL::Polyhedron_3<Kernel>		pHedron;
 typedef pHedron::HalfedgeDS				HDS;
 
@@ -69,21 +78,39 @@ typedef CGAL::Polygon_2<ARRKernel>								EPolygon_2;
 #include "gmm/gmm.h"
 #include "MatlabGMMDataExchange.h"
 #include "MatlabInterface.h"
+#include "NativeWorkspace.h"
+#include "VisualizationSink.h"
 #include "GMM_Macros.h"
 
 #include "Angle.h"
 #include "Shor.h"
+#include "HarmonicSolver.h"
+#include "FaceAdjacency.h"
+#include "IndexMesh.h"
+#include "MeshReordering.h"
+#include "DiskLocator.h"
+#include "RunOptions.h"
+#include "TargetSpec.h"
 
 
 #include "wavefront_obj.h"
+#include "MappedFile.h"
+#include "MeshCache.h"
+#include "MeshWriter.h"
 
 
 // general include 
 #include <iostream>
 using namespace std;
 #include <string>
+#include <sstream>
 #include <map>
+#include <queue>
+#include <unordered_map>
+#include <limits>
+#ifdef _WIN32
 #include <windows.h>
+#endif
 #include <vector>
 #include <complex>
 
@@ -96,5 +123,6 @@ extern "C"
 }
 
 #include "helpFunctions.h"
+#include "PointLocator.h"
 
 #include <CGAL/Sweep_line_2_algorithms.h>
\ No newline at end of file
@@ -55,11 +55,11 @@ bool triangulatePolygon(const std::vector<std::complex<double> >& polygonPoints,
 	
 	if(subsampleBoundaryEdges)
 	{
-		sprintf_s(refine_switchesAC, 64, "Qpzq%da%lf", minAngle, maxTriangleArea);		
+		snprintf(refine_switchesAC, 64, "Qpzq%da%lf", minAngle, maxTriangleArea);		
 	}
 	else
 	{
-		sprintf_s(refine_switchesAC, 64, "YQpzq%da%lf", minAngle, maxTriangleArea);
+		snprintf(refine_switchesAC, 64, "YQpzq%da%lf", minAngle, maxTriangleArea);
 	}
 
 	triangulate(refine_switchesAC, &in, &out, NULL);
@@ -1,9 +1,25 @@
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
 #include <assert.h>
+#if defined(__has_include)
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
+#endif
 
-#include "Wavefront_obj.h"
+#include "wavefront_obj.h"
+#include "MappedFile.h"
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifdef _WIN32
+//the legacy loader uses the wide string open and sscanf_s of MSVC
 bool Wavefront_obj::load_file(std::wstring filename)
 {
 	char line[8192];
@@ -138,3 +154,356 @@ bool Wavefront_obj::load_file(std::wstring filename)
 
 	return true;
 }
+#endif
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Wavefront_obj::load
+//////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+enum ObjLineType { OBJ_POINT = 0, OBJ_TEXTURE = 1, OBJ_NORMAL = 2, OBJ_FACE = 3, OBJ_OTHER = 4 };
+
+//a newline aligned part of the file
+struct ObjChunk
+{
+	const char* begin;
+	const char* end;
+	int firstLine;			//1-based
+	int numLines;
+	int count[4];			//lines of every type
+	int offset[4];			//index of the first element of every type
+	std::string error;		//the first error in the chunk
+};
+
+static inline bool isBlank(char c)
+{
+	return (c == ' ' || c == '\t');
+}
+
+static ObjLineType objLineType(const char* p, const char* end)
+{
+	if (p == end)
+		return OBJ_OTHER;
+	if (p[0] == 'f')
+		return (end - p > 1 && isBlank(p[1])) ? OBJ_FACE : OBJ_OTHER;
+	if (p[0] != 'v')
+		return OBJ_OTHER;
+	if (end - p > 1 && isBlank(p[1]))
+		return OBJ_POINT;
+	if (end - p > 2 && isBlank(p[2]))
+	{
+		if (p[1] == 't')
+			return OBJ_TEXTURE;
+		if (p[1] == 'n')
+			return OBJ_NORMAL;
+	}
+	return OBJ_OTHER;
+}
+
+static bool parseDouble(const char*& p, const char* end, double& value)
+{
+	while (p != end && isBlank(*p))
+		p++;
+	if (p != end && *p == '+')
+		p++;
+	if (p == end)
+		return false;
+#if defined(__cpp_lib_to_chars)
+	std::from_chars_result result = std::from_chars(p, end, value);
+	if (result.ec != std::errc())
+		return false;
+	p = result.ptr;
+	return true;
+#else
+	//the mapped text is not null terminated
+	char token[64];
+	int length = 0;
+	while (p + length != end && length < 63 && !isBlank(p[length]) && p[length] != '/')
+	{
+		token[length] = p[length];
+		length++;
+	}
+	token[length] = '\0';
+	char* tokenEnd;
+	value = strtod(token, &tokenEnd);
+	if (tokenEnd == token)
+		return false;
+	p += tokenEnd - token;
+	return true;
+#endif
+}
+
+static bool parseInt(const char*& p, const char* end, int& value)
+{
+	bool isNegative = false;
+	if (p != end && (*p == '-' || *p == '+'))
+		isNegative = (*p++ == '-');
+	if (p == end || *p < '0' || *p > '9')
+		return false;
+	long long v = 0;
+	while (p != end && *p >= '0' && *p <= '9' && v <= 0x7fffffff)
+		v = 10 * v + (*p++ - '0');
+	if (v > 0x7fffffff)
+		return false;
+	value = (int)(isNegative ? -v : v);
+	return true;
+}
+
+//an obj index to a 0-based index, given the number of elements defined before the line. false if it is out of range.
+static bool resolveIndex(int& index, int numBefore, int numTotal)
+{
+	if (index > 0)
+		index--;
+	else if (index < 0)
+		index += numBefore;
+	else
+		return false;
+	return (index >= 0 && index < numTotal);
+}
+
+static std::string lineError(int line, const std::string& message)
+{
+	std::ostringstream out;
+	out << "line " << line << ": " << message;
+	return out.str();
+}
+
+//parses the face at p. the v, t and n indices which are missing are -1.
+static bool parseFace(const char* p, const char* end, const int numBefore[3], const int numTotal[3], Wavefront_obj::Face& f, std::string& error)
+{
+	int numCorners = 0;
+	for (;;)
+	{
+		while (p != end && isBlank(*p))
+			p++;
+		if (p == end)
+			break;
+		if (numCorners == 3)
+		{
+			error = "only triangles are supported";
+			return false;
+		}
+
+		int index[3] = { 0, 0, 0 }; //v, t, n
+		if (!parseInt(p, end, index[0]))
+		{
+			error = "bad vertex index";
+			return false;
+		}
+		if (p != end && *p == '/')
+		{
+			p++;
+			if (p != end && *p != '/' && !parseInt(p, end, index[1]))
+			{
+				error = "bad texture coordinate index";
+				return false;
+			}
+			if (p != end && *p == '/')
+			{
+				p++;
+				if (!parseInt(p, end, index[2]))
+				{
+					error = "bad normal index";
+					return false;
+				}
+			}
+		}
+		if (p != end && !isBlank(*p))
+		{
+			error = "bad face vertex";
+			return false;
+		}
+
+		static const char* names[3] = { "vertex", "texture coordinate", "normal" };
+		for (int k = 0; k < 3; ++k)
+		{
+			if (k > 0 && index[k] == 0)
+				index[k] = -1;	//missing
+			else if (!resolveIndex(index[k], numBefore[k], numTotal[k]))
+			{
+				error = std::string(names[k]) + " index out of range";
+				return false;
+			}
+		}
+		f.v[numCorners] = index[0];
+		f.t[numCorners] = index[1];
+		f.n[numCorners] = index[2];
+		numCorners++;
+	}
+	if (numCorners < 3)
+	{
+		error = "a face needs 3 vertices";
+		return false;
+	}
+	return true;
+}
+
+//calls visit(type, lineBegin, lineEnd, lineNumber) for every line of the chunk, until it returns false
+template <class Visitor>
+static void forEachLine(const ObjChunk& chunk, Visitor& visit)
+{
+	const char* p = chunk.begin;
+	int line = chunk.firstLine;
+	while (p != chunk.end)
+	{
+		const char* next = (const char*)memchr(p, '\n', chunk.end - p);
+		const char* lineEnd = (next == NULL) ? chunk.end : next;
+		const char* contentEnd = lineEnd;
+		if (contentEnd != p && contentEnd[-1] == '\r')
+			contentEnd--;
+		//the keyword may be indented
+		const char* content = p;
+		while (content != contentEnd && isBlank(*content))
+			content++;
+		if (!visit(objLineType(content, contentEnd), content, contentEnd, line))
+			return;
+		p = (next == NULL) ? chunk.end : next + 1;
+		line++;
+	}
+}
+
+struct ObjCounter
+{
+	ObjChunk& chunk;
+	ObjCounter(ObjChunk& chunk) : chunk(chunk) {}
+	bool operator()(ObjLineType type, const char*, const char*, int)
+	{
+		chunk.numLines++;
+		if (type != OBJ_OTHER)
+			chunk.count[type]++;
+		return true;
+	}
+};
+
+struct ObjParser
+{
+	ObjChunk& chunk;
+	Wavefront_obj& obj;
+	int next[4];
+	int numTotal[3];
+
+	ObjParser(ObjChunk& chunk, Wavefront_obj& obj) : chunk(chunk), obj(obj)
+	{
+		for (int k = 0; k < 4; ++k)
+			next[k] = chunk.offset[k];
+		numTotal[0] = (int)obj.m_points.size();
+		numTotal[1] = (int)obj.m_textureCoordinates.size();
+		numTotal[2] = (int)obj.m_normals.size();
+	}
+
+	bool operator()(ObjLineType type, const char* p, const char* end, int line)
+	{
+		std::string error;
+		if (type == OBJ_FACE)
+		{
+			//the face is checked against the elements defined so far, which makes relative indices work
+			int numBefore[3] = { next[OBJ_POINT], next[OBJ_TEXTURE], next[OBJ_NORMAL] };
+			if (!parseFace(p + 2, end, numBefore, numTotal, obj.m_faces[next[OBJ_FACE]++], error))
+			{
+				chunk.error = lineError(line, error);
+				return false;
+			}
+		}
+		else if (type != OBJ_OTHER)
+		{
+			Wavefront_obj::Vector& v = (type == OBJ_POINT) ? obj.m_points[next[type]] : (type == OBJ_TEXTURE) ? obj.m_textureCoordinates[next[type]] : obj.m_normals[next[type]];
+			next[type]++;
+			p += (type == OBJ_POINT) ? 2 : 3;
+			//a texture coordinate may have 2 values. values after the 3rd (a weight or a color) are ignored.
+			int numValues = 0;
+			while (numValues < 3 && parseDouble(p, end, v[numValues]))
+				numValues++;
+			if (numValues < ((type == OBJ_TEXTURE) ? 2 : 3))
+			{
+				chunk.error = lineError(line, "bad number");
+				return false;
+			}
+		}
+		return true;
+	}
+};
+
+bool Wavefront_obj::load(const std::string& filename, std::string& error)
+{
+	m_points.clear();
+	m_normals.clear();
+	m_textureCoordinates.clear();
+	m_faces.clear();
+
+	MappedFile file;
+	if (!file.open(filename, error))
+		return false;
+	const char* data = file.data();
+	const char* dataEnd = data + file.size();
+
+	//about 4 chunks per thread for the dynamic schedule, but at least 64 KB each. the chunks end after a newline.
+	int numThreads = 1;
+#ifdef _OPENMP
+	numThreads = omp_get_max_threads();
+#endif
+	const size_t chunkSize = (std::max)((size_t)1 << 16, file.size() / (4 * (size_t)numThreads));
+	std::vector<ObjChunk> chunks;
+	for (const char* p = data; p != dataEnd; )
+	{
+		ObjChunk chunk;
+		chunk.begin = p;
+		chunk.end = ((size_t)(dataEnd - p) <= chunkSize) ? dataEnd : p + chunkSize;
+		if (chunk.end != dataEnd)
+		{
+			const char* newline = (const char*)memchr(chunk.end, '\n', dataEnd - chunk.end);
+			chunk.end = (newline == NULL) ? dataEnd : newline + 1;
+		}
+		chunk.firstLine = 1;
+		chunk.numLines = 0;
+		for (int k = 0; k < 4; ++k)
+			chunk.count[k] = chunk.offset[k] = 0;
+		chunks.push_back(chunk);
+		p = chunk.end;
+	}
+	int numChunks = (int)chunks.size();
+
+#pragma omp parallel for schedule(dynamic)
+	for (int c = 0; c < numChunks; ++c)
+	{
+		ObjCounter counter(chunks[c]);
+		forEachLine(chunks[c], counter);
+	}
+
+	int total[4] = { 0, 0, 0, 0 }, line = 1;
+	for (int c = 0; c < numChunks; ++c)
+	{
+		chunks[c].firstLine = line;
+		line += chunks[c].numLines;
+		for (int k = 0; k < 4; ++k)
+		{
+			chunks[c].offset[k] = total[k];
+			total[k] += chunks[c].count[k];
+		}
+	}
+	m_points.resize(total[OBJ_POINT]);
+	m_textureCoordinates.resize(total[OBJ_TEXTURE]);
+	m_normals.resize(total[OBJ_NORMAL]);
+	m_faces.resize(total[OBJ_FACE]);
+
+#pragma omp parallel for schedule(dynamic)
+	for (int c = 0; c < numChunks; ++c)
+	{
+		ObjParser parser(chunks[c], *this);
+		forEachLine(chunks[c], parser);
+	}
+
+	for (int c = 0; c < numChunks; ++c)
+	{
+		if (!chunks[c].error.empty())
+		{
+			error = filename + ", " + chunks[c].error;
+			return false;
+		}
+	}
+	if (m_faces.size() < 1 || m_points.size() < 3)
+	{
+		error = filename + " has no triangles";
+		return false;
+	}
+	return true;
+}
@@ -1,8 +1,11 @@
+#pragma once
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////
 // This simple obj parser assumes  that all polygons in the mesh are triangles and will fail otherwise //
 /////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 #include <vector>
+#include <string>
 
 
 struct Wavefront_obj
@@ -31,7 +34,13 @@ struct Wavefront_obj
 	std::vector<Vector> m_textureCoordinates;
 	std::vector<Face> m_faces;
 
-	bool load_file(std::wstring filename);
+#ifdef _WIN32
+	bool load_file(std::wstring filename); //legacy, MSVC only
+#endif
+
+	//portable loader: maps the file and parses newline aligned chunks of it in parallel, into arrays sized by a
+	//counting pass. relative (negative) indices are resolved. on failure returns false and sets error, with the line.
+	bool load(const std::string& filename, std::string& error);
 
 };
 